@@ -0,0 +1,434 @@
+// Headless end-to-end playback benchmark. Generates a synthetic video, as
+// MJPG with cv::VideoWriter or as uncompressed Y4M, plays it through
+// MediaToAscii and the AsciiFrame element
+// into an ftxui::Screen, writes every frame to a sink, and prints one JSON
+// object with the results. Needs no TTY. Debug builds also report the heap
+// allocations per frame of replaying converted frames. The changed cells
+// and the bytes a change-only redraw would send per frame show the effect
+// of --stabilize, best on a video with --noise.
+//
+// Usage: playback_bench [--frames=N] [--width=W] [--height=H] [--fps=F]
+//                       [--size=S] [--sink=null|pty] [--monochrome=0|1]
+//                       [--container=avi|y4m] [--video=PATH]
+//                       [--noise=N] [--stabilize=N]
+
+// local
+#include "allocation_counter.hpp"
+#include "frame_renderer.hpp"
+#include "media_to_ascii.hpp"
+#include "shared_pool.hpp"
+#include "temporal_filter.hpp"
+
+// libs
+// FTXUI
+#include <ftxui/dom/node.hpp>
+#include <ftxui/screen/screen.hpp>
+// OpenCV
+#include <opencv2/opencv.hpp>
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__) || defined(__APPLE__)
+#define TERMINAL_ANIMATION_POSIX 1
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace terminal_animation {
+
+namespace {
+
+struct BenchOptions {
+  std::uint32_t frames = 300;
+  std::uint32_t width = 640;
+  std::uint32_t height = 360;
+  std::uint32_t fps = 30;
+  std::uint32_t size = 60;
+  std::string sink = "null";
+  bool monochrome = false;
+  // Container of the generated video: "avi" is decoded by FFmpeg, "y4m" is
+  // read by RawVideoReader.
+  std::string container = "avi";
+  // Plays this file instead of a generated one.
+  std::filesystem::path video;
+  // Uniform noise of up to +/-noise added to every generated pixel, like a
+  // sensor's or a lossy encoder's.
+  std::uint32_t noise = 0;
+  // Threshold of the temporal filter; 0 turns it off.
+  std::uint32_t stabilize = 0;
+};
+
+// Parses --key=value arguments. Returns nullopt on an unknown key.
+std::optional<BenchOptions> ParseOptions(int argc, char **argv) {
+  std::map<std::string, std::string> values;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    const auto equals = arg.find('=');
+    if (!arg.starts_with("--") || equals == std::string::npos) {
+      return std::nullopt;
+    }
+    values[arg.substr(2, equals - 2)] = arg.substr(equals + 1);
+  }
+
+  BenchOptions options;
+  const auto number = [](const std::string &value) {
+    return static_cast<std::uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+  };
+  for (const auto &[key, value] : values) {
+    if (key == "frames") {
+      options.frames = std::max(1U, number(value));
+    } else if (key == "width") {
+      options.width = std::max(16U, number(value));
+    } else if (key == "height") {
+      options.height = std::max(16U, number(value));
+    } else if (key == "fps") {
+      options.fps = std::max(1U, number(value));
+    } else if (key == "size") {
+      options.size = std::max(1U, number(value));
+    } else if (key == "sink") {
+      options.sink = value;
+    } else if (key == "monochrome") {
+      options.monochrome = value == "1";
+    } else if (key == "container") {
+      options.container = value;
+    } else if (key == "video") {
+      options.video = value;
+    } else if (key == "noise") {
+      options.noise = std::min(255U, number(value));
+    } else if (key == "stabilize") {
+      options.stabilize = std::min(255U, number(value));
+    } else {
+      return std::nullopt;
+    }
+  }
+  if ((options.sink != "null" && options.sink != "pty") ||
+      (options.container != "avi" && options.container != "y4m")) {
+    return std::nullopt;
+  }
+  return options;
+}
+
+// Draws frame index of moving gradients and a bouncing disc, so
+// consecutive frames differ everywhere like real footage, with up to
+// +/-noise of noise on every channel.
+void DrawSyntheticFrame(std::uint32_t index, std::uint32_t noise,
+                        cv::Mat &frame) {
+  for (int y = 0; y < frame.rows; ++y) {
+    auto *row = frame.ptr<cv::Vec3b>(y);
+    for (int x = 0; x < frame.cols; ++x) {
+      const auto shift = static_cast<int>(index) * 4;
+      row[x] = cv::Vec3b(static_cast<std::uint8_t>(x + shift),
+                         static_cast<std::uint8_t>(y + shift / 2),
+                         static_cast<std::uint8_t>((x + y) / 2 - shift));
+    }
+  }
+  const int radius = std::min(frame.cols, frame.rows) / 6;
+  const int travel_x = std::max(1, frame.cols - 2 * radius);
+  const int travel_y = std::max(1, frame.rows - 2 * radius);
+  const auto step = static_cast<int>(index) * 7;
+  const cv::Point center(
+      radius + std::abs(step % (2 * travel_x) - travel_x),
+      radius + std::abs((step / 2) % (2 * travel_y) - travel_y));
+  cv::circle(frame, center, radius, cv::Scalar(255, 255, 255), cv::FILLED);
+  if (noise > 0) {
+    thread_local cv::Mat grain;
+    grain.create(frame.size(), CV_16SC3);
+    const auto amplitude = static_cast<double>(noise);
+    cv::randu(grain, cv::Scalar::all(-amplitude),
+              cv::Scalar::all(amplitude + 1));
+    cv::Mat noisy;
+    frame.convertTo(noisy, CV_16SC3);
+    noisy += grain;
+    noisy.convertTo(frame, CV_8UC3);
+  }
+}
+
+// Writes the synthetic video as MJPG in an AVI container, or as 4:2:0 Y4M.
+// Returns false on failure.
+bool WriteSyntheticVideo(const std::filesystem::path &file,
+                         const BenchOptions &options) {
+  // 4:2:0 Y4M needs even dimensions.
+  const bool is_y4m = options.container == "y4m";
+  const std::uint32_t mask = is_y4m ? ~1U : ~0U;
+  const cv::Size frame_size(static_cast<int>(options.width & mask),
+                            static_cast<int>(options.height & mask));
+  cv::Mat frame(frame_size, CV_8UC3);
+
+  if (is_y4m) {
+    std::ofstream out(file, std::ios::binary);
+    out << "YUV4MPEG2 W" << frame_size.width << " H" << frame_size.height
+        << " F" << options.fps << ":1 Ip A1:1 C420jpeg\n";
+    cv::Mat yuv;
+    for (std::uint32_t index = 0; index < options.frames; ++index) {
+      DrawSyntheticFrame(index, options.noise, frame);
+      cv::cvtColor(frame, yuv, cv::COLOR_BGR2YUV_I420);
+      out << "FRAME\n";
+      out.write(reinterpret_cast<const char *>(yuv.data),
+                static_cast<std::streamsize>(yuv.total()));
+    }
+    return static_cast<bool>(out);
+  }
+
+  cv::VideoWriter writer(file.string(),
+                         cv::VideoWriter::fourcc('M', 'J', 'P', 'G'),
+                         options.fps, frame_size);
+  if (!writer.isOpened()) {
+    return false;
+  }
+  for (std::uint32_t index = 0; index < options.frames; ++index) {
+    DrawSyntheticFrame(index, options.noise, frame);
+    writer.write(frame);
+  }
+  return true;
+}
+
+// Destination of the rendered terminal output.
+class Sink {
+public:
+  // Opens a "null" or "pty" sink. Returns false if the sink is not
+  // available on this platform.
+  bool Open(const std::string &kind) {
+    if (kind == "null") {
+      return true;
+    }
+#ifdef TERMINAL_ANIMATION_POSIX
+    // A pseudo-terminal pays for the kernel's tty layer like a real
+    // terminal. A thread drains the master side so writes never block.
+    master_fd_ = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master_fd_ < 0 || grantpt(master_fd_) != 0 ||
+        unlockpt(master_fd_) != 0) {
+      return false;
+    }
+    const char *slave_name = ptsname(master_fd_);
+    if (slave_name == nullptr) {
+      return false;
+    }
+    slave_fd_ = open(slave_name, O_WRONLY | O_NOCTTY);
+    if (slave_fd_ < 0) {
+      return false;
+    }
+    drain_ = std::thread([fd = master_fd_] {
+      std::vector<char> buffer(1 << 16);
+      while (read(fd, buffer.data(), buffer.size()) > 0) {
+      }
+    });
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  ~Sink() {
+#ifdef TERMINAL_ANIMATION_POSIX
+    if (slave_fd_ >= 0) {
+      // The drain thread's read() fails once the slave side is closed.
+      close(slave_fd_);
+    }
+    if (drain_.joinable()) {
+      drain_.join();
+    }
+    if (master_fd_ >= 0) {
+      close(master_fd_);
+    }
+#endif
+  }
+
+  void Write([[maybe_unused]] const std::string &data) {
+#ifdef TERMINAL_ANIMATION_POSIX
+    std::size_t written = 0;
+    while (slave_fd_ >= 0 && written < data.size()) {
+      const auto result =
+          write(slave_fd_, data.data() + written, data.size() - written);
+      if (result <= 0) {
+        break;
+      }
+      written += static_cast<std::size_t>(result);
+    }
+#endif
+  }
+
+private:
+  int master_fd_ = -1;
+  int slave_fd_ = -1;
+  std::thread drain_;
+};
+
+// Peak resident set size of this process in KiB, or 0 if unknown.
+long PeakRssKib() {
+#ifdef TERMINAL_ANIMATION_POSIX
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024;
+#else
+  return usage.ru_maxrss;
+#endif
+#else
+  return 0;
+#endif
+}
+
+// Returns the given fraction's percentile of sorted values.
+double Percentile(const std::vector<double> &sorted, double fraction) {
+  if (sorted.empty()) {
+    return 0.0;
+  }
+  const auto index = static_cast<std::size_t>(
+      fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+  return sorted[std::min(index, sorted.size() - 1)];
+}
+
+int RunBenchmark(const BenchOptions &options) {
+  std::filesystem::path video = options.video;
+  if (video.empty()) {
+    video = std::filesystem::temp_directory_path() /
+            ("terminal_animation_bench_" + std::to_string(options.width) +
+             "x" + std::to_string(options.height) + "_" +
+             std::to_string(options.frames) + "_noise" +
+             std::to_string(options.noise) + "." + options.container);
+    if (!WriteSyntheticVideo(video, options)) {
+      std::cerr << "Could not write " << video << '\n';
+      return 1;
+    }
+  }
+
+  Sink sink;
+  if (!sink.Open(options.sink)) {
+    std::cerr << "Sink " << options.sink << " is not available\n";
+    return 1;
+  }
+
+  using Clock = std::chrono::steady_clock;
+  const auto ms_since = [](Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start)
+        .count();
+  };
+
+  SetStabilizeThreshold(static_cast<std::uint8_t>(options.stabilize));
+  MediaToAscii media;
+  media.SetSize(options.size);
+  media.SetMonochrome(options.monochrome);
+  const auto start = Clock::now();
+  if (!media.OpenFile(video)) {
+    std::cerr << "Could not open " << video << '\n';
+    return 1;
+  }
+  const double first_frame_ms = ms_since(start);
+
+  const MediaToAscii::CharsAndColors first = media.GetCharsAndColors(0);
+  const auto columns = static_cast<int>(first.columns);
+  const auto rows = static_cast<int>(first.rows);
+  auto screen = ftxui::Screen::Create(ftxui::Dimension::Fixed(columns),
+                                      ftxui::Dimension::Fixed(rows));
+
+  // Published like AnimationUI::ShowFrame() does.
+  SharedPool<MediaToAscii::CharsAndColors> frame_pool;
+  std::shared_ptr<const MediaToAscii::CharsAndColors> shown;
+  const auto publish = [&](std::uint32_t index) {
+    auto frame = frame_pool.Acquire();
+    media.GetCharsAndColors(index, *frame);
+    shown = std::move(frame);
+  };
+
+  std::vector<double> latencies_ms;
+  std::uint64_t total_bytes = 0;
+  // What changed since the previous frame, and what redrawing only that
+  // would send.
+  MediaToAscii::CharsAndColors previous;
+  std::uint64_t changed_cells = 0;
+  std::uint64_t delta_bytes = 0;
+  const std::uint32_t total = std::max(1U, media.GetTotalFrameCount());
+  for (std::uint32_t index = 0; index < total; ++index) {
+    const auto frame_start = Clock::now();
+    // OpenFile() already converted frame 0.
+    if (index > 0 && media.RenderVideoFrames(1) == 0) {
+      break;
+    }
+    publish(index);
+    auto element = AsciiFrame(shown);
+    ftxui::Render(screen, element);
+    const std::string output = screen.ResetPosition() + screen.ToString();
+    sink.Write(output);
+    total_bytes += output.size();
+    latencies_ms.push_back(ms_since(frame_start));
+    changed_cells += CountChangedCells(previous, *shown);
+    delta_bytes += EstimateDeltaBytes(previous, *shown);
+    previous = *shown;
+  }
+  const double total_ms = ms_since(start);
+
+  // Replay the converted frames like looping playback does. The first pass
+  // allocated each frame's storage; replaying should not allocate at all.
+  const auto frames = latencies_ms.size();
+  const std::uint64_t allocations_before = ThreadAllocationCount();
+  for (std::uint32_t index = 0; index < frames; ++index) {
+    publish(index);
+  }
+  const auto replay_allocations =
+      static_cast<double>(ThreadAllocationCount() - allocations_before) /
+      static_cast<double>(std::max<std::size_t>(frames, 1));
+
+  std::sort(latencies_ms.begin(), latencies_ms.end());
+  const auto per_frame = [frames](std::uint64_t total) {
+    return static_cast<double>(total) /
+           static_cast<double>(std::max<std::size_t>(frames, 1));
+  };
+  std::printf("{\"video\": \"%s\", \"sink\": \"%s\", \"size\": %u, "
+              "\"monochrome\": %s, \"stabilize\": %u, \"columns\": %d, "
+              "\"rows\": %d, \"frames\": %zu, \"fps\": %.1f, "
+              "\"bytes_per_frame\": %.0f, "
+              "\"changed_cells_per_frame\": %.0f, "
+              "\"delta_bytes_per_frame\": %.0f, "
+              "\"first_frame_ms\": %.2f, \"latency_p50_ms\": %.3f, "
+              "\"latency_p90_ms\": %.3f, \"latency_p99_ms\": %.3f, "
+              "\"latency_max_ms\": %.3f, \"peak_rss_kib\": %ld, "
+              "\"replay_allocations_per_frame\": %s}\n",
+              video.string().c_str(), options.sink.c_str(), options.size,
+              options.monochrome ? "true" : "false", options.stabilize,
+              columns, rows, frames,
+              static_cast<double>(frames) * 1000.0 / std::max(total_ms, 1e-3),
+              per_frame(total_bytes), per_frame(changed_cells),
+              per_frame(delta_bytes),
+              first_frame_ms, Percentile(latencies_ms, 0.50),
+              Percentile(latencies_ms, 0.90), Percentile(latencies_ms, 0.99),
+              latencies_ms.empty() ? 0.0 : latencies_ms.back(), PeakRssKib(),
+              kCountsAllocations ? std::to_string(replay_allocations).c_str()
+                                 : "null");
+
+  if (options.video.empty()) {
+    std::filesystem::remove(video);
+  }
+  return frames > 0 ? 0 : 1;
+}
+
+} // namespace
+
+} // namespace terminal_animation
+
+int main(int argc, char **argv) {
+  const auto options = terminal_animation::ParseOptions(argc, argv);
+  if (!options.has_value()) {
+    std::cerr << "Usage: playback_bench [--frames=N] [--width=W] "
+                 "[--height=H] [--fps=F] [--size=S] [--sink=null|pty] "
+                 "[--monochrome=0|1] [--container=avi|y4m] "
+                 "[--video=PATH] [--noise=N] [--stabilize=N]\n";
+    return 2;
+  }
+  return terminal_animation::RunBenchmark(*options);
+}
@@ -0,0 +1,46 @@
+// header
+#include "allocation_counter.hpp"
+
+// std
+#include <cstdlib>
+#include <new>
+
+namespace terminal_animation {
+
+namespace {
+
+// Per thread, so counting needs no synchronization and one thread's
+// measurement is not disturbed by the others.
+thread_local std::uint64_t allocation_count = 0;
+
+} // namespace
+
+std::uint64_t ThreadAllocationCount() { return allocation_count; }
+
+} // namespace terminal_animation
+
+#ifndef NDEBUG
+
+// The array and nothrow forms call these by default, so replacing the
+// plain forms counts them too.
+void *operator new(std::size_t size) {
+  ++terminal_animation::allocation_count;
+  while (true) {
+    if (void *memory = std::malloc(size == 0 ? 1 : size)) {
+      return memory;
+    }
+    std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr) {
+      throw std::bad_alloc();
+    }
+    handler();
+  }
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+
+void operator delete(void *memory, std::size_t) noexcept {
+  std::free(memory);
+}
+
+#endif
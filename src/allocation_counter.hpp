@@ -0,0 +1,21 @@
+#pragma once
+
+// std
+#include <cstdint>
+
+namespace terminal_animation {
+
+// Debug builds (NDEBUG not defined) that link allocation_counter.cpp count
+// every call of the global operator new, to check that hot paths do not
+// allocate. Release builds count nothing.
+#ifdef NDEBUG
+inline constexpr bool kCountsAllocations = false;
+#else
+inline constexpr bool kCountsAllocations = true;
+#endif
+
+// Number of operator new calls made by the calling thread so far. Always 0
+// unless kCountsAllocations.
+std::uint64_t ThreadAllocationCount();
+
+} // namespace terminal_animation
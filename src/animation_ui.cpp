@@ -2,150 +2,559 @@
 #include "animation_ui.hpp"
 
 // local
+#include "directory_menu.hpp"
+#include "event_log.hpp"
+#include "frame_renderer.hpp"
 #include "slider_with_callback.hpp"
 
+// libs
+// FTXUI
+#include <ftxui/component/event.hpp>
+#include <ftxui/component/mouse.hpp>
+#include <ftxui/dom/node.hpp>
+#include <ftxui/screen/terminal.hpp>
+
 // std
+#include <algorithm>
 #include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
 #include <memory>
+#include <utility>
 
 namespace terminal_animation {
 
-AnimationUI::AnimationUI() {
-  dir_contents_ = GetDirContents(current_dir_);
-  printable_dir_contents_ = FormatDirContents(dir_contents_);
-  explorer_window_height_ = static_cast<int>(dir_contents_.size()) + 6;
+namespace {
+
+RecordedEvent ToRecordedEvent(ftxui::Event event,
+                              std::chrono::microseconds time) {
+  RecordedEvent recorded{.time = time,
+                         .kind = RecordedEvent::Kind::kSpecial,
+                         .input = event.input(),
+                         .mouse = {}};
+  if (event.is_character()) {
+    recorded.kind = RecordedEvent::Kind::kCharacter;
+  } else if (event.is_mouse()) {
+    const ftxui::Mouse &mouse = event.mouse();
+    recorded.kind = RecordedEvent::Kind::kMouse;
+    recorded.mouse = {.button = static_cast<int>(mouse.button),
+                      .motion = static_cast<int>(mouse.motion),
+                      .shift = mouse.shift,
+                      .meta = mouse.meta,
+                      .control = mouse.control,
+                      .x = mouse.x,
+                      .y = mouse.y};
+  }
+  return recorded;
+}
+
+ftxui::Event ToFtxuiEvent(const RecordedEvent &recorded) {
+  switch (recorded.kind) {
+  case RecordedEvent::Kind::kCharacter:
+    return ftxui::Event::Character(recorded.input);
+  case RecordedEvent::Kind::kMouse: {
+    ftxui::Mouse mouse;
+    mouse.button = static_cast<ftxui::Mouse::Button>(recorded.mouse.button);
+    mouse.motion = static_cast<ftxui::Mouse::Motion>(recorded.mouse.motion);
+    mouse.shift = recorded.mouse.shift;
+    mouse.meta = recorded.mouse.meta;
+    mouse.control = recorded.mouse.control;
+    mouse.x = recorded.mouse.x;
+    mouse.y = recorded.mouse.y;
+    return ftxui::Event::Mouse(recorded.input, mouse);
+  }
+  case RecordedEvent::Kind::kSpecial:
+    break;
+  }
+  return ftxui::Event::Special(recorded.input);
+}
+
+} // namespace
+
+AnimationUI::AnimationUI(TaskScheduler::Options options,
+                         std::filesystem::path thumbnail_directory)
+    : task_scheduler_(options),
+      thumbnail_cache_(std::move(thumbnail_directory),
+                       [this] { RequestRedraw(); }, task_scheduler_) {
+  ScanCurrentDirectory();
 
   screen_.SetCursor(ftxui::Screen::Cursor{
       .x = 0, .y = 0, .shape = ftxui::Screen::Cursor::Hidden});
 }
 
 void AnimationUI::Run() {
-  thread_canvas_update_ = std::thread(&AnimationUI::UpdateCanvasLoop, this);
+  NotifyPlaybackChanged();
 
-  auto main_component = ftxui::Container::Stacked({
-      ftxui::Maybe(CreateOptionsWindow() | ftxui::align_right, &show_options_),
-      CreateFileExplorer() | ftxui::align_right | ftxui::vcenter,
-      ftxui::Maybe(CreateShortcutsWindow(), &show_shortcuts_),
-      CreateRenderer(),
-  });
+  std::ofstream record;
+  auto main_component = CreateMainComponent();
+  if (!record_file_.empty()) {
+    record.open(record_file_);
+    if (!record) {
+      logger_->error("[AnimationUI::Run] Could not record events to {}",
+                     record_file_.string());
+    } else {
+      const ftxui::Dimensions terminal = GetTerminalSize();
+      record << FormatEventLogHeader(
+                    static_cast<std::uint32_t>(std::max(1, terminal.dimx)),
+                    static_cast<std::uint32_t>(std::max(1, terminal.dimy)))
+             << '\n';
+      // Outermost, so it sees every event before any component handles it.
+      const auto start = std::chrono::steady_clock::now();
+      main_component |= ftxui::CatchEvent([&record,
+                                           start](ftxui::Event event) {
+        if (event != ftxui::Event::Custom) {
+          const auto time =
+              std::chrono::duration_cast<std::chrono::microseconds>(
+                  std::chrono::steady_clock::now() - start);
+          record << FormatRecordedEvent(ToRecordedEvent(event, time)) << '\n';
+        }
+        return false;
+      });
+    }
+  }
 
-  main_component |= CreateEventHandler();
+  // FTXUI draws to std::cout on this thread. The writer thread takes the
+  // output instead, so a slow terminal cannot stall input and playback.
+  std::streambuf *const stdout_buffer = std::cout.rdbuf(&terminal_writer_);
   screen_.Loop(main_component);
+  terminal_writer_.Drain();
+  std::cout.rdbuf(stdout_buffer);
+
+  const TerminalWriter::Stats output = terminal_writer_.GetStats();
+  logger_->info("[AnimationUI::Run] Wrote {} bytes to the terminal in {} "
+                "writes, {} ms in total, longest {} ms; {} frames replaced",
+                output.bytes_written, output.writes,
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    output.write_time)
+                    .count(),
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    output.longest_write)
+                    .count(),
+                output.frames_replaced);
+
+  Shutdown();
+}
+
+bool AnimationUI::Replay(const std::filesystem::path &file,
+                         std::ostream &report) {
+  std::ifstream in(file);
+  const std::optional<EventLog> log = ReadEventLog(in);
+  if (!log.has_value()) {
+    logger_->error("[AnimationUI::Replay] Could not read events from {}",
+                   file.string());
+    return false;
+  }
+
+  headless_size_ = {static_cast<int>(log->columns),
+                    static_cast<int>(log->rows)};
+  is_headless_.store(true);
+  NotifyPlaybackChanged();
+  auto main_component = CreateMainComponent();
+
+  // Draws like ScreenInteractive does, into a screen no terminal sees.
+  ftxui::Screen screen(headless_size_.dimx, headless_size_.dimy);
+  std::uint64_t frame_bytes = 0;
+  std::uint64_t frame_count = 0;
+  const auto draw = [&] {
+    const auto draw_start = std::chrono::steady_clock::now();
+    ftxui::Render(screen, main_component->Render());
+    frame_bytes += screen.ToString().size();
+    screen.Clear();
+    ++frame_count;
+    return std::chrono::steady_clock::now() - draw_start;
+  };
+
+  std::vector<std::chrono::nanoseconds> handle_times;
+  std::vector<std::chrono::nanoseconds> event_frame_times;
+  std::vector<std::chrono::nanoseconds> idle_frame_times;
+  idle_frame_times.push_back(draw());
+
+  const auto start = std::chrono::steady_clock::now();
+  char line[256];
+  for (std::size_t index = 0; index < log->events.size(); ++index) {
+    const RecordedEvent &recorded = log->events[index];
+    const auto due = start + recorded.time;
+
+    // Until the event is due, run what the FTXUI loop would have: posted
+    // tasks, and a redraw whenever one is requested.
+    bool should_exit = false;
+    while (!should_exit) {
+      std::vector<std::function<void()>> tasks;
+      bool redraw = false;
+      {
+        std::unique_lock<std::mutex> lock(mutex_headless_);
+        cv_headless_.wait_until(lock, due, [this] {
+          return !headless_tasks_.empty() || headless_redraw_ ||
+                 headless_exit_;
+        });
+        tasks.swap(headless_tasks_);
+        redraw = std::exchange(headless_redraw_, false);
+        should_exit = headless_exit_;
+      }
+      for (const auto &task : tasks) {
+        task();
+      }
+      if (redraw) {
+        idle_frame_times.push_back(draw());
+      }
+      if (std::chrono::steady_clock::now() >= due) {
+        break;
+      }
+    }
+    if (should_exit) {
+      break;
+    }
+
+    ftxui::Event event = ToFtxuiEvent(recorded);
+    const auto handle_start = std::chrono::steady_clock::now();
+    main_component->OnEvent(event);
+    const auto handle_time = std::chrono::steady_clock::now() - handle_start;
+    const auto frame_time = draw();
+    handle_times.push_back(handle_time);
+    event_frame_times.push_back(frame_time);
+
+    std::snprintf(
+        line, sizeof(line),
+        "{\"event\": %zu, \"at_ms\": %.1f, \"recorded\": \"%s\", "
+        "\"handle_us\": %.1f, \"frame_us\": %.1f}\n",
+        index,
+        std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start)
+            .count(),
+        FormatRecordedEvent(recorded).substr(0, 120).c_str(),
+        std::chrono::duration<double, std::micro>(handle_time).count(),
+        std::chrono::duration<double, std::micro>(frame_time).count());
+    report << line;
+
+    std::lock_guard<std::mutex> lock(mutex_headless_);
+    if (headless_exit_) {
+      break;
+    }
+  }
+
+  const LatencySummary handling = SummarizeLatencies(handle_times);
+  const LatencySummary event_frames = SummarizeLatencies(event_frame_times);
+  const LatencySummary idle_frames = SummarizeLatencies(idle_frame_times);
+  std::snprintf(
+      line, sizeof(line),
+      "{\"events\": %zu, \"frames\": %llu, \"bytes_per_frame\": %.0f, "
+      "\"handle_p50_us\": %.1f, \"handle_p95_us\": %.1f, "
+      "\"handle_max_us\": %.1f, ",
+      handle_times.size(), static_cast<unsigned long long>(frame_count),
+      static_cast<double>(frame_bytes) /
+          static_cast<double>(std::max<std::uint64_t>(frame_count, 1)),
+      handling.p50_us, handling.p95_us, handling.max_us);
+  report << line;
+  std::snprintf(
+      line, sizeof(line),
+      "\"event_frame_p50_us\": %.1f, \"event_frame_p95_us\": %.1f, "
+      "\"event_frame_max_us\": %.1f, \"idle_frame_p50_us\": %.1f, "
+      "\"idle_frame_p95_us\": %.1f, \"idle_frame_max_us\": %.1f}\n",
+      event_frames.p50_us, event_frames.p95_us, event_frames.max_us,
+      idle_frames.p50_us, idle_frames.p95_us, idle_frames.max_us);
+  report << line;
 
-  media_to_ascii_->SetContinueRendering(false);
+  Shutdown();
+  return true;
+}
+
+void AnimationUI::Shutdown() {
   should_run_.store(false);
+  NotifyPlaybackChanged();
+  fit_task_.Cancel();
+  {
+    std::lock_guard<std::mutex> lock(mutex_pending_open_);
+    failed_redraw_task_.Cancel();
+  }
 
-  if (thread_render_video_.joinable()) {
-    thread_render_video_.join();
+  {
+    std::lock_guard<std::mutex> lock(mutex_prefetch_);
+    pending_prefetch_.reset();
+    ++prefetch_generation_;
+    for (const auto &media : active_prefetches_) {
+      media->SetContinueRendering(false);
+    }
+  }
+  cv_prefetch_.notify_all();
+
+  TaskHandle open_task;
+  {
+    std::lock_guard<std::mutex> lock(mutex_pending_open_);
+    pending_open_file_.reset();
+    open_task = open_task_;
+  }
+  open_task.Wait();
+  {
+    std::unique_lock<std::mutex> lock(mutex_prefetch_);
+    cv_prefetch_.wait(lock, [this] { return prefetch_tasks_ == 0; });
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_video_rendering_);
+    StopVideoRendering();
   }
-  if (thread_canvas_update_.joinable()) {
-    thread_canvas_update_.join();
+  {
+    std::unique_lock<std::mutex> lock(mutex_playback_);
+    cv_playback_.wait(lock, [this] { return !is_updating_canvas_; });
   }
 }
 
+void AnimationUI::RequestRedraw() {
+  if (is_headless_.load()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_headless_);
+      headless_redraw_ = true;
+    }
+    cv_headless_.notify_one();
+    return;
+  }
+  screen_.PostEvent(ftxui::Event::Custom);
+}
+
+void AnimationUI::PostTask(std::function<void()> task) {
+  if (is_headless_.load()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_headless_);
+      headless_tasks_.push_back(std::move(task));
+    }
+    cv_headless_.notify_one();
+    return;
+  }
+  screen_.Post(std::move(task));
+}
+
+void AnimationUI::Exit() {
+  if (is_headless_.load()) {
+    std::lock_guard<std::mutex> lock(mutex_headless_);
+    headless_exit_ = true;
+    return;
+  }
+  screen_.ExitLoopClosure()();
+}
+
+ftxui::Dimensions AnimationUI::GetTerminalSize() const {
+  if (is_headless_.load()) {
+    return headless_size_;
+  }
+  return ftxui::Terminal::Size();
+}
+
+ftxui::Component AnimationUI::CreateMainComponent() {
+  auto main_component = ftxui::Container::Stacked({
+      ftxui::Maybe(CreateOptionsWindow() | ftxui::align_right, &show_options_),
+      CreateFileExplorer() | ftxui::align_right | ftxui::vcenter,
+      ftxui::Maybe(CreateShortcutsWindow(), &show_shortcuts_),
+      CreateRenderer(),
+  });
+  main_component |= CreateEventHandler();
+  return main_component;
+}
+
 ftxui::Component AnimationUI::CreateRenderer() {
-  return ftxui::Renderer([this] { return CreateCanvas(); });
+  return ftxui::Renderer([this] {
+    // The whole screen is drawn and flushed after this, so the output until
+    // the flush is one frame.
+    const ftxui::Dimensions terminal = GetTerminalSize();
+    terminal_writer_.BeginFrame(
+        static_cast<std::uint32_t>(std::max(0, terminal.dimx)),
+        static_cast<std::uint32_t>(std::max(0, terminal.dimy)));
+    WatchTerminalSize();
+    if (show_mosaic_.load()) {
+      return CreateMosaic();
+    }
+    std::string message;
+    {
+      std::lock_guard<std::mutex> lock(mutex_pending_open_);
+      if (is_loading_.load()) {
+        message = "Loading " + loading_file_.filename().string() + "...";
+      } else if (!failed_file_.empty() &&
+                 std::chrono::steady_clock::now() < failed_until_) {
+        message = "Could not open " + failed_file_.filename().string();
+      }
+    }
+    if (message.empty()) {
+      return CreateCanvas();
+    }
+    return ftxui::dbox({
+        CreateCanvas(),
+        ftxui::text(message) | ftxui::bold | ftxui::border | ftxui::center,
+    });
+  });
 }
 
 ftxui::Element AnimationUI::CreateCanvas() {
-  auto frame = ftxui::canvas([this](ftxui::Canvas &canvas) {
-    std::lock_guard<std::mutex> lock(mutex_canvas_data_);
+  std::lock_guard<std::mutex> lock(mutex_canvas_data_);
+  return AsciiFrame(canvas_data_);
+}
 
-    for (std::uint32_t i = 0; i < canvas_data_.chars.size(); i++) {
-      for (std::uint32_t j = 0; j < canvas_data_.chars[i].size(); j++) {
-        const std::uint8_t r = canvas_data_.colors[i][j][0];
-        const std::uint8_t g = canvas_data_.colors[i][j][1];
-        const std::uint8_t b = canvas_data_.colors[i][j][2];
+ftxui::Element AnimationUI::CreateMosaic() {
+  auto frames = mosaic_.GetFrames();
+  const GridShape grid = ComputeMosaicGrid(frames.size());
+  const auto terminal = GetTerminalSize();
+  const auto cell_columns = static_cast<std::uint32_t>(
+      std::max(1, terminal.dimx / static_cast<int>(grid.columns)));
+  const auto cell_rows = static_cast<std::uint32_t>(
+      std::max(1, terminal.dimy / static_cast<int>(grid.rows)));
+  mosaic_.Relayout(cell_columns, cell_rows);
 
-        canvas.DrawText(i * 2, j * 4,
-                        std::string(1, canvas_data_.chars[i][j]),
-                        ftxui::Color(r, g, b));
+  ftxui::Elements rows;
+  for (std::uint32_t row = 0; row < grid.rows; ++row) {
+    ftxui::Elements cells;
+    for (std::uint32_t column = 0; column < grid.columns; ++column) {
+      const std::size_t index = row * grid.columns + column;
+      if (index >= frames.size()) {
+        break;
       }
+
+      auto &pane = frames[index];
+      ftxui::Element cell;
+      if (pane.frame.has_value()) {
+        cell = AsciiFrame(std::make_shared<const MediaToAscii::CharsAndColors>(
+            std::move(*pane.frame)));
+      } else {
+        cell = ftxui::text((pane.failed ? "Could not open " : "Loading ") +
+                           pane.file.filename().string()) |
+               ftxui::center;
+      }
+      cells.push_back(
+          cell |
+          ftxui::size(ftxui::WIDTH, ftxui::EQUAL,
+                      static_cast<int>(cell_columns)) |
+          ftxui::size(ftxui::HEIGHT, ftxui::EQUAL,
+                      static_cast<int>(cell_rows)));
     }
-  });
-  return frame;
+    rows.push_back(ftxui::hbox(std::move(cells)));
+  }
+  return ftxui::vbox(std::move(rows));
 }
 
 ftxui::Component AnimationUI::CreateOptionsWindow() {
+  ftxui::CheckboxOption fit_option = ftxui::CheckboxOption::Simple();
+  fit_option.on_change = [this] {
+    auto_fit_.store(fit_to_terminal_);
+    ApplySize();
+  };
+
   return ftxui::Window({
       .inner = ftxui::Container::Vertical({
           ftxui::Slider(
               ftxui::text("Size") | ftxui::color(ftxui::Color::YellowLight),
               ftxui::SliderWithCallbackOption<std::int32_t>{
                   .callback =
-                      [this](std::int32_t size) {
-                        if (media_to_ascii_->GetSize() ==
-                            static_cast<std::uint32_t>(size)) {
+                      [this](std::int32_t value) {
+                        const auto size = static_cast<std::uint32_t>(value);
+                        // Also called with the initial value on creation.
+                        if (manual_size_.exchange(size) == size) {
                           return;
                         }
-
-                        media_to_ascii_->SetSize(
-                            static_cast<std::uint32_t>(size));
-
-                        if (media_to_ascii_->IsVideo()) {
-                          StartVideoRendering();
-                        } else {
-                          media_to_ascii_->CalculateCharsAndColors(0);
-                        }
-
-                        canvas_data_ =
-                            media_to_ascii_->GetCharsAndColors(0);
+                        // Picking a size by hand ends auto-fit.
+                        fit_to_terminal_ = false;
+                        auto_fit_.store(false);
+                        ApplySize();
                       },
-                  .value = 32,
+                  .value = static_cast<std::int32_t>(kDefaultSize),
                   .min = 1,
-                  .max = 128,
+                  .max = kMaxSize,
                   .increment = 1,
                   .color_active = ftxui::Color::YellowLight,
                   .color_inactive = ftxui::Color::YellowLight,
               }),
+          ftxui::Checkbox("Fit to terminal", &fit_to_terminal_, fit_option),
+          ftxui::Renderer([this] {
+            std::string size = "Size: " + std::to_string(size_.load());
+            if (fit_to_terminal_) {
+              size += " (fit)";
+            }
+            size += "  Zoom: " + std::to_string(GetZoomView().zoom) + "x";
+
+            std::string playback = "Speed: ";
+            playback += kPlaybackSpeeds[speed_index_.load()].label;
+            if (is_paused_.load()) {
+              playback += " (paused)";
+            }
+            if (monochrome_.load()) {
+              playback += "  Mono";
+            }
+
+            const TerminalWriter::Stats stats = terminal_writer_.GetStats();
+            const auto write_ms =
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    stats.write_time)
+                    .count();
+            // Bytes per millisecond spent writing is KB/s.
+            std::string output = "Output: ";
+            output += std::to_string(
+                write_ms > 0 ? stats.bytes_written /
+                                   static_cast<std::uint64_t>(write_ms)
+                             : 0);
+            output += " KB/s, " + std::to_string(stats.frames_replaced) +
+                      " dropped";
+            const std::string stall =
+                "Longest write: " +
+                std::to_string(
+                    std::chrono::duration_cast<std::chrono::milliseconds>(
+                        stats.longest_write)
+                        .count()) +
+                " ms";
+            return ftxui::vbox({ftxui::text(size), ftxui::text(playback),
+                                ftxui::text(output), ftxui::text(stall)}) |
+                   ftxui::color(ftxui::Color::YellowLight);
+          }),
           ftxui::Renderer([] { return ftxui::separator(); }),
           ftxui::Button("Hide", [this] { show_options_ = false; }) |
               ftxui::center | ftxui::color(ftxui::Color::Yellow),
       }),
       .title = "Options",
-      .width = 32,
-      .height = 8,
+      .width = 40,
+      .height = 13,
       .render = {},
   });
 }
 
 ftxui::Component AnimationUI::CreateFileExplorer() {
   auto on_select = [this] {
-    if (std::filesystem::is_directory(dir_contents_[selected_index_])) {
+    const auto entry =
+        dir_scanner_.At(static_cast<std::size_t>(selected_index_));
+    if (!entry.has_value()) {
+      return;
+    }
+
+    if (entry->is_directory) {
       if (selected_index_ == 0) {
         if (current_dir_.has_parent_path()) {
           current_dir_ = current_dir_.parent_path();
         }
       } else {
-        current_dir_ = dir_contents_[selected_index_];
+        current_dir_ = entry->path;
       }
 
-      dir_contents_ = GetDirContents(current_dir_);
-      printable_dir_contents_ = FormatDirContents(dir_contents_);
-      explorer_window_height_ = static_cast<int>(dir_contents_.size()) + 6;
+      ScanCurrentDirectory();
     } else {
-      media_to_ascii_->OpenFile(dir_contents_[selected_index_].string());
-      fps_.store(media_to_ascii_->GetFramerate());
-
-      if (media_to_ascii_->IsVideo()) {
-        StartVideoRendering();
-      } else {
-        media_to_ascii_->CalculateCharsAndColors(0);
-      }
-
-      canvas_data_ = media_to_ascii_->GetCharsAndColors(0);
+      OpenFileAsync(entry->path);
     }
   };
 
-  ftxui::MenuOption menu_options;
-  menu_options.on_enter = on_select;
-
-  auto explorer_menu =
-      Menu(&printable_dir_contents_, &selected_index_, menu_options);
+  auto explorer_menu = DirectoryMenu({
+      .size = [this] { return dir_scanner_.Size(); },
+      .label = [this](std::size_t index) { return FormatDirEntry(index); },
+      .selected = &selected_index_,
+      .on_change = [this] { PrefetchSelected(); },
+      .on_enter = on_select,
+  });
 
-  return ftxui::Window({
+  auto explorer_window = ftxui::Window({
       .inner = ftxui::Container::Vertical({
                    explorer_menu | ftxui::flex,
+                   ftxui::Renderer([this] {
+                     const std::size_t size = dir_scanner_.Size();
+                     return ftxui::text(
+                                std::to_string(size) + " entries" +
+                                (dir_scanner_.IsComplete() ? "" : "...") +
+                                (media_only_ ? " (media)" : "")) |
+                            ftxui::dim;
+                   }),
+                   ftxui::Renderer([] { return ftxui::separator(); }),
+                   ftxui::Renderer([this] { return CreatePreview(); }),
                    ftxui::Renderer([] { return ftxui::separator(); }),
                    ftxui::Button("Open", on_select) | ftxui::center,
                }) |
@@ -155,67 +564,385 @@ ftxui::Component AnimationUI::CreateFileExplorer() {
       .height = &explorer_window_height_,
       .render = {},
   });
+
+  // The window grows with the listing but never past the terminal; the
+  // menu only renders the rows that fit.
+  return ftxui::Renderer(explorer_window, [this, explorer_window] {
+    constexpr int kChromeHeight =
+        8 + static_cast<int>(ThumbnailCache::kMaxRows);
+    explorer_window_height_ =
+        std::min(static_cast<int>(dir_scanner_.Size()) + kChromeHeight,
+                 std::max(kChromeHeight + 1, GetTerminalSize().dimy));
+    return explorer_window->Render();
+  });
 }
 
-void AnimationUI::UpdateCanvasLoop() {
-  while (should_run_.load()) {
-    if (media_to_ascii_->IsVideo()) {
-      std::uint32_t idx = frame_index_.load();
-      {
-        std::lock_guard<std::mutex> lock(mutex_canvas_data_);
-        canvas_data_ = media_to_ascii_->GetCharsAndColors(idx);
-      }
-      screen_.PostEvent(ftxui::Event::Custom);
+ftxui::Element AnimationUI::CreatePreview() {
+  const auto placeholder = [](const std::string &message) {
+    return ftxui::text(message) | ftxui::dim | ftxui::center |
+           ftxui::size(ftxui::HEIGHT, ftxui::EQUAL,
+                       static_cast<int>(ThumbnailCache::kMaxRows));
+  };
+
+  const auto entry =
+      dir_scanner_.At(static_cast<std::size_t>(selected_index_));
+  if (!entry.has_value() || entry->is_directory ||
+      !IsMediaExtension(entry->path)) {
+    return placeholder("No preview");
+  }
 
-      std::uint32_t total = media_to_ascii_->GetTotalFrameCount();
-      frame_index_.store((idx + 1) % (total + 1));
+  auto thumbnail = thumbnail_cache_.Get(entry->path);
+  if (!thumbnail.has_value()) {
+    return placeholder("Loading preview...");
+  }
+  if (thumbnail->chars.empty()) {
+    return placeholder("No preview");
+  }
+
+  return AsciiFrame(std::make_shared<const MediaToAscii::CharsAndColors>(
+             std::move(*thumbnail))) |
+         ftxui::size(ftxui::HEIGHT, ftxui::EQUAL,
+                     static_cast<int>(ThumbnailCache::kMaxRows));
+}
+
+void AnimationUI::UpdateCanvas(std::uint64_t changes) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_playback_);
+    // Cancel() loses the race against a worker that already took the task.
+    if (changes != playback_changes_) {
+      return;
     }
+    is_updating_canvas_ = true;
+  }
 
-    std::uint32_t current_fps = fps_.load();
-    std::this_thread::sleep_for(
-        std::chrono::milliseconds(1000 / std::max(1U, current_fps)));
+  const auto interval = AdvancePlayback();
+
+  std::lock_guard<std::mutex> lock(mutex_playback_);
+  is_updating_canvas_ = false;
+  cv_playback_.notify_all();
+  if (!should_run_.load()) {
+    return;
+  }
+  const auto now = std::chrono::steady_clock::now();
+  if (changes != playback_changes_) {
+    // NotifyPlaybackChanged() left rescheduling to this update.
+    next_frame_ = now;
+    ScheduleCanvasUpdate();
+    return;
+  }
+  if (!interval.has_value()) {
+    // Idle until NotifyPlaybackChanged().
+    return;
   }
+
+  // Schedule against a deadline so conversion time does not slow playback,
+  // but do not try to catch up after a stall.
+  next_frame_ = std::max(next_frame_ + *interval, now);
+  ScheduleCanvasUpdate();
 }
 
-std::vector<std::filesystem::path>
-AnimationUI::GetDirContents(const std::filesystem::path &path) const {
-  std::vector<std::filesystem::path> contents;
+std::optional<std::chrono::milliseconds> AnimationUI::AdvancePlayback() {
+  if (show_mosaic_.load()) {
+    // Panes pick their frames by wall clock when the mosaic is drawn, so
+    // only redraws are paced here.
+    const std::uint32_t mosaic_fps = mosaic_fps_.load();
+    if (mosaic_fps == 0) {
+      return std::nullopt;
+    }
+    RequestRedraw();
+    return std::chrono::milliseconds(1000 / mosaic_fps);
+  }
 
-  if (!std::filesystem::exists(path) ||
-      !std::filesystem::is_directory(path)) {
-    return {};
+  auto media = GetMedia();
+  const std::uint32_t total = media->GetTotalFrameCount();
+  if (!media->IsVideo() || total <= 1 || is_paused_.load()) {
+    // A still image (or nothing) is shown, or playback is paused: schedule
+    // nothing instead of waking up every frame.
+    return std::nullopt;
   }
 
-  contents.push_back("..");
-  contents.push_back(GetHomeDirectory());
+  std::uint32_t idx = frame_index_.load();
+  ShowFrame(media, idx);
+  // Keep a restart or step from the UI thread made in the meantime.
+  frame_index_.compare_exchange_strong(idx, NextFrameIndex(idx, total));
 
-  std::filesystem::path pictures = BuildHomePath("Pictures");
-  if (std::filesystem::exists(pictures) &&
-      std::filesystem::is_directory(pictures)) {
-    contents.push_back(pictures);
+  // GIFs time every frame on its own.
+  const PlaybackSpeed &speed = kPlaybackSpeeds[speed_index_.load()];
+  return media->GetFrameDuration(idx) * speed.slowdown;
+}
+
+void AnimationUI::ScheduleCanvasUpdate() {
+  canvas_task_ = task_scheduler_.SubmitAt(
+      next_frame_, TaskPriority::kVisibleFrame,
+      [this, changes = playback_changes_] { UpdateCanvas(changes); });
+}
+
+void AnimationUI::NotifyPlaybackChanged() {
+  std::lock_guard<std::mutex> lock(mutex_playback_);
+  ++playback_changes_;
+  canvas_task_.Cancel();
+  // A running update reschedules itself when it sees the new count, so
+  // updates never overlap.
+  if (should_run_.load() && !is_updating_canvas_) {
+    next_frame_ = std::chrono::steady_clock::now();
+    ScheduleCanvasUpdate();
   }
+}
 
-  std::error_code ec;
-  for (const auto &entry : std::filesystem::directory_iterator(path, ec)) {
-    contents.push_back(entry.path());
+void AnimationUI::ShowFrame(const std::shared_ptr<MediaToAscii> &media,
+                            std::uint32_t index) {
+  // Frames are copied into recycled buffers, so steady playback does not
+  // allocate.
+  auto data = frame_pool_.Acquire();
+  media->GetCharsAndColors(index, *data);
+  {
+    std::lock_guard<std::mutex> lock(mutex_canvas_data_);
+    // The element drawing the previous frame keeps its own reference.
+    canvas_data_ = std::move(data);
   }
+  shown_frame_index_.store(index);
+  RequestRedraw();
+}
 
-  return contents;
+std::uint32_t AnimationUI::NextFrameIndex(std::uint32_t index,
+                                          std::uint32_t total_frames) const {
+  // Land on multiples of the stride; only those are converted.
+  const std::uint32_t stride =
+      kPlaybackSpeeds[speed_index_.load()].frame_stride;
+  const std::uint32_t next = (index / stride + 1) * stride;
+  return next < total_frames ? next : 0;
 }
 
-std::vector<std::string> AnimationUI::FormatDirContents(
-    const std::vector<std::filesystem::path> &contents) const {
-  std::vector<std::string> formatted;
-  formatted.reserve(contents.size());
+void AnimationUI::StepFrame() {
+  auto media = GetMedia();
+  if (!media->IsVideo()) {
+    return;
+  }
+  is_paused_.store(true);
+  NotifyPlaybackChanged();
 
-  for (const auto &entry : contents) {
-    if (std::filesystem::is_directory(entry)) {
-      formatted.push_back("[DIR] " + entry.filename().string());
-    } else {
-      formatted.push_back("[FILE] " + entry.filename().string());
+  const std::uint32_t idx = frame_index_.load();
+  ShowFrame(media, idx);
+  frame_index_.store(NextFrameIndex(idx, media->GetTotalFrameCount()));
+}
+
+void AnimationUI::SetPlaybackSpeed(std::size_t index) {
+  const std::uint32_t previous_stride =
+      kPlaybackSpeeds[speed_index_.exchange(index)].frame_stride;
+  const std::uint32_t stride = kPlaybackSpeeds[index].frame_stride;
+  NotifyPlaybackChanged();
+
+  auto media = GetMedia();
+  media->SetFrameStride(stride);
+  // Frames skipped at the faster speed are needed now. Convert them from
+  // the shown position on so playback catches up first.
+  if (stride < previous_stride && media->IsVideo() && !is_loading_.load()) {
+    StartVideoRendering(shown_frame_index_.load());
+  }
+}
+
+void AnimationUI::SetZoomView(const ZoomView &view) {
+  const ZoomView clamped = ClampZoomView(view);
+  {
+    std::lock_guard<std::mutex> lock(mutex_zoom_view_);
+    zoom_view_ = clamped;
+  }
+
+  auto media = GetMedia();
+  if (media->GetZoomView() == clamped) {
+    return;
+  }
+  media->SetZoomView(clamped);
+  // The zoomed region rounds to other pixel dimensions, which can change
+  // the fitted size. The frames are stale either way.
+  const std::uint32_t size = ChooseSize(media->GetFrameDimensions(), clamped);
+  size_.store(size);
+  media->SetSize(size);
+  RerenderMedia(media);
+}
+
+void AnimationUI::SetMonochrome(bool monochrome) {
+  monochrome_.store(monochrome);
+  mosaic_.SetMonochrome(monochrome);
+
+  auto media = GetMedia();
+  if (media->IsMonochrome() == monochrome) {
+    return;
+  }
+  media->SetMonochrome(monochrome);
+  RerenderMedia(media);
+}
+
+void AnimationUI::AddSelectedToMosaic() {
+  const auto selected =
+      dir_scanner_.At(static_cast<std::size_t>(selected_index_));
+  if (!selected.has_value() || selected->is_directory ||
+      !IsMediaExtension(selected->path) || !mosaic_.Add(selected->path)) {
+    return;
+  }
+  show_mosaic_.store(true);
+  UpdateMosaicFramerate();
+}
+
+void AnimationUI::UpdateMosaicFramerate() {
+  mosaic_fps_.store(mosaic_.GetMaxFramerate());
+  NotifyPlaybackChanged();
+}
+
+ZoomView AnimationUI::GetZoomView() const {
+  std::lock_guard<std::mutex> lock(mutex_zoom_view_);
+  return zoom_view_;
+}
+
+std::uint32_t AnimationUI::ChooseSize(const ImageDimensions &frame,
+                                      const ZoomView &view) const {
+  const std::uint32_t columns = fit_columns_.load();
+  const std::uint32_t rows = fit_rows_.load();
+  if (!auto_fit_.load() || columns == 0 || rows == 0) {
+    return manual_size_.load();
+  }
+  // Fit the converted region, which keeps the frame's aspect ratio but
+  // rounds to whole pixels.
+  const CropRect crop = ComputeZoomCrop(frame.width, frame.height, view);
+  return std::min(
+      FitPaneSize(columns, rows, {.width = crop.width, .height = crop.height}),
+      static_cast<std::uint32_t>(kMaxSize));
+}
+
+void AnimationUI::ApplySize() {
+  auto media = GetMedia();
+  const std::uint32_t size =
+      ChooseSize(media->GetFrameDimensions(), GetZoomView());
+  size_.store(size);
+  if (media->SetSize(size)) {
+    RerenderMedia(media);
+  }
+}
+
+void AnimationUI::WatchTerminalSize() {
+  const ftxui::Dimensions terminal = GetTerminalSize();
+  if (terminal.dimx == seen_terminal_size_.dimx &&
+      terminal.dimy == seen_terminal_size_.dimy) {
+    return;
+  }
+  seen_terminal_size_ = terminal;
+
+  // Every resize event pushes the fit back, so only the final size is
+  // converted.
+  fit_task_.Cancel();
+  fit_task_ = task_scheduler_.SubmitAt(
+      std::chrono::steady_clock::now() + kFitDebounce,
+      TaskPriority::kVisibleFrame, [this, terminal] {
+        PostTask([this, terminal] {
+          fit_columns_.store(
+              static_cast<std::uint32_t>(std::max(0, terminal.dimx)));
+          fit_rows_.store(
+              static_cast<std::uint32_t>(std::max(0, terminal.dimy)));
+          if (fit_to_terminal_) {
+            ApplySize();
+          }
+        });
+        RequestRedraw();
+      });
+}
+
+void AnimationUI::RerenderMedia(const std::shared_ptr<MediaToAscii> &media) {
+  // The file being opened picks up the new settings when its first frame is
+  // converted.
+  if (is_loading_.load()) {
+    return;
+  }
+
+  if (media->IsVideo()) {
+    StartVideoRendering(shown_frame_index_.load());
+  } else {
+    media->RenderImage();
+    ShowFrame(media, 0);
+  }
+}
+
+void AnimationUI::ScanCurrentDirectory() {
+  selected_index_ = 0;
+  // Watch first so that nothing created during the scan is missed.
+  dir_watcher_.Watch(current_dir_);
+  dir_scanner_.Scan(current_dir_, GetFixedDirEntries(), media_only_);
+}
+
+void AnimationUI::ApplyDirectoryChanges(
+    const std::filesystem::path &directory,
+    const std::vector<DirectoryChange> &changes) {
+  // Changes queued before navigating away belong to the old listing.
+  if (directory != current_dir_) {
+    return;
+  }
+
+  const auto selected =
+      dir_scanner_.At(static_cast<std::size_t>(selected_index_));
+  std::filesystem::path selected_path =
+      selected.has_value() ? selected->path : std::filesystem::path();
+
+  for (const auto &change : changes) {
+    switch (change.type) {
+    case DirectoryChange::Type::kReset:
+      ScanCurrentDirectory();
+      return;
+    case DirectoryChange::Type::kGone: {
+      // The watch has ended; list the closest directory that still exists.
+      std::error_code ec;
+      while (!std::filesystem::is_directory(current_dir_, ec) &&
+             current_dir_ != current_dir_.parent_path()) {
+        current_dir_ = current_dir_.parent_path();
+      }
+      ScanCurrentDirectory();
+      return;
     }
+    case DirectoryChange::Type::kModified:
+      thumbnail_cache_.Invalidate(change.path);
+      break;
+    case DirectoryChange::Type::kRenamed:
+      thumbnail_cache_.Invalidate(change.old_path);
+      if (change.old_path == selected_path) {
+        selected_path = change.path;
+      }
+      break;
+    default:
+      break;
+    }
+  }
+
+  dir_scanner_.ApplyChanges(changes, media_only_);
+
+  // Follow the selected entry to its new index. If it was removed, the
+  // index stays and DirectoryMenu clamps it to the list.
+  if (const auto index = dir_scanner_.IndexOf(selected_path)) {
+    selected_index_ = static_cast<int>(*index);
+    return;
+  }
+  if (selected.has_value()) {
+    PrefetchSelected();
   }
-  return formatted;
+}
+
+std::vector<DirectoryEntry> AnimationUI::GetFixedDirEntries() const {
+  std::vector<DirectoryEntry> entries;
+  entries.push_back({.path = "..", .is_directory = true});
+  entries.push_back({.path = GetHomeDirectory(), .is_directory = true});
+
+  std::filesystem::path pictures = BuildHomePath("Pictures");
+  if (std::filesystem::exists(pictures) &&
+      std::filesystem::is_directory(pictures)) {
+    entries.push_back({.path = pictures, .is_directory = true});
+  }
+  return entries;
+}
+
+std::string AnimationUI::FormatDirEntry(std::size_t index) const {
+  const auto entry = dir_scanner_.At(index);
+  if (!entry.has_value()) {
+    return {};
+  }
+  return (entry->is_directory ? "[DIR] " : "[FILE] ") +
+         entry->path.filename().string();
 }
 
 std::filesystem::path
@@ -237,6 +964,19 @@ ftxui::Component AnimationUI::CreateShortcutsWindow() {
                          ftxui::text("o - Open/hide options") | ftxui::flex,
                          ftxui::filler(),
                          ftxui::text("r - Restart playback") | ftxui::flex,
+                         ftxui::text("space - Pause/resume") | ftxui::flex,
+                         ftxui::text(". - Step one frame") | ftxui::flex,
+                         ftxui::text("[ / ] - Slower/faster") | ftxui::flex,
+                         ftxui::text("+ / - - Zoom in/out") | ftxui::flex,
+                         ftxui::text("w a s d - Pan") | ftxui::flex,
+                         ftxui::text("0 - Reset zoom") | ftxui::flex,
+                         ftxui::text("c - Color/monochrome") | ftxui::flex,
+                         ftxui::text("m / M - Add to/clear mosaic") |
+                             ftxui::flex,
+                         ftxui::filler(),
+                         ftxui::text("f - Show only media files") | ftxui::flex,
+                         ftxui::text("p - Play folder as sequence") |
+                             ftxui::flex,
                          ftxui::separator(),
                      });
                    }),
@@ -247,7 +987,7 @@ ftxui::Component AnimationUI::CreateShortcutsWindow() {
                ftxui::color(ftxui::Color::Violet),
       .title = "Shortcuts",
       .width = 40,
-      .height = 9,
+      .height = 20,
       .render = {},
   });
 }
@@ -255,33 +995,447 @@ ftxui::Component AnimationUI::CreateShortcutsWindow() {
 ftxui::ComponentDecorator AnimationUI::CreateEventHandler() {
   return ftxui::CatchEvent([this](ftxui::Event event) {
     if (event == ftxui::Event::Character('q')) {
-      media_to_ascii_->SetContinueRendering(false);
+      GetMedia()->SetContinueRendering(false);
       should_run_.store(false);
-      screen_.ExitLoopClosure()();
+      Exit();
       return true;
     }
     if (event == ftxui::Event::Character('r')) {
       frame_index_.store(0);
       return true;
     }
+    if (event == ftxui::Event::Character(' ')) {
+      is_paused_.store(!is_paused_.load());
+      NotifyPlaybackChanged();
+      return true;
+    }
+    if (event == ftxui::Event::Character('.')) {
+      StepFrame();
+      return true;
+    }
+    if (event == ftxui::Event::Character('+') ||
+        event == ftxui::Event::Character('=') ||
+        event == ftxui::Event::Character('-')) {
+      ZoomView view = GetZoomView();
+      view.zoom = event == ftxui::Event::Character('-') ? view.zoom / 2
+                                                         : view.zoom * 2;
+      SetZoomView(view);
+      return true;
+    }
+    if (event == ftxui::Event::Character('w') ||
+        event == ftxui::Event::Character('a') ||
+        event == ftxui::Event::Character('s') ||
+        event == ftxui::Event::Character('d')) {
+      // Pan by a quarter of the visible region.
+      ZoomView view = GetZoomView();
+      const double step = 0.25 / view.zoom;
+      const char key = event.character()[0];
+      view.center_x += key == 'a' ? -step : key == 'd' ? step : 0.0;
+      view.center_y += key == 'w' ? -step : key == 's' ? step : 0.0;
+      SetZoomView(view);
+      return true;
+    }
+    if (event == ftxui::Event::Character('0')) {
+      SetZoomView({});
+      return true;
+    }
+    if (event == ftxui::Event::Character('c')) {
+      SetMonochrome(!monochrome_.load());
+      return true;
+    }
+    if (event == ftxui::Event::Character('m')) {
+      AddSelectedToMosaic();
+      return true;
+    }
+    if (event == ftxui::Event::Character('M')) {
+      show_mosaic_.store(false);
+      mosaic_.Clear();
+      UpdateMosaicFramerate();
+      return true;
+    }
+    if (event == ftxui::Event::Character('[')) {
+      const std::size_t index = speed_index_.load();
+      SetPlaybackSpeed(index > 0 ? index - 1 : index);
+      return true;
+    }
+    if (event == ftxui::Event::Character(']')) {
+      const std::size_t index = speed_index_.load();
+      SetPlaybackSpeed(std::min(index + 1, kPlaybackSpeeds.size() - 1));
+      return true;
+    }
     if (event == ftxui::Event::Character('o')) {
       show_options_ = !show_options_;
       return true;
     }
+    if (event == ftxui::Event::Character('p')) {
+      // Play the highlighted directory, or the current one, as an image
+      // sequence. Entry 0 is "..", which is relative to current_dir_.
+      const auto selected =
+          dir_scanner_.At(static_cast<std::size_t>(selected_index_));
+      OpenFileAsync(selected_index_ != 0 && selected.has_value() &&
+                            selected->is_directory
+                        ? selected->path
+                        : current_dir_);
+      return true;
+    }
+    if (event == ftxui::Event::Character('f')) {
+      media_only_ = !media_only_;
+      ScanCurrentDirectory();
+      return true;
+    }
     return false;
   });
 }
 
-void AnimationUI::StartVideoRendering() {
-  media_to_ascii_->SetContinueRendering(false);
-  if (thread_render_video_.joinable()) {
-    thread_render_video_.join();
+void AnimationUI::StartVideoRendering(
+    std::optional<std::uint32_t> start_frame) {
+  std::lock_guard<std::mutex> lock(mutex_video_rendering_);
+  StopVideoRendering();
+
+  auto media = GetMedia();
+  media->SetContinueRendering(true);
+  if (start_frame.has_value()) {
+    media->SetCurrentFrameIndex(*start_frame);
+  }
+  media->BeginVideoPass();
+
+  std::lock_guard<std::mutex> lock_task(mutex_render_task_);
+  is_rendering_ = true;
+  if (!start_frame.has_value()) {
+    render_task_ = task_scheduler_.Submit(
+        TaskPriority::kLookAhead, [this, media] { RenderVideoChunk(media); });
+    return;
+  }
+  // Converting the shown frame is visible work; the rest is look-ahead.
+  render_task_ =
+      task_scheduler_.Submit(TaskPriority::kVisibleFrame, [this, media] {
+        // Redraw once the shown frame is reconverted, so a paused video also
+        // picks up the new settings.
+        media->RenderVideoFrames(1);
+        ShowFrame(media, shown_frame_index_.load());
+        RenderVideoChunk(media);
+      });
+}
+
+void AnimationUI::StopVideoRendering() {
+  GetMedia()->SetContinueRendering(false);
+  std::unique_lock<std::mutex> lock(mutex_render_task_);
+  if (render_task_.Cancel()) {
+    is_rendering_ = false;
+  }
+  cv_render_done_.wait(lock, [this] { return !is_rendering_; });
+}
+
+void AnimationUI::RenderVideoChunk(const std::shared_ptr<MediaToAscii> &media) {
+  const bool has_more = media->RenderVideoChunk(kRenderChunkFrames);
+
+  std::lock_guard<std::mutex> lock(mutex_render_task_);
+  // StopVideoRendering() cancels the next chunk if it is queued before the
+  // stop, and this chunk returns false if it starts after it.
+  if (has_more) {
+    render_task_ = task_scheduler_.Submit(
+        TaskPriority::kLookAhead, [this, media] { RenderVideoChunk(media); });
+    return;
+  }
+  is_rendering_ = false;
+  cv_render_done_.notify_all();
+}
+
+void AnimationUI::OpenFileAsync(const std::filesystem::path &file) {
+  std::lock_guard<std::mutex> lock(mutex_pending_open_);
+  pending_open_file_ = file;
+  failed_file_.clear();
+
+  if (is_loading_.load()) {
+    // open_task_ picks up the new request when the current one is done.
+    return;
+  }
+
+  is_loading_.store(true);
+  open_task_ = task_scheduler_.Submit(TaskPriority::kVisibleFrame,
+                                      [this] { OpenPendingFiles(); });
+}
+
+void AnimationUI::OpenPendingFiles() {
+  while (true) {
+    std::filesystem::path file;
+    {
+      std::lock_guard<std::mutex> lock(mutex_pending_open_);
+      if (!pending_open_file_.has_value()) {
+        is_loading_.store(false);
+        break;
+      }
+      file = std::move(*pending_open_file_);
+      pending_open_file_.reset();
+      loading_file_ = file;
+    }
+    RequestRedraw();
+
+    const auto start = std::chrono::steady_clock::now();
+
+    // Reopening the shown file resumes it like any recent one.
+    bool is_shown = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex_media_to_ascii_);
+      is_shown = media_file_ == file;
+    }
+    if (is_shown) {
+      ParkShownMedia();
+    }
+
+    // Resume the file if it was shown recently, else reuse the speculative
+    // open of the highlighted file if there is one. The previous file keeps
+    // playing until the new one is ready, and stays if it cannot be opened.
+    std::uint32_t resume_index = 0;
+    auto media = TakeRecentMedia(file, resume_index);
+    const bool was_resumed = media != nullptr;
+    if (!was_resumed) {
+      media = TakePrefetchedMedia(file);
+    }
+    const bool was_prefetched = !was_resumed && media != nullptr;
+    const ZoomView zoom_view = GetZoomView();
+    if (media == nullptr) {
+      media = std::make_shared<MediaToAscii>();
+      media->SetSequenceFramerate(sequence_fps_.load());
+      media->SetSize(size_.load());
+      media->SetMonochrome(monochrome_.load());
+      media->SetZoomView(zoom_view);
+      if (!media->OpenFile(file)) {
+        std::lock_guard<std::mutex> lock(mutex_pending_open_);
+        failed_file_ = file;
+        failed_until_ = std::chrono::steady_clock::now() + kOpenErrorDuration;
+        failed_redraw_task_.Cancel();
+        failed_redraw_task_ =
+            task_scheduler_.SubmitAt(failed_until_, TaskPriority::kVisibleFrame,
+                                     [this] { RequestRedraw(); });
+        continue;
+      }
+    }
+
+    // Stop decoding the previous file before it is replaced.
+    {
+      std::lock_guard<std::mutex> lock(mutex_video_rendering_);
+      StopVideoRendering();
+    }
+    if (!is_shown) {
+      ParkShownMedia();
+    }
+
+    media->SetFrameStride(kPlaybackSpeeds[speed_index_.load()].frame_stride);
+
+    // The size or color mode may have changed while the file was being
+    // opened, auto-fit needs the file's aspect ratio, and prefetched files
+    // are opened without zoom.
+    const std::uint32_t size =
+        ChooseSize(media->GetFrameDimensions(), zoom_view);
+    size_.store(size);
+    if (media->GetSize() != size ||
+        media->IsMonochrome() != monochrome_.load() ||
+        media->GetZoomView() != zoom_view) {
+      media->SetSize(size);
+      media->SetMonochrome(monochrome_.load());
+      media->SetZoomView(zoom_view);
+      if (!media->IsVideo()) {
+        media->RenderImage();
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_media_to_ascii_);
+      media_to_ascii_ = media;
+      media_file_ = file;
+    }
+    frame_index_.store(resume_index);
+    NotifyPlaybackChanged();
+    ShowFrame(media, resume_index);
+
+    const auto time_to_first_frame =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start);
+    logger_->info("[AnimationUI::OpenPendingFiles] Time to first frame for "
+                  "{}: {} ms{}",
+                  file.string(), time_to_first_frame.count(),
+                  was_resumed      ? " (resumed)"
+                  : was_prefetched ? " (prefetched)"
+                                   : "");
+
+    if (!media->IsVideo()) {
+      continue;
+    }
+    if (was_resumed) {
+      // A pass over a fully converted video would still grab every frame,
+      // so only render if a setting changed while the file was parked.
+      if (media->HasStaleFrames()) {
+        StartVideoRendering(resume_index);
+      }
+      continue;
+    }
+    // OpenFile() already converted the first frames; keep decoding from the
+    // current position. Frames converted at a stale size are redone when
+    // the rendering pass wraps around.
+    StartVideoRendering(std::nullopt);
+  }
+  RequestRedraw();
+}
+
+void AnimationUI::ParkShownMedia() {
+  std::shared_ptr<MediaToAscii> media;
+  std::filesystem::path file;
+  {
+    std::lock_guard<std::mutex> lock(mutex_media_to_ascii_);
+    media = media_to_ascii_;
+    file = media_file_;
+  }
+  std::error_code error;
+  const auto modified = std::filesystem::last_write_time(file, error);
+  if (file.empty() || error) {
+    return;
+  }
+
+  const std::size_t memory = media->GetMemoryUsage();
+  std::lock_guard<std::mutex> lock(mutex_recent_media_);
+  if (!recent_media_.Park(file,
+                          {.media = std::move(media),
+                           .frame_index = shown_frame_index_.load()},
+                          modified, memory)) {
+    logger_->info("[AnimationUI::ParkShownMedia] {} holds {} MB, more than "
+                  "the recent files may; closing it",
+                  file.string(), memory >> 20);
+  }
+}
+
+std::shared_ptr<MediaToAscii>
+AnimationUI::TakeRecentMedia(const std::filesystem::path &file,
+                             std::uint32_t &frame_index) {
+  std::error_code error;
+  const auto modified = std::filesystem::last_write_time(file, error);
+  std::lock_guard<std::mutex> lock(mutex_recent_media_);
+  if (!recent_media_.Contains(file)) {
+    return nullptr;
+  }
+  std::optional<RecentMedia> session = recent_media_.Take(
+      file, error ? std::nullopt : std::optional(modified));
+  if (!session.has_value()) {
+    logger_->info("[AnimationUI::TakeRecentMedia] {} changed since it was "
+                  "opened, reopening it",
+                  file.string());
+    return nullptr;
+  }
+  frame_index = session->frame_index;
+  return std::move(session->media);
+}
+
+std::shared_ptr<MediaToAscii> AnimationUI::GetMedia() const {
+  std::lock_guard<std::mutex> lock(mutex_media_to_ascii_);
+  return media_to_ascii_;
+}
+
+void AnimationUI::PrefetchSelected() {
+  std::lock_guard<std::mutex> lock(mutex_prefetch_);
+
+  // Cancel speculative work for the previously highlighted entry.
+  ++prefetch_generation_;
+  pending_prefetch_.reset();
+  prefetch_file_.clear();
+  prefetch_in_flight_ = false;
+  prefetched_media_.reset();
+  for (const auto &media : active_prefetches_) {
+    media->SetContinueRendering(false);
+  }
+
+  const auto selected =
+      dir_scanner_.At(static_cast<std::size_t>(selected_index_));
+  if (!selected.has_value() || selected->is_directory ||
+      !IsMediaExtension(selected->path)) {
+    return;
+  }
+  // A recently shown file is resumed without opening it again.
+  {
+    std::lock_guard<std::mutex> lock_recent(mutex_recent_media_);
+    if (recent_media_.Contains(selected->path)) {
+      return;
+    }
+  }
+
+  pending_prefetch_ = selected->path;
+  prefetch_file_ = selected->path;
+  // Running tasks pick up the new file once their current open returns.
+  if (prefetch_tasks_ < kMaxSpeculativeOpens) {
+    ++prefetch_tasks_;
+    task_scheduler_.Submit(TaskPriority::kPrefetch,
+                           [this] { RunPrefetches(); });
+  }
+}
+
+void AnimationUI::RunPrefetches() {
+  while (true) {
+    std::filesystem::path file;
+    std::uint64_t generation = 0;
+    std::shared_ptr<MediaToAscii> media;
+    {
+      std::lock_guard<std::mutex> lock(mutex_prefetch_);
+      if (!should_run_.load() || !pending_prefetch_.has_value()) {
+        --prefetch_tasks_;
+        cv_prefetch_.notify_all();
+        return;
+      }
+      file = std::move(*pending_prefetch_);
+      pending_prefetch_.reset();
+      generation = prefetch_generation_;
+      prefetch_in_flight_ = true;
+
+      media = std::make_shared<MediaToAscii>();
+      media->SetSize(size_.load());
+      media->SetMonochrome(monochrome_.load());
+      active_prefetches_.push_back(media);
+    }
+
+    const bool opened = media->OpenFile(file);
+
+    // Cancellation during OpenFile() cannot stop it, so check afterwards.
+    bool is_current = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex_prefetch_);
+      is_current = generation == prefetch_generation_;
+    }
+    if (opened && is_current && media->IsVideo()) {
+      media->RenderVideoFrames(kPrefetchFrames);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_prefetch_);
+    std::erase(active_prefetches_, media);
+    if (generation == prefetch_generation_) {
+      prefetch_in_flight_ = false;
+      if (opened) {
+        prefetched_media_ = media;
+        logger_->info("[AnimationUI::RunPrefetches] Prefetched {}",
+                      file.string());
+      }
+    }
+    cv_prefetch_.notify_all();
+  }
+}
+
+std::shared_ptr<MediaToAscii>
+AnimationUI::TakePrefetchedMedia(const std::filesystem::path &file) {
+  std::unique_lock<std::mutex> lock(mutex_prefetch_);
+  if (pending_prefetch_ == file) {
+    // The prefetch has not started, and may be queued behind the caller on
+    // the task scheduler. Opening the file directly is faster anyway.
+    pending_prefetch_.reset();
+    prefetch_file_.clear();
+    return nullptr;
+  }
+  cv_prefetch_.wait(lock, [&] {
+    return !should_run_.load() || prefetch_file_ != file ||
+           prefetched_media_ != nullptr || !prefetch_in_flight_;
+  });
+
+  if (prefetch_file_ != file || prefetched_media_ == nullptr) {
+    return nullptr;
   }
-  media_to_ascii_->SetContinueRendering(true);
-  media_to_ascii_->SetCurrentFrameIndex(0);
-  thread_render_video_ =
-      std::thread(&MediaToAscii::RenderVideo, media_to_ascii_.get());
-  frame_index_.store(0);
+  prefetch_file_.clear();
+  return std::move(prefetched_media_);
 }
 
 } // namespace terminal_animation
\ No newline at end of file
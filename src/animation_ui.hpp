@@ -2,7 +2,19 @@
 
 // local
 #include "common.hpp"
+#include "directory_scanner.hpp"
+#include "directory_watcher.hpp"
+#include "frame_scheduler.hpp"
+#include "image_sequence.hpp"
+#include "logger.hpp"
+#include "lru_cache.hpp"
 #include "media_to_ascii.hpp"
+#include "mosaic_player.hpp"
+#include "recent_sessions.hpp"
+#include "shared_pool.hpp"
+#include "task_scheduler.hpp"
+#include "terminal_writer.hpp"
+#include "thumbnail_cache.hpp"
 
 // libs
 // FTXUI
@@ -11,52 +23,213 @@
 #include <ftxui/component/screen_interactive.hpp>
 #include <ftxui/dom/elements.hpp>
 #include <ftxui/screen/screen.hpp>
-// spdlog
-#include "spdlog/async.h"
-#include "spdlog/sinks/basic_file_sink.h"
+#include <ftxui/screen/terminal.hpp>
 
 // std
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <filesystem>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <ostream>
 #include <string>
-#include <thread>
 #include <vector>
 
 namespace terminal_animation {
 
 class AnimationUI {
 public:
-  AnimationUI();
+  // Background work runs on a TaskScheduler created with options.
+  // Thumbnails are persisted in thumbnail_directory; an empty path keeps
+  // them in memory only.
+  explicit AnimationUI(TaskScheduler::Options options = {},
+                       std::filesystem::path thumbnail_directory =
+                           ThumbnailCache::GetDefaultDiskDirectory());
 
   // Runs the main FTXUI event loop and blocks until quit.
   void Run();
 
+  // Makes Run() append every input event to file, in the format Replay()
+  // reads. Call before Run().
+  void RecordEvents(const std::filesystem::path &file) { record_file_ = file; }
+
+  // Plays back the events recorded in file without a terminal, drawing to a
+  // virtual screen of the recorded size at the recorded times. Writes one
+  // JSON line per event with its handling and frame time to report, then
+  // a summary line. Returns false if file cannot be read. Use instead of
+  // Run().
+  bool Replay(const std::filesystem::path &file, std::ostream &report);
+
+  // Opens a file, directory or image sequence pattern as if it was chosen
+  // in the explorer. May be called before Run().
+  void OpenFile(const std::filesystem::path &file) { OpenFileAsync(file); }
+
+  // Frame rate image sequences opened afterwards play at.
+  void SetSequenceFramerate(std::uint32_t fps) { sequence_fps_.store(fps); }
+
 private:
   // FTXUI component builders
+  ftxui::Component CreateMainComponent();
   ftxui::Component CreateRenderer();
   ftxui::Element CreateCanvas();
+  ftxui::Element CreateMosaic();
   ftxui::Component CreateOptionsWindow();
   ftxui::Component CreateFileExplorer();
+  ftxui::Element CreatePreview();
   ftxui::Component CreateShortcutsWindow();
   ftxui::ComponentDecorator CreateEventHandler();
 
-  // Background thread entry: posts frame updates to the FTXUI loop.
-  void UpdateCanvasLoop();
+  // Task body: shows the next frame and schedules the following update at
+  // its deadline. Nothing is scheduled while there is nothing to animate.
+  // changes is the playback_changes_ value the update was scheduled for; a
+  // superseded update returns without doing anything.
+  void UpdateCanvas(std::uint64_t changes);
+
+  // Shows the next video frame, or redraws the mosaic. Returns the time
+  // until the next update, or nullopt while there is nothing to animate.
+  std::optional<std::chrono::milliseconds> AdvancePlayback();
+
+  // Schedules UpdateCanvas() at next_frame_. Requires mutex_playback_.
+  void ScheduleCanvasUpdate();
+
+  // Restarts the canvas updates after the shown media, the playback state
+  // or should_run_ changed.
+  void NotifyPlaybackChanged();
+
+  // Publishes frame index of media to canvas_data_ and redraws.
+  void ShowFrame(const std::shared_ptr<MediaToAscii> &media,
+                 std::uint32_t index);
+
+  // Returns the frame shown after index at the current speed, wrapping to 0
+  // at the end of a video with total_frames frames.
+  std::uint32_t NextFrameIndex(std::uint32_t index,
+                               std::uint32_t total_frames) const;
+
+  // Pauses playback and shows the next frame at the current speed.
+  void StepFrame();
+
+  // Selects kPlaybackSpeeds[index] and adjusts which frames are converted.
+  void SetPlaybackSpeed(std::size_t index);
+
+  // Applies a zoom/pan view to the shown media and every file opened next.
+  void SetZoomView(const ZoomView &view);
+  ZoomView GetZoomView() const;
+
+  // Switches the shown media, the mosaic and every file opened next between
+  // color and monochrome conversion.
+  void SetMonochrome(bool monochrome);
+
+  // Adds the highlighted explorer file to the mosaic and shows the mosaic.
+  void AddSelectedToMosaic();
+
+  // Publishes the mosaic's frame rate to the canvas updates. Runs on the UI
+  // thread, which owns mosaic_.
+  void UpdateMosaicFramerate();
+
+  // Returns the size a frame of the given dimensions is shown at: fitted to
+  // the terminal in auto-fit mode, otherwise the slider's size.
+  std::uint32_t ChooseSize(const ImageDimensions &frame,
+                           const ZoomView &view) const;
+
+  // Applies ChooseSize() to the shown media, reconverting it only if its
+  // grid changes. Runs on the UI thread.
+  void ApplySize();
+
+  // Stops background work once the event loop has ended.
+  void Shutdown();
+
+  // Wakes the event loop to redraw, from any thread.
+  void RequestRedraw();
+
+  // Runs task on the UI thread, from any thread.
+  void PostTask(std::function<void()> task);
+
+  // Ends the event loop.
+  void Exit();
+
+  // The real terminal's size, or the virtual screen's while replaying.
+  ftxui::Dimensions GetTerminalSize() const;
+
+  // Called on every draw. Once the terminal size stops changing for
+  // kFitDebounce, records it for auto-fit and calls ApplySize().
+  void WatchTerminalSize();
+
+  // Reconverts the shown media after its size or zoom view changed. Video
+  // restarts at the shown frame; stale frames stay visible until replaced.
+  void RerenderMedia(const std::shared_ptr<MediaToAscii> &media);
 
   // Filesystem helpers
-  std::vector<std::filesystem::path>
-  GetDirContents(const std::filesystem::path &path) const;
+  // Starts listing and watching current_dir_ in the background and resets
+  // the selection.
+  void ScanCurrentDirectory();
+
+  // Applies changes reported by dir_watcher_ on the UI thread, keeping the
+  // selected entry selected.
+  void ApplyDirectoryChanges(const std::filesystem::path &directory,
+                             const std::vector<DirectoryChange> &changes);
+
+  // Shortcut entries shown above the contents of every directory.
+  std::vector<DirectoryEntry> GetFixedDirEntries() const;
 
-  std::vector<std::string>
-  FormatDirContents(const std::vector<std::filesystem::path> &contents) const;
+  // Returns the explorer label of the entry at the given index.
+  std::string FormatDirEntry(std::size_t index) const;
 
   std::filesystem::path BuildHomePath(const std::string &subdir) const;
 
-  // Starts (or restarts) video rendering on the background thread.
-  void StartVideoRendering();
+  // Starts (or restarts) video rendering in the background, seeking to
+  // start_frame first. Without a start frame rendering continues from the
+  // current capture position, e.g. right after OpenFile() has converted the
+  // first frame.
+  void StartVideoRendering(std::optional<std::uint32_t> start_frame);
+
+  // Stops the shown media's rendering tasks and waits for them to return.
+  // Requires mutex_video_rendering_.
+  void StopVideoRendering();
+
+  // Task body: converts the next kRenderChunkFrames frames of media's
+  // rendering pass, then queues the next chunk.
+  void RenderVideoChunk(const std::shared_ptr<MediaToAscii> &media);
+
+  // Queues a file to be opened by open_task_. If a file is already being
+  // opened, only the most recently requested one is opened next.
+  void OpenFileAsync(const std::filesystem::path &file);
+
+  // Task body: opens queued files until none are pending.
+  void OpenPendingFiles();
+
+  // Returns the media currently shown. The pointer is swapped whenever a
+  // file is opened, so callers hold their own reference while using it.
+  std::shared_ptr<MediaToAscii> GetMedia() const;
+
+  // Starts speculatively opening the highlighted explorer entry, cancelling
+  // the speculative work for the previously highlighted one.
+  void PrefetchSelected();
+
+  // Task body: runs speculative opens from pending_prefetch_ until none are
+  // pending.
+  void RunPrefetches();
+
+  // Returns the speculatively opened media for file, waiting for an
+  // in-flight prefetch of it to finish. A prefetch that has not started yet
+  // is dropped, since the caller opens the file sooner itself. Returns
+  // nullptr if there is no prefetched media.
+  std::shared_ptr<MediaToAscii>
+  TakePrefetchedMedia(const std::filesystem::path &file);
+
+  // Keeps the shown media in recent_media_, with its playback position, so
+  // switching back to its file resumes it. Requires rendering stopped.
+  void ParkShownMedia();
+
+  // Removes and returns the recent session of file, or nullptr if there is
+  // none or the file was modified since it was opened.
+  std::shared_ptr<MediaToAscii>
+  TakeRecentMedia(const std::filesystem::path &file,
+                  std::uint32_t &frame_index);
 
   // UI visibility toggles
   bool show_options_ = true;
@@ -65,32 +238,188 @@ private:
   // Main loop control
   std::atomic<bool> should_run_{true};
 
-  // Playback state
-  std::atomic<std::uint32_t> fps_{1};
+  // Asynchronous file opening
+  std::atomic<bool> is_loading_{false};
+  std::optional<std::filesystem::path> pending_open_file_;
+  std::filesystem::path loading_file_;
+  // File the last open failed for, reported over the shown media until
+  // failed_until_ or until another file is requested.
+  std::filesystem::path failed_file_;
+  std::chrono::steady_clock::time_point failed_until_;
+  // Redraws without the report once it expires.
+  TaskHandle failed_redraw_task_;
+  TaskHandle open_task_;
+  std::mutex mutex_pending_open_;
+  static constexpr std::chrono::seconds kOpenErrorDuration{3};
+
+  static constexpr std::uint32_t kDefaultSize = 32;
+  static constexpr std::int32_t kMaxSize = 512;
+  // A resize is applied once the terminal kept its size this long, so
+  // dragging a window edge converts once instead of on every step.
+  static constexpr std::chrono::milliseconds kFitDebounce{150};
+
+  // Size the shown media was last converted at, applied to every opened
+  // file until it is fitted.
+  std::atomic<std::uint32_t> size_{kDefaultSize};
+  // Size chosen with the slider in the options window.
+  std::atomic<std::uint32_t> manual_size_{kDefaultSize};
+
+  // Auto-fit: the size is derived from the terminal and the media's aspect
+  // ratio instead of the slider. fit_to_terminal_ is the checkbox state on
+  // the UI thread, auto_fit_ its copy for the file opening task.
+  bool fit_to_terminal_ = true;
+  std::atomic<bool> auto_fit_{true};
+  // Terminal size seen by the last draw, and the one sizes are fitted to.
+  ftxui::Dimensions seen_terminal_size_{};
+  std::atomic<std::uint32_t> fit_columns_{0};
+  std::atomic<std::uint32_t> fit_rows_{0};
+  TaskHandle fit_task_;
+
+  // Frame rate of image sequences, which carry none themselves.
+  std::atomic<std::uint32_t> sequence_fps_{kDefaultSequenceFramerate};
+
+  // Color mode toggled with 'c', applied to every opened file.
+  std::atomic<bool> monochrome_{false};
+
+  // Zoom and pan chosen with the keyboard, applied to every opened file.
+  ZoomView zoom_view_;
+  mutable std::mutex mutex_zoom_view_;
+
+  // Playback speeds selectable with '[' and ']'. Faster speeds show only
+  // every frame_stride-th frame, slower ones stretch the frame interval.
+  struct PlaybackSpeed {
+    std::uint32_t frame_stride;
+    std::uint32_t slowdown;
+    const char *label;
+  };
+  static constexpr std::array<PlaybackSpeed, 6> kPlaybackSpeeds{{
+      {.frame_stride = 1, .slowdown = 4, .label = "0.25x"},
+      {.frame_stride = 1, .slowdown = 2, .label = "0.5x"},
+      {.frame_stride = 1, .slowdown = 1, .label = "1x"},
+      {.frame_stride = 2, .slowdown = 1, .label = "2x"},
+      {.frame_stride = 4, .slowdown = 1, .label = "4x"},
+      {.frame_stride = 8, .slowdown = 1, .label = "8x"},
+  }};
+  static constexpr std::size_t kDefaultSpeedIndex = 2;
+
+  // Playback state. frame_index_ is the next frame to show.
   std::atomic<std::uint32_t> frame_index_{0};
+  std::atomic<std::uint32_t> shown_frame_index_{0};
+  std::atomic<bool> is_paused_{false};
+  std::atomic<std::size_t> speed_index_{kDefaultSpeedIndex};
+  // Canvas update state, guarded by mutex_playback_. playback_changes_
+  // counts NotifyPlaybackChanged() calls, and only the update scheduled for
+  // the latest value runs. Updates never overlap.
+  std::uint64_t playback_changes_ = 0;
+  std::chrono::steady_clock::time_point next_frame_;
+  TaskHandle canvas_task_;
+  bool is_updating_canvas_ = false;
+  std::mutex mutex_playback_;
+  std::condition_variable cv_playback_;
 
+  // Takes FTXUI's output off the UI thread while Run() is looping.
+  TerminalWriter terminal_writer_;
   ftxui::ScreenInteractive screen_ = ftxui::ScreenInteractive::Fullscreen();
 
-  std::unique_ptr<MediaToAscii> media_to_ascii_ =
-      std::make_unique<MediaToAscii>();
+  // Input events are appended to record_file_ by Run() if it is set.
+  std::filesystem::path record_file_;
+
+  // Replay() stands in for the FTXUI loop: redraw requests and posted
+  // tasks go to it instead of screen_, and it draws at headless_size_.
+  std::atomic<bool> is_headless_{false};
+  ftxui::Dimensions headless_size_{};
+  std::vector<std::function<void()>> headless_tasks_;
+  bool headless_redraw_ = false;
+  bool headless_exit_ = false;
+  std::mutex mutex_headless_;
+  std::condition_variable cv_headless_;
 
-  MediaToAscii::CharsAndColors canvas_data_;
+  std::shared_ptr<MediaToAscii> media_to_ascii_ =
+      std::make_shared<MediaToAscii>();
+  // File the shown media was opened from; empty before the first open.
+  std::filesystem::path media_file_;
+  mutable std::mutex mutex_media_to_ascii_;
+
+  // Recently shown files, kept open with their converted frames so
+  // switching back skips decoding. Each session costs the bytes it holds,
+  // but at least 1/kMaxRecentMedia of the budget, which bounds the number
+  // of decoders kept open.
+  struct RecentMedia {
+    std::shared_ptr<MediaToAscii> media;
+    std::uint32_t frame_index = 0;
+  };
+  static constexpr std::size_t kRecentMediaBudget = 512ULL << 20;
+  static constexpr std::size_t kMaxRecentMedia = 8;
+  RecentSessions<RecentMedia> recent_media_{kRecentMediaBudget,
+                                            kMaxRecentMedia};
+  std::mutex mutex_recent_media_;
+
+  // Runs all background work except directory scanning and watching, which
+  // block on the filesystem. Declared before its users so it outlives them.
+  TaskScheduler task_scheduler_;
+
+  // Speculative prefetch of the highlighted file. At most
+  // kMaxSpeculativeOpens files are opened at once; a cancelled imread cannot
+  // be interrupted, so it keeps its slot until it returns.
+  static constexpr std::uint32_t kMaxSpeculativeOpens = 2;
+  static constexpr std::uint32_t kPrefetchFrames = 8;
+  std::optional<std::filesystem::path> pending_prefetch_;
+  std::filesystem::path prefetch_file_;
+  std::uint64_t prefetch_generation_ = 0;
+  bool prefetch_in_flight_ = false;
+  std::vector<std::shared_ptr<MediaToAscii>> active_prefetches_;
+  std::shared_ptr<MediaToAscii> prefetched_media_;
+  std::uint32_t prefetch_tasks_ = 0;
+  std::mutex mutex_prefetch_;
+  std::condition_variable cv_prefetch_;
+
+  // Frame shown on the canvas. Published frames are never modified, so the
+  // element drawing one only needs the pointer. Buffers return to
+  // frame_pool_ once neither canvas_data_ nor an element refers to them.
+  std::shared_ptr<const MediaToAscii::CharsAndColors> canvas_data_;
+  SharedPool<MediaToAscii::CharsAndColors> frame_pool_;
   std::mutex mutex_canvas_data_;
 
   // File explorer state
   std::filesystem::path current_dir_ = std::filesystem::current_path();
-  std::vector<std::filesystem::path> dir_contents_;
-  std::vector<std::string> printable_dir_contents_;
+  DirectoryScanner dir_scanner_{
+      [this] { RequestRedraw(); }};
+  DirectoryWatcher dir_watcher_{
+      [this](const std::filesystem::path &directory,
+             const std::vector<DirectoryChange> &changes) {
+        PostTask([this, directory, changes] {
+          ApplyDirectoryChanges(directory, changes);
+        });
+        RequestRedraw();
+      }};
+  bool media_only_ = false;
+  ThumbnailCache thumbnail_cache_;
   int selected_index_ = 0;
   int explorer_window_height_ = 0;
 
-  // Background threads
-  std::thread thread_canvas_update_;
-  std::thread thread_render_video_;
+  // Mosaic of several files, decoded on frame_scheduler_'s tasks. While it
+  // is shown, the canvas updates redraw at mosaic_fps_ (0: on demand).
+  FrameScheduler frame_scheduler_{task_scheduler_};
+  MosaicPlayer mosaic_{frame_scheduler_, [this] {
+                         PostTask([this] { UpdateMosaicFramerate(); });
+                         RequestRedraw();
+                       }};
+  std::atomic<bool> show_mosaic_{false};
+  std::atomic<std::uint32_t> mosaic_fps_{0};
+
+  // Video rendering runs as a chain of kRenderChunkFrames-frame tasks, so
+  // canvas updates and file opens get a worker in between.
+  static constexpr std::uint32_t kRenderChunkFrames = 8;
+  TaskHandle render_task_;
+  bool is_rendering_ = false;
+  std::mutex mutex_render_task_;
+  std::condition_variable cv_render_done_;
+
+  // Serializes starting/stopping video rendering between the UI thread and
+  // open_task_.
+  std::mutex mutex_video_rendering_;
 
-  std::shared_ptr<spdlog::logger> logger_ =
-      spdlog::basic_logger_mt<spdlog::async_factory>("AnimationUI",
-                                                      "logs/debug.txt");
+  std::shared_ptr<spdlog::logger> logger_ = GetLogger("AnimationUI");
 };
 
 } // namespace terminal_animation
\ No newline at end of file
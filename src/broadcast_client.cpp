@@ -0,0 +1,158 @@
+// header
+#include "broadcast_client.hpp"
+
+// std
+#include <array>
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__) || defined(__APPLE__)
+#define TERMINAL_ANIMATION_POSIX 1
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace terminal_animation {
+
+bool BroadcastClient::Connect(const std::filesystem::path &socket_path) {
+  Disconnect();
+
+#ifdef TERMINAL_ANIMATION_POSIX
+  const std::string native = socket_path.string();
+  sockaddr_un address{};
+  if (native.empty() || native.size() >= sizeof(address.sun_path)) {
+    logger_->error("[BroadcastClient::Connect] Invalid socket path: {}",
+                   native);
+    return false;
+  }
+  address.sun_family = AF_UNIX;
+  std::memcpy(address.sun_path, native.c_str(), native.size() + 1);
+
+  fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd_ < 0 || connect(fd_, reinterpret_cast<sockaddr *>(&address),
+                         sizeof(address)) != 0) {
+    logger_->error("[BroadcastClient::Connect] Could not connect to {}: {}",
+                   native, std::strerror(errno));
+    if (fd_ >= 0) {
+      close(fd_);
+      fd_ = -1;
+    }
+    return false;
+  }
+#ifdef SO_NOSIGPIPE
+  const int on = 1;
+  setsockopt(fd_, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+  is_connected_.store(true);
+  thread_receive_ = std::thread(&BroadcastClient::Receive, this);
+  return true;
+#else
+  logger_->error("[BroadcastClient::Connect] Unix domain sockets are not "
+                 "supported on this platform");
+  return false;
+#endif
+}
+
+bool BroadcastClient::RequestStream(const StreamParams &params) {
+#ifdef TERMINAL_ANIMATION_POSIX
+  std::lock_guard<std::mutex> lock(mutex_send_);
+  if (!is_connected_.load()) {
+    return false;
+  }
+#ifdef MSG_NOSIGNAL
+  constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+  constexpr int kSendFlags = 0;
+#endif
+  EncodeHello(params, hello_);
+  std::size_t sent = 0;
+  while (sent < hello_.size()) {
+    const auto result =
+        send(fd_, hello_.data() + sent, hello_.size() - sent, kSendFlags);
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result <= 0) {
+      return false;
+    }
+    sent += static_cast<std::size_t>(result);
+  }
+  return true;
+#else
+  (void)params;
+  return false;
+#endif
+}
+
+std::shared_ptr<const CharsAndColors> BroadcastClient::GetFrame() const {
+  std::lock_guard<std::mutex> lock(mutex_frame_);
+  return frame_;
+}
+
+void BroadcastClient::Disconnect() {
+#ifdef TERMINAL_ANIMATION_POSIX
+  if (fd_ < 0) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_send_);
+    // Makes the receive thread's recv() return.
+    shutdown(fd_, SHUT_RDWR);
+  }
+  if (thread_receive_.joinable()) {
+    thread_receive_.join();
+  }
+  close(fd_);
+  fd_ = -1;
+#endif
+}
+
+void BroadcastClient::Receive() {
+#ifdef TERMINAL_ANIMATION_POSIX
+  MessageReader reader;
+  Message message;
+  std::array<char, 1 << 16> buffer{};
+  while (true) {
+    const auto received = recv(fd_, buffer.data(), buffer.size(), 0);
+    if (received < 0 && errno == EINTR) {
+      continue;
+    }
+    if (received <= 0) {
+      break;
+    }
+    reader.Append(buffer.data(), static_cast<std::size_t>(received));
+
+    bool has_frame = false;
+    bool is_corrupt = reader.HasError();
+    while (!is_corrupt && reader.Next(message)) {
+      std::uint32_t index = 0;
+      auto frame = frame_pool_.Acquire();
+      is_corrupt = message.type != MessageType::kFrame ||
+                   !DecodeFrame(message.payload, index, *frame);
+      if (!is_corrupt) {
+        std::lock_guard<std::mutex> lock(mutex_frame_);
+        frame_ = std::move(frame);
+        has_frame = true;
+      }
+    }
+    if (has_frame) {
+      on_update_();
+    }
+    if (is_corrupt || reader.HasError()) {
+      logger_->error("[BroadcastClient::Receive] Corrupt stream from the "
+                     "server");
+      break;
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_send_);
+    is_connected_.store(false);
+  }
+  on_update_();
+#endif
+}
+
+} // namespace terminal_animation
@@ -0,0 +1,73 @@
+#pragma once
+
+// local
+#include "chars_and_colors.hpp"
+#include "frame_protocol.hpp"
+#include "logger.hpp"
+#include "shared_pool.hpp"
+
+// std
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace terminal_animation {
+
+// Receives the frames a BroadcastServer streams. Only the latest frame is
+// kept; frames that arrive before it was shown are overwritten.
+class BroadcastClient {
+public:
+  // on_update is called from the receive thread after every frame and once
+  // when the connection is lost.
+  explicit BroadcastClient(std::function<void()> on_update)
+      : on_update_(std::move(on_update)) {}
+
+  ~BroadcastClient() { Disconnect(); }
+
+  BroadcastClient(const BroadcastClient &) = delete;
+  BroadcastClient &operator=(const BroadcastClient &) = delete;
+
+  // Connects to the server listening on socket_path and starts receiving.
+  // Returns false if no server accepts there.
+  bool Connect(const std::filesystem::path &socket_path);
+
+  // Asks the server for frames converted with params. Frames at the old
+  // parameters may still arrive until the server switched. Returns false if
+  // not connected.
+  bool RequestStream(const StreamParams &params);
+
+  // Returns the latest frame, or nullptr before the first one.
+  std::shared_ptr<const CharsAndColors> GetFrame() const;
+
+  bool IsConnected() const { return is_connected_.load(); }
+
+  // Closes the connection and joins the receive thread.
+  void Disconnect();
+
+private:
+  // Receive thread entry.
+  void Receive();
+
+  std::function<void()> on_update_;
+
+  int fd_ = -1;
+  std::atomic<bool> is_connected_{false};
+  std::thread thread_receive_;
+
+  // Decoded frames, recycled once the UI dropped them.
+  SharedPool<CharsAndColors> frame_pool_;
+  std::shared_ptr<const CharsAndColors> frame_;
+  mutable std::mutex mutex_frame_;
+
+  std::vector<char> hello_;
+  std::mutex mutex_send_;
+
+  std::shared_ptr<spdlog::logger> logger_ = GetLogger("BroadcastClient");
+};
+
+} // namespace terminal_animation
@@ -0,0 +1,493 @@
+// header
+#include "broadcast_server.hpp"
+
+// local
+#include "common.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+#include <utility>
+
+#if defined(__linux__) || defined(__APPLE__)
+#define TERMINAL_ANIMATION_POSIX 1
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace terminal_animation {
+
+namespace {
+
+#ifdef TERMINAL_ANIMATION_POSIX
+
+#ifdef MSG_NOSIGNAL
+// A client that went away must not kill the server with SIGPIPE.
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+bool SetNonBlocking(int fd) {
+  const int flags = fcntl(fd, F_GETFL, 0);
+  return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0 &&
+         fcntl(fd, F_SETFD, FD_CLOEXEC) == 0;
+}
+
+// Fills address for path. Returns false if the path is too long for a
+// socket address.
+bool MakeSocketAddress(const std::filesystem::path &path,
+                       sockaddr_un &address) {
+  const std::string native = path.string();
+  if (native.empty() || native.size() >= sizeof(address.sun_path)) {
+    return false;
+  }
+  address = {};
+  address.sun_family = AF_UNIX;
+  std::memcpy(address.sun_path, native.c_str(), native.size() + 1);
+  return true;
+}
+
+// Creates directory, private to the user, if it is missing. Returns false
+// unless other users cannot put a socket of their own in it: it must be
+// owned by the user or root, and not writable by others unless sticky.
+bool PrepareSocketDirectory(const std::filesystem::path &directory) {
+  const std::string native = directory.empty() ? "." : directory.string();
+  if (mkdir(native.c_str(), 0700) != 0 && errno != EEXIST) {
+    return false;
+  }
+  struct stat info {};
+  if (stat(native.c_str(), &info) != 0 || !S_ISDIR(info.st_mode) ||
+      (info.st_uid != geteuid() && info.st_uid != 0)) {
+    return false;
+  }
+  return (info.st_mode & (S_IWGRP | S_IWOTH)) == 0 ||
+         (info.st_mode & S_ISVTX) != 0;
+}
+
+// Returns true if path is a socket owned by the user, as opposed to a file
+// that only happens to be at the socket path.
+bool IsOwnSocket(const std::filesystem::path &path) {
+  struct stat info {};
+  return lstat(path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode) &&
+         info.st_uid == geteuid();
+}
+
+#endif
+
+} // namespace
+
+BroadcastServer::BroadcastServer(FrameScheduler &scheduler,
+                                 std::filesystem::path file,
+                                 std::filesystem::path socket_path)
+    : scheduler_(scheduler), file_(std::move(file)),
+      socket_path_(std::move(socket_path)) {}
+
+BroadcastServer::~BroadcastServer() { Stop(); }
+
+bool BroadcastServer::Start() {
+  if (!IsMediaExtension(file_) || !std::filesystem::is_regular_file(file_)) {
+    logger_->error("[BroadcastServer::Start] Not a media file: {}",
+                   file_.string());
+    return false;
+  }
+
+#ifdef TERMINAL_ANIMATION_POSIX
+  sockaddr_un address{};
+  if (!MakeSocketAddress(socket_path_, address)) {
+    logger_->error("[BroadcastServer::Start] Socket path too long: {}",
+                   socket_path_.string());
+    return false;
+  }
+
+  if (!PrepareSocketDirectory(socket_path_.parent_path())) {
+    logger_->error("[BroadcastServer::Start] Directory of {} is missing or "
+                   "writable by other users",
+                   socket_path_.string());
+    return false;
+  }
+
+  // A socket file nobody accepts on was left behind by a server that did
+  // not shut down cleanly; one that accepts belongs to a running server.
+  std::error_code ec;
+  if (std::filesystem::exists(
+          std::filesystem::symlink_status(socket_path_, ec))) {
+    const int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    const bool in_use =
+        probe >= 0 && connect(probe, reinterpret_cast<sockaddr *>(&address),
+                              sizeof(address)) == 0;
+    if (probe >= 0) {
+      close(probe);
+    }
+    if (in_use) {
+      logger_->error("[BroadcastServer::Start] Another server is listening "
+                     "on {}",
+                     socket_path_.string());
+      return false;
+    }
+    // Anything but a socket of this user is not ours to remove.
+    if (!IsOwnSocket(socket_path_)) {
+      logger_->error("[BroadcastServer::Start] {} exists and is not a socket "
+                     "of this user",
+                     socket_path_.string());
+      return false;
+    }
+    std::filesystem::remove(socket_path_, ec);
+  }
+
+  listen_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listen_fd_ < 0 || !SetNonBlocking(listen_fd_) ||
+      bind(listen_fd_, reinterpret_cast<sockaddr *>(&address),
+           sizeof(address)) != 0 ||
+      listen(listen_fd_, 16) != 0 || pipe(wake_fds_) != 0 ||
+      !SetNonBlocking(wake_fds_[0]) || !SetNonBlocking(wake_fds_[1])) {
+    logger_->error("[BroadcastServer::Start] Could not listen on {}: {}",
+                   socket_path_.string(), std::strerror(errno));
+    Stop();
+    return false;
+  }
+
+  start_ = std::chrono::steady_clock::now();
+  should_run_.store(true);
+  thread_serve_ = std::thread(&BroadcastServer::Serve, this);
+  logger_->info("[BroadcastServer::Start] Serving {} on {}", file_.string(),
+                socket_path_.string());
+  return true;
+#else
+  logger_->error("[BroadcastServer::Start] Unix domain sockets are not "
+                 "supported on this platform");
+  return false;
+#endif
+}
+
+void BroadcastServer::Stop() {
+  should_run_.store(false);
+  Wake();
+  if (thread_serve_.joinable()) {
+    thread_serve_.join();
+  }
+
+#ifdef TERMINAL_ANIMATION_POSIX
+  for (const auto &client : clients_) {
+    CloseClient(*client);
+  }
+  clients_.clear();
+  for (const auto &[params, stream] : streams_) {
+    stream->media->SetContinueRendering(false);
+    scheduler_.Remove(stream->client);
+  }
+  streams_.clear();
+
+  if (listen_fd_ >= 0) {
+    close(listen_fd_);
+    listen_fd_ = -1;
+    std::error_code ec;
+    std::filesystem::remove(socket_path_, ec);
+  }
+  for (int &fd : wake_fds_) {
+    if (fd >= 0) {
+      close(fd);
+      fd = -1;
+    }
+  }
+#endif
+}
+
+void BroadcastServer::Wake() {
+#ifdef TERMINAL_ANIMATION_POSIX
+  if (wake_fds_[1] >= 0) {
+    const char byte = 0;
+    // A full pipe already wakes the thread.
+    [[maybe_unused]] const auto result = write(wake_fds_[1], &byte, 1);
+  }
+#endif
+}
+
+void BroadcastServer::Serve() {
+#ifdef TERMINAL_ANIMATION_POSIX
+  std::optional<std::chrono::milliseconds> timeout;
+  while (should_run_.load()) {
+    poll_fds_.clear();
+    poll_fds_.push_back({.fd = wake_fds_[0], .events = POLLIN, .revents = 0});
+    poll_fds_.push_back({.fd = listen_fd_, .events = POLLIN, .revents = 0});
+    for (const auto &client : clients_) {
+      const short events =
+          static_cast<short>(POLLIN | (client->sending ? POLLOUT : 0));
+      poll_fds_.push_back({.fd = client->fd, .events = events, .revents = 0});
+    }
+
+    const int timeout_ms =
+        timeout.has_value() ? static_cast<int>(timeout->count()) : -1;
+    if (poll(poll_fds_.data(), poll_fds_.size(), timeout_ms) < 0 &&
+        errno != EINTR) {
+      logger_->error("[BroadcastServer::Serve] poll() failed: {}",
+                     std::strerror(errno));
+      break;
+    }
+
+    if (poll_fds_[0].revents & POLLIN) {
+      std::array<char, 64> drain{};
+      while (read(wake_fds_[0], drain.data(), drain.size()) > 0) {
+      }
+    }
+    // Clients accepted below have no entry in poll_fds_ yet.
+    const std::size_t polled_clients = clients_.size();
+    if (poll_fds_[1].revents & POLLIN) {
+      AcceptClients();
+    }
+    for (std::size_t i = 0; i < polled_clients; ++i) {
+      const short revents = poll_fds_[i + 2].revents;
+      Client &client = *clients_[i];
+      if (revents & (POLLIN | POLLHUP | POLLERR)) {
+        ReadFromClient(client);
+      }
+      if (!client.closed && (revents & POLLOUT)) {
+        WriteToClient(client);
+      }
+    }
+
+    timeout = PublishFrames();
+    for (const auto &client : clients_) {
+      if (!client->closed && client->sending) {
+        WriteToClient(*client);
+      }
+    }
+
+    for (const auto &client : clients_) {
+      if (client->closed) {
+        Unsubscribe(*client);
+        CloseClient(*client);
+      }
+    }
+    std::erase_if(clients_,
+                  [](const auto &client) { return client->fd < 0; });
+  }
+#endif
+}
+
+bool BroadcastServer::StreamStep(Stream &stream) {
+  MediaToAscii &media = *stream.media;
+  if (!stream.is_open.load()) {
+    if (!media.OpenFile(file_)) {
+      stream.failed.store(true);
+      Wake();
+      return false;
+    }
+    stream.fps = media.GetFramerate();
+    stream.total_frames = std::max(1U, media.GetTotalFrameCount());
+    stream.is_open.store(true);
+    Wake();
+    return media.IsVideo();
+  }
+
+  return media.RenderVideoFrames(1) == 1 &&
+         media.GetCurrentFrameIndex() < media.GetTotalFrameCount();
+}
+
+void BroadcastServer::AcceptClients() {
+#ifdef TERMINAL_ANIMATION_POSIX
+  while (true) {
+    const int fd = accept(listen_fd_, nullptr, nullptr);
+    if (fd < 0) {
+      return;
+    }
+    if (clients_.size() >= kMaxClients || !SetNonBlocking(fd)) {
+      logger_->warn("[BroadcastServer::AcceptClients] Rejected a client, {} "
+                    "are connected",
+                    clients_.size());
+      close(fd);
+      continue;
+    }
+#ifdef SO_NOSIGPIPE
+    const int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+    auto &client = clients_.emplace_back(std::make_unique<Client>());
+    client->fd = fd;
+    logger_->info("[BroadcastServer::AcceptClients] Client connected, {} in "
+                  "total",
+                  clients_.size());
+  }
+#endif
+}
+
+void BroadcastServer::ReadFromClient(Client &client) {
+#ifdef TERMINAL_ANIMATION_POSIX
+  std::array<char, 4096> buffer{};
+  while (true) {
+    const auto received = recv(client.fd, buffer.data(), buffer.size(), 0);
+    if (received == 0 ||
+        (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK &&
+         errno != EINTR)) {
+      client.closed = true;
+      return;
+    }
+    if (received < 0) {
+      break;
+    }
+    client.reader.Append(buffer.data(), static_cast<std::size_t>(received));
+  }
+
+  while (client.reader.Next(client.message)) {
+    const auto params = client.message.type == MessageType::kHello
+                            ? DecodeHello(client.message.payload)
+                            : std::nullopt;
+    if (!params.has_value()) {
+      client.closed = true;
+      return;
+    }
+    Subscribe(client, *params);
+  }
+  if (client.reader.HasError()) {
+    client.closed = true;
+  }
+#endif
+}
+
+void BroadcastServer::WriteToClient(Client &client) {
+#ifdef TERMINAL_ANIMATION_POSIX
+  while (client.sending) {
+    const std::vector<char> &message = *client.sending;
+    const auto sent = send(client.fd, message.data() + client.sent,
+                           message.size() - client.sent, kSendFlags);
+    if (sent < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        client.closed = true;
+      }
+      return;
+    }
+    client.sent += static_cast<std::size_t>(sent);
+    if (client.sent == message.size()) {
+      client.sending = std::move(client.next);
+      client.next.reset();
+      client.sent = 0;
+    }
+  }
+#endif
+}
+
+void BroadcastServer::CloseClient(Client &client) {
+#ifdef TERMINAL_ANIMATION_POSIX
+  if (client.fd < 0) {
+    return;
+  }
+  close(client.fd);
+  client.fd = -1;
+  logger_->info("[BroadcastServer::CloseClient] Client disconnected, dropped "
+                "{} frames",
+                client.dropped_frames);
+#endif
+}
+
+void BroadcastServer::Subscribe(Client &client, const StreamParams &params) {
+  if (client.stream != nullptr && client.stream->params == params) {
+    return;
+  }
+  Unsubscribe(client);
+
+  auto &stream = streams_[params];
+  if (!stream) {
+    stream = std::make_unique<Stream>();
+    stream->params = params;
+    stream->media->SetSize(params.size);
+    stream->media->SetMonochrome(params.color_depth ==
+                                 ColorDepth::kMonochrome);
+    Stream *raw_stream = stream.get();
+    stream->client =
+        scheduler_.Add([this, raw_stream] { return StreamStep(*raw_stream); });
+    logger_->info("[BroadcastServer::Subscribe] Started a stream at size {}, "
+                  "{}",
+                  params.size,
+                  params.color_depth == ColorDepth::kMonochrome
+                      ? "monochrome"
+                      : "true color");
+  }
+  ++stream->subscribers;
+  client.stream = stream.get();
+  // Frames of the old stream no longer fit the client's screen.
+  client.next.reset();
+  if (stream->latest_message) {
+    Enqueue(client, stream->latest_message);
+  }
+}
+
+void BroadcastServer::Unsubscribe(Client &client) {
+  Stream *stream = std::exchange(client.stream, nullptr);
+  if (stream == nullptr || --stream->subscribers > 0) {
+    return;
+  }
+  stream->media->SetContinueRendering(false);
+  scheduler_.Remove(stream->client);
+  streams_.erase(stream->params);
+}
+
+void BroadcastServer::Enqueue(
+    Client &client, std::shared_ptr<const std::vector<char>> message) {
+  if (!client.sending) {
+    client.sending = std::move(message);
+    client.sent = 0;
+    return;
+  }
+  if (client.next) {
+    ++client.dropped_frames;
+  }
+  client.next = std::move(message);
+}
+
+std::optional<std::chrono::milliseconds> BroadcastServer::PublishFrames() {
+  const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start_);
+  std::optional<std::chrono::microseconds> next_frame;
+
+  for (const auto &[params, stream] : streams_) {
+    if (stream->failed.load()) {
+      // Disconnecting tells the clients; the stream goes with the last one.
+      for (const auto &client : clients_) {
+        client->closed = client->closed || client->stream == stream.get();
+      }
+      continue;
+    }
+    if (!stream->is_open.load()) {
+      continue;
+    }
+
+    std::uint32_t index = 0;
+    if (stream->media->IsVideo()) {
+      const auto frames = static_cast<std::uint64_t>(elapsed.count()) *
+                          stream->fps / 1'000'000;
+      index = static_cast<std::uint32_t>(frames % stream->total_frames);
+      const std::chrono::microseconds until_next(
+          static_cast<std::int64_t>((frames + 1) * 1'000'000 / stream->fps) -
+          elapsed.count());
+      next_frame = std::min(next_frame.value_or(until_next), until_next);
+    }
+    if (stream->published_index == index ||
+        !stream->media->GetCharsAndColors(index, stream->frame)) {
+      continue;
+    }
+
+    auto message = message_pool_.Acquire();
+    EncodeFrame(index, stream->frame, *message);
+    stream->latest_message = std::move(message);
+    stream->published_index = index;
+    for (const auto &client : clients_) {
+      if (client->stream == stream.get()) {
+        Enqueue(*client, stream->latest_message);
+      }
+    }
+  }
+
+  if (!next_frame.has_value()) {
+    return std::nullopt;
+  }
+  // Round up so the frame has started when poll() returns.
+  return std::chrono::ceil<std::chrono::milliseconds>(*next_frame);
+}
+
+} // namespace terminal_animation
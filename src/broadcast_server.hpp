@@ -0,0 +1,148 @@
+#pragma once
+
+// local
+#include "frame_protocol.hpp"
+#include "frame_scheduler.hpp"
+#include "logger.hpp"
+#include "media_to_ascii.hpp"
+#include "shared_pool.hpp"
+
+// std
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <poll.h>
+#endif
+
+namespace terminal_animation {
+
+// Plays one media file and streams the converted frames to clients over a
+// Unix domain socket (see frame_protocol.hpp). Clients that ask for the
+// same size and color depth share one conversion, which runs as a
+// FrameScheduler client like a mosaic pane. Every frame is encoded once and
+// the same buffer is sent to all of its clients. All clients see the same
+// moment of the video, given by the time since Start().
+//
+// A single thread accepts clients and does all socket I/O without blocking.
+// A client that cannot keep up is sent the latest frame once the frame it is
+// receiving is complete; the frames in between are dropped, so one slow
+// client never holds up the server or the other clients.
+class BroadcastServer {
+public:
+  static constexpr std::size_t kMaxClients = 64;
+
+  BroadcastServer(FrameScheduler &scheduler, std::filesystem::path file,
+                  std::filesystem::path socket_path);
+
+  // Stops serving. Must be destroyed before the scheduler.
+  ~BroadcastServer();
+
+  BroadcastServer(const BroadcastServer &) = delete;
+  BroadcastServer &operator=(const BroadcastServer &) = delete;
+
+  // Creates the socket and starts serving. Fails if the file is not a
+  // media file, the socket cannot be created, another server is listening
+  // on it, or Unix domain sockets are not available.
+  bool Start();
+
+  // Disconnects every client, stops the conversions and removes the
+  // socket.
+  void Stop();
+
+private:
+  // One conversion, shared by every client with the same parameters.
+  struct Stream {
+    StreamParams params;
+    std::shared_ptr<MediaToAscii> media = std::make_shared<MediaToAscii>();
+    FrameScheduler::ClientId client = 0;
+    std::atomic<bool> is_open{false};
+    std::atomic<bool> failed{false};
+    // Written once before is_open is set.
+    std::uint32_t fps = 1;
+    std::uint32_t total_frames = 1;
+    // Only touched by the serve thread.
+    std::size_t subscribers = 0;
+    std::optional<std::uint32_t> published_index;
+    std::shared_ptr<const std::vector<char>> latest_message;
+    CharsAndColors frame;
+  };
+
+  // Only touched by the serve thread.
+  struct Client {
+    int fd = -1;
+    MessageReader reader;
+    Message message;
+    Stream *stream = nullptr;
+    // The message being sent and how much of it is out, and the newest
+    // message waiting behind it.
+    std::shared_ptr<const std::vector<char>> sending;
+    std::size_t sent = 0;
+    std::shared_ptr<const std::vector<char>> next;
+    std::uint64_t dropped_frames = 0;
+    bool closed = false;
+  };
+
+  // Serve thread entry.
+  void Serve();
+
+  // One scheduler step of a stream: opens the file first, then converts one
+  // frame per step until the whole video is converted.
+  bool StreamStep(Stream &stream);
+
+  void AcceptClients();
+  // Reads and handles the client's messages. Marks it closed on EOF, error
+  // or a protocol violation.
+  void ReadFromClient(Client &client);
+  // Sends as much as the socket takes without blocking.
+  void WriteToClient(Client &client);
+  void CloseClient(Client &client);
+
+  // Moves client to the stream for params, creating it if needed.
+  void Subscribe(Client &client, const StreamParams &params);
+  // Leaves the client's stream, removing it when nobody is left.
+  void Unsubscribe(Client &client);
+
+  // Queues message behind the one being sent, replacing an older queued
+  // message.
+  static void Enqueue(Client &client,
+                      std::shared_ptr<const std::vector<char>> message);
+
+  // Encodes and queues the current frame of every stream whose frame
+  // changed. Returns the time until the next frame of any video stream, or
+  // nullopt if only still images are streamed.
+  std::optional<std::chrono::milliseconds> PublishFrames();
+
+  // Interrupts the serve thread's poll().
+  void Wake();
+
+  FrameScheduler &scheduler_;
+  std::filesystem::path file_;
+  std::filesystem::path socket_path_;
+
+  std::map<StreamParams, std::unique_ptr<Stream>> streams_;
+  std::vector<std::unique_ptr<Client>> clients_;
+  // Encoded frames, shared by every client of a stream until sent.
+  SharedPool<std::vector<char>> message_pool_;
+#if defined(__linux__) || defined(__APPLE__)
+  std::vector<pollfd> poll_fds_;
+#endif
+
+  std::chrono::steady_clock::time_point start_;
+  std::atomic<bool> should_run_{false};
+  int listen_fd_ = -1;
+  // Read and write end of the pipe that wakes the serve thread.
+  int wake_fds_[2] = {-1, -1};
+  std::thread thread_serve_;
+
+  std::shared_ptr<spdlog::logger> logger_ = GetLogger("BroadcastServer");
+};
+
+} // namespace terminal_animation
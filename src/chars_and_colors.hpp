@@ -0,0 +1,21 @@
+#pragma once
+
+// std
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace terminal_animation {
+
+// Per-character RGB color and ASCII character for one frame of output,
+// stored row-major: the cell in column x and row y is at y * columns + x,
+// matching the order of terminal cells. colors is empty for frames
+// converted in monochrome.
+struct CharsAndColors {
+  std::uint32_t columns = 0;
+  std::uint32_t rows = 0;
+  std::vector<std::array<std::uint8_t, 3>> colors;
+  std::vector<char> chars;
+};
+
+} // namespace terminal_animation
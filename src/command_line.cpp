@@ -0,0 +1,147 @@
+// header
+#include "command_line.hpp"
+
+// std
+#include <charconv>
+#include <cstdlib>
+#include <string>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace terminal_animation {
+
+namespace {
+
+// Parses the whole of text as a number greater than zero.
+std::optional<std::uint32_t> ParsePositive(const std::string &text) {
+  std::uint32_t value = 0;
+  const auto [end, error] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  if (error != std::errc() || end != text.data() + text.size() ||
+      value == 0) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+} // namespace
+
+std::filesystem::path GetDefaultSocketPath() {
+  constexpr std::string_view kSocketName = "terminal_animation.sock";
+#ifdef _WIN32
+  return std::filesystem::temp_directory_path() / kSocketName;
+#else
+  // The runtime directory is private to the user. Without one, the server
+  // creates a per-user directory with mode 0700 in the temp directory.
+  const char *runtime = std::getenv("XDG_RUNTIME_DIR");
+  if (runtime != nullptr && std::filesystem::path(runtime).is_absolute()) {
+    return std::filesystem::path(runtime) / kSocketName;
+  }
+  return std::filesystem::temp_directory_path() /
+         ("terminal_animation-" + std::to_string(geteuid())) / kSocketName;
+#endif
+}
+
+std::optional<CommandLine>
+ParseCommandLine(const std::vector<std::string> &args) {
+  CommandLine command_line;
+  bool has_socket = false;
+  bool has_client_option = false;
+  bool has_interactive_option = false;
+  bool has_converter_option = false;
+
+  for (const std::string &arg : args) {
+    const auto equals = arg.find('=');
+    const std::string key = arg.substr(0, equals);
+    const std::string value =
+        equals == std::string::npos ? std::string() : arg.substr(equals + 1);
+    const bool has_value = equals != std::string::npos;
+
+    if (!arg.empty() && !arg.starts_with("--")) {
+      if (!command_line.file.empty()) {
+        return std::nullopt;
+      }
+      command_line.file = arg;
+      has_interactive_option = true;
+    } else if (key == "--serve" && has_value && !value.empty()) {
+      if (command_line.mode != CommandLine::Mode::kInteractive ||
+          !command_line.file.empty()) {
+        return std::nullopt;
+      }
+      command_line.mode = CommandLine::Mode::kServe;
+      command_line.file = value;
+    } else if (key == "--connect" && !has_value) {
+      if (command_line.mode != CommandLine::Mode::kInteractive) {
+        return std::nullopt;
+      }
+      command_line.mode = CommandLine::Mode::kConnect;
+    } else if (key == "--socket" && has_value && !value.empty()) {
+      command_line.socket = value;
+      has_socket = true;
+    } else if (key == "--size" && has_value) {
+      const auto size = ParsePositive(value);
+      if (!size.has_value()) {
+        return std::nullopt;
+      }
+      command_line.size = *size;
+      has_client_option = true;
+    } else if (key == "--fps" && has_value) {
+      const auto fps = ParsePositive(value);
+      if (!fps.has_value()) {
+        return std::nullopt;
+      }
+      command_line.sequence_fps = *fps;
+      has_interactive_option = true;
+    } else if ((key == "--record" || key == "--replay") && has_value &&
+               !value.empty()) {
+      if (!command_line.record_file.empty() ||
+          !command_line.replay_file.empty()) {
+        return std::nullopt;
+      }
+      (key == "--record" ? command_line.record_file
+                         : command_line.replay_file) = value;
+      has_interactive_option = true;
+    } else if (key == "--no-thumbnail-cache" && !has_value) {
+      command_line.thumbnail_cache = false;
+      has_interactive_option = true;
+    } else if (key == "--charset" && has_value) {
+      const auto glyphs = ParseCharset(value);
+      if (!glyphs.has_value()) {
+        return std::nullopt;
+      }
+      command_line.glyphs = *glyphs;
+      has_converter_option = true;
+    } else if (key == "--stabilize" && has_value) {
+      const auto threshold = ParsePositive(value);
+      if (!threshold.has_value() || *threshold > 255) {
+        return std::nullopt;
+      }
+      command_line.stabilize_threshold =
+          static_cast<std::uint8_t>(*threshold);
+      has_converter_option = true;
+    } else if (key == "--monochrome" && !has_value) {
+      command_line.monochrome = true;
+      has_client_option = true;
+    } else {
+      return std::nullopt;
+    }
+  }
+
+  if ((has_socket && command_line.mode == CommandLine::Mode::kInteractive) ||
+      (has_interactive_option &&
+       command_line.mode != CommandLine::Mode::kInteractive) ||
+      (has_client_option &&
+       command_line.mode != CommandLine::Mode::kConnect) ||
+      (has_converter_option &&
+       command_line.mode == CommandLine::Mode::kConnect)) {
+    return std::nullopt;
+  }
+  if (!has_socket) {
+    command_line.socket = GetDefaultSocketPath();
+  }
+  return command_line;
+}
+
+} // namespace terminal_animation
@@ -0,0 +1,72 @@
+#pragma once
+
+// local
+#include "glyph_table.hpp"
+#include "image_sequence.hpp"
+
+// std
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace terminal_animation {
+
+inline constexpr std::string_view kUsage =
+    "Usage: terminal_animation [--fps=N] [--charset=NAME|CHARS]\n"
+    "                          [--stabilize=N] [--no-thumbnail-cache]\n"
+    "                          [--record=EVENTS | --replay=EVENTS]\n"
+    "                          [FILE | DIRECTORY | PATTERN]\n"
+    "       terminal_animation --serve=FILE [--socket=PATH] "
+    "[--charset=NAME|CHARS]\n"
+    "                          [--stabilize=N]\n"
+    "       terminal_animation --connect [--socket=PATH] [--size=N] "
+    "[--monochrome]\n";
+
+// Options given on the command line.
+struct CommandLine {
+  enum class Mode {
+    // The interactive player.
+    kInteractive,
+    // Plays file and streams converted frames to clients over socket.
+    kServe,
+    // Shows the frames streamed by a server.
+    kConnect,
+  };
+
+  Mode mode = Mode::kInteractive;
+  // The file to serve, or to open at start in the interactive player. A
+  // directory or a pattern such as frame_%05d.png is an image sequence.
+  std::filesystem::path file;
+  // Frame rate the interactive player plays image sequences at.
+  std::uint32_t sequence_fps = kDefaultSequenceFramerate;
+  // The interactive player records its input events to record_file, or
+  // replays those of replay_file without a terminal.
+  std::filesystem::path record_file;
+  std::filesystem::path replay_file;
+  // Whether the interactive player keeps thumbnails on disk across runs.
+  bool thumbnail_cache = true;
+  // Glyphs frames are drawn with, in the player and the server.
+  GlyphTable glyphs = kDensityGlyphs;
+  // Threshold of the temporal filter video frames are converted with, in
+  // 8-bit luminance and color steps; 0 turns it off.
+  std::uint8_t stabilize_threshold = 0;
+  std::filesystem::path socket;
+  // Conversion parameters a client asks the server for.
+  std::uint32_t size = 32;
+  bool monochrome = false;
+};
+
+// Returns the socket the server listens on when --socket is not given:
+// terminal_animation.sock in $XDG_RUNTIME_DIR, or else in a per-user
+// directory in the temp directory.
+std::filesystem::path GetDefaultSocketPath();
+
+// Parses the arguments after the program name. Returns nullopt on unknown
+// or malformed arguments and on options that do not apply to the mode.
+std::optional<CommandLine>
+ParseCommandLine(const std::vector<std::string> &args);
+
+} // namespace terminal_animation
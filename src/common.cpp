@@ -4,17 +4,26 @@
 // std
 #include <algorithm>
 #include <cctype>
+#include <cmath>
 #include <cstdlib>
+#include <array>
 #include <filesystem>
+#include <fstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace terminal_animation {
 
-bool IsImageExtension(const std::filesystem::path &path) {
+namespace {
+
+template <std::size_t N>
+bool HasExtension(const std::filesystem::path &path,
+                  const std::string_view (&extensions)[N]) {
   std::string ext = path.extension().string();
   std::transform(ext.begin(), ext.end(), ext.begin(),
                  [](unsigned char c) { return std::tolower(c); });
-  for (const auto &known : kImageExtensions) {
+  for (const auto &known : extensions) {
     if (ext == known) {
       return true;
     }
@@ -22,6 +31,247 @@ bool IsImageExtension(const std::filesystem::path &path) {
   return false;
 }
 
+} // namespace
+
+bool IsImageExtension(const std::filesystem::path &path) {
+  return HasExtension(path, kImageExtensions);
+}
+
+bool IsVideoExtension(const std::filesystem::path &path) {
+  return HasExtension(path, kVideoExtensions);
+}
+
+bool IsRawVideoExtension(const std::filesystem::path &path) {
+  return HasExtension(path, kRawVideoExtensions);
+}
+
+bool IsGifExtension(const std::filesystem::path &path) {
+  static constexpr std::string_view kGifExtension[] = {".gif"};
+  return HasExtension(path, kGifExtension);
+}
+
+bool IsMediaExtension(const std::filesystem::path &path) {
+  return IsImageExtension(path) || IsVideoExtension(path) ||
+         IsRawVideoExtension(path);
+}
+
+namespace {
+
+std::uint32_t ReadBigEndian(const unsigned char *bytes, std::size_t count) {
+  std::uint32_t value = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    value = (value << 8) | bytes[i];
+  }
+  return value;
+}
+
+std::uint32_t ReadLittleEndian(const unsigned char *bytes, std::size_t count) {
+  std::uint32_t value = 0;
+  for (std::size_t i = count; i > 0; --i) {
+    value = (value << 8) | bytes[i - 1];
+  }
+  return value;
+}
+
+std::optional<ImageDimensions> ReadJpegDimensions(std::ifstream &file) {
+  // Walk the marker segments until a start-of-frame (SOFn) segment.
+  std::array<unsigned char, 7> buffer{};
+  while (file) {
+    int byte = file.get();
+    if (byte != 0xFF) {
+      return std::nullopt;
+    }
+    // Markers may be preceded by any number of 0xFF fill bytes.
+    while (byte == 0xFF) {
+      byte = file.get();
+    }
+    const int marker = byte;
+    if (marker == EOF || marker == 0xD9 || marker == 0xDA) {
+      return std::nullopt;
+    }
+    // Standalone markers without a length field.
+    if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) {
+      continue;
+    }
+
+    if (!file.read(reinterpret_cast<char *>(buffer.data()), 2)) {
+      return std::nullopt;
+    }
+    const std::uint32_t length = ReadBigEndian(buffer.data(), 2);
+    if (length < 2) {
+      return std::nullopt;
+    }
+
+    const bool is_start_of_frame = marker >= 0xC0 && marker <= 0xCF &&
+                                   marker != 0xC4 && marker != 0xC8 &&
+                                   marker != 0xCC;
+    if (is_start_of_frame) {
+      // precision (1), height (2), width (2)
+      if (!file.read(reinterpret_cast<char *>(buffer.data()), 5)) {
+        return std::nullopt;
+      }
+      return ImageDimensions{.width = ReadBigEndian(buffer.data() + 3, 2),
+                             .height = ReadBigEndian(buffer.data() + 1, 2)};
+    }
+    file.seekg(length - 2, std::ios::cur);
+  }
+  return std::nullopt;
+}
+
+} // namespace
+
+std::optional<ImageDimensions>
+ReadImageDimensions(const std::filesystem::path &path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return std::nullopt;
+  }
+
+  std::array<unsigned char, 26> header{};
+  file.read(reinterpret_cast<char *>(header.data()), 2);
+  if (file.gcount() != 2) {
+    return std::nullopt;
+  }
+
+  // JPEG: SOI marker, dimensions live in the first SOFn segment.
+  if (header[0] == 0xFF && header[1] == 0xD8) {
+    return ReadJpegDimensions(file);
+  }
+
+  file.read(reinterpret_cast<char *>(header.data()) + 2, header.size() - 2);
+  if (file.gcount() != static_cast<std::streamsize>(header.size() - 2)) {
+    return std::nullopt;
+  }
+
+  // PNG: signature followed by the IHDR chunk.
+  constexpr std::array<unsigned char, 8> kPngSignature = {
+      0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  if (std::equal(kPngSignature.begin(), kPngSignature.end(), header.begin()) &&
+      std::string_view(reinterpret_cast<const char *>(header.data()) + 12,
+                       4) == "IHDR") {
+    return ImageDimensions{.width = ReadBigEndian(header.data() + 16, 4),
+                           .height = ReadBigEndian(header.data() + 20, 4)};
+  }
+
+  // BMP: BITMAPINFOHEADER, height is negative for top-down bitmaps.
+  if (header[0] == 'B' && header[1] == 'M') {
+    const auto width =
+        static_cast<std::int32_t>(ReadLittleEndian(header.data() + 18, 4));
+    const auto height =
+        static_cast<std::int32_t>(ReadLittleEndian(header.data() + 22, 4));
+    return ImageDimensions{
+        .width = static_cast<std::uint32_t>(width < 0 ? -width : width),
+        .height = static_cast<std::uint32_t>(height < 0 ? -height : height)};
+  }
+
+  return std::nullopt;
+}
+
+std::uint32_t ChooseImageReduction(const ImageDimensions &dimensions,
+                                   std::uint32_t size) {
+  // A cell covers shorter_side / size rows and shorter_side / (2 * size)
+  // columns of the source, so the column count is the binding constraint.
+  const std::uint64_t shorter_side =
+      std::min(dimensions.width, dimensions.height);
+  const std::uint64_t needed =
+      2ULL * kMinPixelsPerCell * std::max<std::uint64_t>(1, size);
+
+  std::uint32_t reduction = 8;
+  while (reduction > 1 && shorter_side < needed * reduction) {
+    reduction /= 2;
+  }
+  return reduction;
+}
+
+ZoomView ClampZoomView(ZoomView view) {
+  view.zoom = std::clamp(view.zoom, 1U, kMaxZoom);
+  const double half_extent = 0.5 / view.zoom;
+  view.center_x = std::clamp(view.center_x, half_extent, 1.0 - half_extent);
+  view.center_y = std::clamp(view.center_y, half_extent, 1.0 - half_extent);
+  return view;
+}
+
+CropRect ComputeZoomCrop(std::uint32_t width, std::uint32_t height,
+                         const ZoomView &view) {
+  if (width == 0 || height == 0) {
+    return {};
+  }
+
+  const ZoomView clamped = ClampZoomView(view);
+  CropRect crop;
+  crop.width = std::max(1U, width / clamped.zoom);
+  crop.height = std::max(1U, height / clamped.zoom);
+
+  // Rounding can still push the region past the edge by a pixel.
+  const auto place = [](double center, std::uint32_t extent,
+                        std::uint32_t length) {
+    const long long start = std::llround(center * extent - length / 2.0);
+    return static_cast<std::uint32_t>(
+        std::clamp<long long>(start, 0, extent - length));
+  };
+  crop.x = place(clamped.center_x, width, crop.width);
+  crop.y = place(clamped.center_y, height, crop.height);
+  return crop;
+}
+
+GridShape ComputeMosaicGrid(std::size_t count) {
+  if (count == 0) {
+    return {};
+  }
+  GridShape grid;
+  grid.columns = 1;
+  while (static_cast<std::size_t>(grid.columns) * grid.columns < count) {
+    ++grid.columns;
+  }
+  grid.rows = static_cast<std::uint32_t>((count + grid.columns - 1) /
+                                         grid.columns);
+  return grid;
+}
+
+GridGeometry ComputeGridGeometry(const ImageDimensions &frame,
+                                 std::uint32_t size) {
+  if (frame.width == 0 || frame.height == 0) {
+    return {};
+  }
+  const float aspect_ratio =
+      static_cast<float>(frame.height) / static_cast<float>(frame.width);
+  const std::uint32_t current_size = std::max(1U, size);
+
+  // Scale X for FTXUI's 2x4 character cell geometry.
+  GridGeometry geometry;
+  geometry.block_width = std::max(
+      1U, frame.width / std::max(1U, static_cast<std::uint32_t>(
+                                         current_size * 2 / aspect_ratio)));
+  geometry.block_height = std::max(1U, frame.height / current_size);
+  geometry.columns = frame.width / geometry.block_width;
+  geometry.rows = frame.height / geometry.block_height;
+  return geometry;
+}
+
+std::uint32_t FitPaneSize(std::uint32_t cell_columns, std::uint32_t cell_rows,
+                          const ImageDimensions &frame) {
+  if (frame.width == 0 || frame.height == 0) {
+    return std::max(1U, cell_rows);
+  }
+  // The grid has at least size rows and size * 2 * width / height columns,
+  // rounded down, so no larger size can fit. Rounding to whole blocks can
+  // still overflow the cell, so walk down from there to the first size
+  // whose exact grid fits.
+  const std::uint64_t width_limit =
+      (static_cast<std::uint64_t>(cell_columns) + 1) * frame.height /
+          (2ULL * frame.width) +
+      1;
+  auto size = static_cast<std::uint32_t>(
+      std::min<std::uint64_t>(cell_rows, width_limit));
+  for (; size > 1; --size) {
+    const GridGeometry geometry = ComputeGridGeometry(frame, size);
+    if (geometry.columns <= cell_columns && geometry.rows <= cell_rows) {
+      break;
+    }
+  }
+  return std::max(1U, size);
+}
+
 std::filesystem::path GetHomeDirectory() {
 #ifdef _WIN32
   const char *home = std::getenv("USERPROFILE");
@@ -38,6 +288,47 @@ std::filesystem::path GetHomeDirectory() {
   return std::filesystem::current_path();
 }
 
+std::filesystem::path GetCacheDirectory() {
+#ifdef _WIN32
+  const char *cache = std::getenv("LOCALAPPDATA");
+#else
+  const char *cache = std::getenv("XDG_CACHE_HOME");
+#endif
+  if (cache != nullptr && *cache != '\0') {
+    return std::filesystem::path(cache) / "terminal_animation";
+  }
+  return GetHomeDirectory() / ".cache" / "terminal_animation";
+}
+
+std::size_t TrimDirectory(const std::filesystem::path &directory,
+                          std::size_t max_files) {
+  std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::path>>
+      files;
+  std::error_code ec;
+  for (const auto &entry : std::filesystem::directory_iterator(directory, ec)) {
+    std::error_code entry_ec;
+    if (!entry.is_regular_file(entry_ec)) {
+      continue;
+    }
+    const auto modified = entry.last_write_time(entry_ec);
+    if (!entry_ec) {
+      files.emplace_back(modified, entry.path());
+    }
+  }
+  if (files.size() <= max_files) {
+    return 0;
+  }
+
+  const auto excess = static_cast<std::ptrdiff_t>(files.size() - max_files);
+  std::nth_element(files.begin(), files.begin() + excess, files.end());
+  std::size_t removed = 0;
+  for (auto it = files.begin(); it != files.begin() + excess; ++it) {
+    // Another process may have removed it already.
+    removed += std::filesystem::remove(it->second, ec) ? 1 : 0;
+  }
+  return removed;
+}
+
 std::vector<std::filesystem::path>
 ListDirectoryEntries(const std::filesystem::path &directory) {
   std::vector<std::filesystem::path> entries;
@@ -2,8 +2,10 @@
 
 // std
 #include <algorithm>
+#include <bit>
 #include <cstdint>
 #include <filesystem>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -20,6 +22,28 @@ constexpr T MapValue(T x, T old_min, T old_max, T new_min, T new_max) {
   return new_min + (x - old_min) * (new_max - new_min) / (old_max - old_min);
 }
 
+// Divides by a divisor fixed up front with a multiply and a shift, for hot
+// loops that would otherwise divide per element. Exact for dividends up to
+// 255 * divisor, i.e. sums of divisor 8-bit values, while the divisor is
+// below 2^24; larger divisors may round down one too far.
+class ReciprocalDivider {
+public:
+  // divisor must not be 0.
+  explicit constexpr ReciprocalDivider(std::uint32_t divisor)
+      // 255 * divisor^2 < 2^shift_ keeps the rounding error below one.
+      : shift_(std::min(
+            56U, 2 * static_cast<std::uint32_t>(std::bit_width(divisor)) + 8)),
+        multiplier_((std::uint64_t{1} << shift_) / divisor + 1) {}
+
+  constexpr std::uint32_t operator()(std::uint64_t dividend) const {
+    return static_cast<std::uint32_t>((dividend * multiplier_) >> shift_);
+  }
+
+private:
+  std::uint32_t shift_;
+  std::uint64_t multiplier_;
+};
+
 // ASCII density characters ordered from visually dense (dark) to sparse (bright).
 inline constexpr std::string_view kAsciiDensity =
     "$@B%8&WM#*oahkbdpqwmZO0QLCJUYXzcvunxrjft/"
@@ -30,12 +54,135 @@ inline constexpr std::string_view kImageExtensions[] = {
     ".jpg", ".jpeg", ".png", ".bmp", ".webp", ".tiff", ".tif",
 };
 
+// Known video/animation container extensions (lowercase).
+inline constexpr std::string_view kVideoExtensions[] = {
+    ".mp4", ".m4v", ".mkv", ".webm", ".avi", ".mov",
+    ".wmv", ".flv", ".mpg", ".mpeg", ".ts",  ".gif",
+};
+
+// Uncompressed video read by RawVideoReader instead of a decoder: Y4M, and
+// headerless frames whose dimensions are in the file name (lowercase).
+inline constexpr std::string_view kRawVideoExtensions[] = {
+    ".y4m", ".yuv", ".gray", ".bgr", ".rgb",
+};
+
 // Returns true if the path has a recognized image extension (case-insensitive).
 bool IsImageExtension(const std::filesystem::path &path);
 
+// Returns true if the path has a recognized video extension (case-insensitive).
+bool IsVideoExtension(const std::filesystem::path &path);
+
+// Returns true if the path has a raw video extension (case-insensitive).
+bool IsRawVideoExtension(const std::filesystem::path &path);
+
+// Returns true if the path has a .gif extension (case-insensitive).
+bool IsGifExtension(const std::filesystem::path &path);
+
+// Returns true if the path is an image or video the player can open.
+bool IsMediaExtension(const std::filesystem::path &path);
+
+// Pixel dimensions of an image as stored in its file header.
+struct ImageDimensions {
+  std::uint32_t width = 0;
+  std::uint32_t height = 0;
+};
+
+// Reads the dimensions of a PNG, JPEG or BMP image from its header without
+// decoding it. Returns std::nullopt for other formats or unreadable files.
+std::optional<ImageDimensions>
+ReadImageDimensions(const std::filesystem::path &path);
+
+// Minimum number of source pixels per character cell along each axis that a
+// reduced decode must keep, so block averaging still has data to smooth.
+inline constexpr std::uint32_t kMinPixelsPerCell = 2;
+
+// Returns the largest decode reduction factor (1, 2, 4 or 8) that still
+// leaves at least kMinPixelsPerCell pixels per cell when an image of the
+// given dimensions is converted at the given size. The image's shorter side
+// is used so the choice also holds if EXIF orientation swaps the axes.
+std::uint32_t ChooseImageReduction(const ImageDimensions &dimensions,
+                                   std::uint32_t size);
+
+inline constexpr std::uint32_t kMaxZoom = 16;
+
+// Zoom level and pan position of the part of a frame that is shown. The
+// center is given in normalized [0, 1] frame coordinates.
+struct ZoomView {
+  std::uint32_t zoom = 1;
+  double center_x = 0.5;
+  double center_y = 0.5;
+
+  bool operator==(const ZoomView &) const = default;
+};
+
+// Pixel rectangle within a frame.
+struct CropRect {
+  std::uint32_t x = 0;
+  std::uint32_t y = 0;
+  std::uint32_t width = 0;
+  std::uint32_t height = 0;
+
+  bool operator==(const CropRect &) const = default;
+};
+
+// Clamps the zoom to [1, kMaxZoom] and moves the center so the zoomed region
+// lies entirely inside the frame.
+ZoomView ClampZoomView(ZoomView view);
+
+// Returns the region of a width x height frame shown by view. The region
+// keeps the frame's aspect ratio and is at least 1x1 for non-empty frames.
+CropRect ComputeZoomCrop(std::uint32_t width, std::uint32_t height,
+                         const ZoomView &view);
+
+// Columns and rows of a mosaic grid.
+struct GridShape {
+  std::uint32_t columns = 0;
+  std::uint32_t rows = 0;
+
+  bool operator==(const GridShape &) const = default;
+};
+
+// Returns the most square grid with room for count panes, preferring extra
+// columns over extra rows since terminals are wider than tall.
+GridShape ComputeMosaicGrid(std::size_t count);
+
+// Character grid a frame is converted to, and the source pixels each
+// character averages.
+struct GridGeometry {
+  std::uint32_t block_width = 0;
+  std::uint32_t block_height = 0;
+  std::uint32_t columns = 0;
+  std::uint32_t rows = 0;
+
+  bool operator==(const GridGeometry &) const = default;
+};
+
+// Returns the grid a frame of the given dimensions is converted to at the
+// given size (number of character rows). Each character covers twice as
+// many source rows as columns. Since blocks are whole pixels, the grid can
+// have a few more rows and columns than the size asks for.
+GridGeometry ComputeGridGeometry(const ImageDimensions &frame,
+                                 std::uint32_t size);
+
+// Returns the largest size at which the grid of a frame of the given
+// dimensions fits into a cell of cell_columns x cell_rows characters, but
+// at least 1.
+std::uint32_t FitPaneSize(std::uint32_t cell_columns, std::uint32_t cell_rows,
+                          const ImageDimensions &frame);
+
 // Returns the platform-appropriate home directory, or falls back to cwd.
 std::filesystem::path GetHomeDirectory();
 
+// Returns the per-user cache directory of this program:
+// $XDG_CACHE_HOME/terminal_animation, ~/.cache/terminal_animation, or
+// %LOCALAPPDATA%\terminal_animation on Windows. The directory is not created.
+std::filesystem::path GetCacheDirectory();
+
+// Deletes the least recently modified regular files of directory until at
+// most max_files are left. Returns the number of files deleted.
+std::size_t TrimDirectory(const std::filesystem::path &directory,
+                          std::size_t max_files);
+
 // Lists non-hidden entries in a directory. Returns empty on error.
 std::vector<std::filesystem::path>
 ListDirectoryEntries(const std::filesystem::path &directory);
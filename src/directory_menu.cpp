@@ -0,0 +1,157 @@
+// header
+#include "directory_menu.hpp"
+
+// libs
+// FTXUI
+#include <ftxui/component/component_base.hpp>
+#include <ftxui/component/event.hpp>
+#include <ftxui/component/mouse.hpp>
+#include <ftxui/dom/elements.hpp>
+#include <ftxui/screen/box.hpp>
+#include <ftxui/screen/terminal.hpp>
+
+// std
+#include <algorithm>
+#include <utility>
+
+namespace terminal_animation {
+
+namespace {
+
+class DirectoryMenuBase : public ftxui::ComponentBase {
+public:
+  explicit DirectoryMenuBase(DirectoryMenuOption options)
+      : options_(std::move(options)) {}
+
+  ftxui::Element Render() override {
+    const int size = static_cast<int>(options_.size());
+    const int selected = ClampSelected(size);
+    const int visible = VisibleRows();
+
+    // Scroll just enough to keep the selection in view.
+    if (selected < first_visible_) {
+      first_visible_ = selected;
+    } else if (selected >= first_visible_ + visible) {
+      first_visible_ = selected - visible + 1;
+    }
+    first_visible_ =
+        std::clamp(first_visible_, 0, std::max(0, size - visible));
+
+    ftxui::Elements rows;
+    const int last = std::min(size, first_visible_ + visible);
+    rows.reserve(static_cast<std::size_t>(std::max(0, last - first_visible_)));
+    for (int i = first_visible_; i < last; ++i) {
+      auto row = ftxui::text(options_.label(static_cast<std::size_t>(i)));
+      if (i == selected) {
+        row = row | ftxui::inverted |
+              (Focused() ? ftxui::focus : ftxui::select);
+      }
+      rows.push_back(std::move(row));
+    }
+    return ftxui::vbox(std::move(rows)) | ftxui::reflect(box_);
+  }
+
+  bool OnEvent(ftxui::Event event) override {
+    if (event.is_mouse()) {
+      return OnMouseEvent(event);
+    }
+    if (!Focused()) {
+      return false;
+    }
+
+    const int size = static_cast<int>(options_.size());
+    const int page = std::max(1, VisibleRows() - 1);
+    const int selected = ClampSelected(size);
+
+    if (event == ftxui::Event::Return) {
+      if (options_.on_enter) {
+        options_.on_enter();
+      }
+      return true;
+    }
+
+    int next = selected;
+    if (event == ftxui::Event::ArrowUp) {
+      next = selected - 1;
+    } else if (event == ftxui::Event::ArrowDown) {
+      next = selected + 1;
+    } else if (event == ftxui::Event::PageUp) {
+      next = selected - page;
+    } else if (event == ftxui::Event::PageDown) {
+      next = selected + page;
+    } else if (event == ftxui::Event::Home) {
+      next = 0;
+    } else if (event == ftxui::Event::End) {
+      next = size - 1;
+    } else {
+      return false;
+    }
+
+    Select(next, size);
+    return true;
+  }
+
+  bool Focusable() const final { return true; }
+
+private:
+  bool OnMouseEvent(ftxui::Event event) {
+    const auto &mouse = event.mouse();
+    if (!box_.Contain(mouse.x, mouse.y) || !CaptureMouse(event)) {
+      return false;
+    }
+
+    const int size = static_cast<int>(options_.size());
+    if (mouse.button == ftxui::Mouse::WheelUp) {
+      Select(ClampSelected(size) - 1, size);
+      return true;
+    }
+    if (mouse.button == ftxui::Mouse::WheelDown) {
+      Select(ClampSelected(size) + 1, size);
+      return true;
+    }
+    if (mouse.button == ftxui::Mouse::Left &&
+        mouse.motion == ftxui::Mouse::Pressed) {
+      TakeFocus();
+      Select(first_visible_ + mouse.y - box_.y_min, size);
+      return true;
+    }
+    return false;
+  }
+
+  // Number of rows that fit, from the box of the previous frame. Before the
+  // first frame the terminal height is a safe upper bound.
+  int VisibleRows() const {
+    const int height = box_.y_max - box_.y_min + 1;
+    if (height > 0) {
+      return height;
+    }
+    return std::max(1, ftxui::Terminal::Size().dimy);
+  }
+
+  // Keeps *selected inside the list, which may have shrunk, and returns it.
+  int ClampSelected(int size) {
+    *options_.selected =
+        std::clamp(*options_.selected, 0, std::max(0, size - 1));
+    return *options_.selected;
+  }
+
+  void Select(int index, int size) {
+    const int previous = ClampSelected(size);
+    *options_.selected = std::clamp(index, 0, std::max(0, size - 1));
+    if (*options_.selected != previous && options_.on_change) {
+      options_.on_change();
+    }
+  }
+
+  DirectoryMenuOption options_;
+  int first_visible_ = 0;
+  ftxui::Box box_;
+};
+
+} // namespace
+
+ftxui::Component DirectoryMenu(DirectoryMenuOption options) {
+  return ftxui::Make<DirectoryMenuBase>(std::move(options));
+}
+
+} // namespace terminal_animation
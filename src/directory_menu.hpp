@@ -0,0 +1,30 @@
+#pragma once
+
+// libs
+// FTXUI
+#include <ftxui/component/component.hpp>
+
+// std
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace terminal_animation {
+
+// Options for DirectoryMenu().
+struct DirectoryMenuOption {
+  // Returns the current number of entries. May grow between frames.
+  std::function<std::size_t()> size;
+  // Returns the label of the entry at the given index. Only called for the
+  // rows that are visible.
+  std::function<std::string(std::size_t)> label;
+  int *selected = nullptr;
+  std::function<void()> on_change;
+  std::function<void()> on_enter;
+};
+
+// Vertical menu that only builds elements for the rows that fit in its box,
+// so listing tens of thousands of entries costs the same as listing a few.
+ftxui::Component DirectoryMenu(DirectoryMenuOption options);
+
+} // namespace terminal_animation
@@ -0,0 +1,207 @@
+// header
+#include "directory_scanner.hpp"
+
+// local
+#include "common.hpp"
+
+// std
+#include <algorithm>
+#include <system_error>
+#include <utility>
+
+namespace terminal_animation {
+
+void DirectoryScanner::Scan(const std::filesystem::path &directory,
+                            std::vector<DirectoryEntry> fixed_entries,
+                            bool media_only) {
+  Cancel();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_entries_);
+    entries_ = std::move(fixed_entries);
+    fixed_count_ = entries_.size();
+    scanned_paths_.clear();
+  }
+
+  is_complete_.store(false);
+  const std::uint64_t generation = generation_.load();
+  thread_scan_ = std::thread(&DirectoryScanner::ScanDirectory, this,
+                             directory, media_only, generation);
+}
+
+void DirectoryScanner::Wait() {
+  if (thread_scan_.joinable()) {
+    thread_scan_.join();
+  }
+}
+
+void DirectoryScanner::ApplyChanges(const std::vector<DirectoryChange> &changes,
+                                    bool media_only) {
+  const auto accepts = [media_only](const DirectoryChange &change) {
+    return !media_only || change.is_directory ||
+           IsMediaExtension(change.path);
+  };
+
+  std::unordered_set<std::string> removed;
+  std::vector<const DirectoryChange *> renamed;
+  std::vector<const DirectoryChange *> added;
+  for (const auto &change : changes) {
+    switch (change.type) {
+    case DirectoryChange::Type::kAdded:
+      if (accepts(change)) {
+        added.push_back(&change);
+      }
+      break;
+    case DirectoryChange::Type::kRemoved:
+      removed.insert(change.path.string());
+      break;
+    case DirectoryChange::Type::kRenamed:
+      renamed.push_back(&change);
+      break;
+    default:
+      break;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_entries_);
+
+  // Renames either update the entry in place or, if the new name no longer
+  // passes the filter, turn into removals (and additions the other way).
+  for (const DirectoryChange *change : renamed) {
+    const std::string old_path = change->old_path.string();
+    if (!scanned_paths_.contains(old_path)) {
+      if (accepts(*change)) {
+        added.push_back(change);
+      }
+      continue;
+    }
+    if (!accepts(*change)) {
+      removed.insert(old_path);
+      continue;
+    }
+    for (std::size_t i = fixed_count_; i < entries_.size(); ++i) {
+      if (entries_[i].path == change->old_path) {
+        entries_[i].path = change->path;
+        entries_[i].is_directory = change->is_directory;
+        break;
+      }
+    }
+    scanned_paths_.erase(old_path);
+    scanned_paths_.insert(change->path.string());
+  }
+
+  // One pass over the listing for all removals of the batch.
+  if (!removed.empty()) {
+    const auto first_scanned =
+        entries_.begin() + static_cast<std::ptrdiff_t>(fixed_count_);
+    entries_.erase(std::remove_if(first_scanned, entries_.end(),
+                                  [&](const DirectoryEntry &entry) {
+                                    return removed.contains(
+                                        entry.path.string());
+                                  }),
+                   entries_.end());
+    for (const auto &path : removed) {
+      scanned_paths_.erase(path);
+    }
+  }
+
+  for (const DirectoryChange *change : added) {
+    if (scanned_paths_.insert(change->path.string()).second) {
+      entries_.push_back(
+          {.path = change->path, .is_directory = change->is_directory});
+    }
+  }
+}
+
+std::size_t DirectoryScanner::Size() const {
+  std::lock_guard<std::mutex> lock(mutex_entries_);
+  return entries_.size();
+}
+
+std::optional<DirectoryEntry> DirectoryScanner::At(std::size_t index) const {
+  std::lock_guard<std::mutex> lock(mutex_entries_);
+  if (index >= entries_.size()) {
+    return std::nullopt;
+  }
+  return entries_[index];
+}
+
+std::optional<std::size_t>
+DirectoryScanner::IndexOf(const std::filesystem::path &path) const {
+  std::lock_guard<std::mutex> lock(mutex_entries_);
+  for (std::size_t i = 0; i < entries_.size(); ++i) {
+    if (entries_[i].path == path) {
+      return i;
+    }
+  }
+  return std::nullopt;
+}
+
+void DirectoryScanner::Cancel() {
+  generation_.fetch_add(1);
+  Wait();
+}
+
+void DirectoryScanner::ScanDirectory(const std::filesystem::path &directory,
+                                     bool media_only,
+                                     std::uint64_t generation) {
+  std::vector<DirectoryEntry> batch;
+  batch.reserve(kBatchSize);
+
+  std::error_code ec;
+  std::filesystem::directory_iterator it(
+      directory, std::filesystem::directory_options::skip_permission_denied,
+      ec);
+  const std::filesystem::directory_iterator end;
+
+  for (; !ec && it != end; it.increment(ec)) {
+    if (generation != generation_.load()) {
+      return;
+    }
+
+    std::error_code type_ec;
+    const bool is_directory = it->is_directory(type_ec);
+    if (media_only && !is_directory && !IsMediaExtension(it->path())) {
+      continue;
+    }
+
+    batch.push_back({.path = it->path(), .is_directory = is_directory});
+    if (batch.size() >= kBatchSize) {
+      Publish(batch, generation);
+    }
+  }
+
+  Publish(batch, generation);
+  if (generation == generation_.load()) {
+    is_complete_.store(true);
+    if (on_update_) {
+      on_update_();
+    }
+  }
+}
+
+void DirectoryScanner::Publish(std::vector<DirectoryEntry> &batch,
+                               std::uint64_t generation) {
+  if (batch.empty()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_entries_);
+    if (generation != generation_.load()) {
+      return;
+    }
+    // Entries may already have been added by ApplyChanges() while the scan
+    // was running.
+    for (auto &entry : batch) {
+      if (scanned_paths_.insert(entry.path.string()).second) {
+        entries_.push_back(std::move(entry));
+      }
+    }
+  }
+  batch.clear();
+  if (on_update_) {
+    on_update_();
+  }
+}
+
+} // namespace terminal_animation
@@ -0,0 +1,114 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace terminal_animation {
+
+// One row of the file explorer.
+struct DirectoryEntry {
+  std::filesystem::path path;
+  bool is_directory = false;
+};
+
+// One change to the contents of a watched directory.
+struct DirectoryChange {
+  enum class Type {
+    kAdded,
+    kRemoved,
+    kRenamed,
+    kModified,
+    // Events were lost (e.g. queue overflow); the listing must be rescanned.
+    kReset,
+    // The watched directory itself was deleted or moved away. It is the
+    // last change reported; watch another directory to continue.
+    kGone,
+  };
+
+  Type type = Type::kAdded;
+  std::filesystem::path path;
+  // Previous path, for kRenamed only.
+  std::filesystem::path old_path = {};
+  bool is_directory = false;
+};
+
+// Lists a directory on a background thread and publishes the entries in
+// batches, so huge directories never block the caller. The file type comes
+// from the cached directory_entry status (d_type on POSIX), not a stat per
+// entry.
+class DirectoryScanner {
+public:
+  // Number of entries collected before they are published to readers.
+  static constexpr std::size_t kBatchSize = 256;
+
+  // on_update is called from the scan thread after every published batch
+  // and once more when the scan completes.
+  explicit DirectoryScanner(std::function<void()> on_update = {})
+      : on_update_(std::move(on_update)) {}
+
+  ~DirectoryScanner() { Cancel(); }
+
+  DirectoryScanner(const DirectoryScanner &) = delete;
+  DirectoryScanner &operator=(const DirectoryScanner &) = delete;
+
+  // Replaces the entries with fixed_entries and starts streaming the
+  // contents of directory after them. With media_only, files without a
+  // playable media extension are skipped. A running scan is cancelled.
+  void Scan(const std::filesystem::path &directory,
+            std::vector<DirectoryEntry> fixed_entries, bool media_only);
+
+  // Blocks until the current scan has finished.
+  void Wait();
+
+  // Applies added, removed and renamed entries without rescanning. Renamed
+  // entries keep their position; added ones are appended. The fixed entries
+  // given to Scan() are never touched. Other change types are ignored.
+  void ApplyChanges(const std::vector<DirectoryChange> &changes,
+                    bool media_only);
+
+  std::size_t Size() const;
+
+  // Returns the entry at index, or std::nullopt if it does not exist (yet).
+  std::optional<DirectoryEntry> At(std::size_t index) const;
+
+  // Returns the index of the entry with the given path, if listed.
+  std::optional<std::size_t> IndexOf(const std::filesystem::path &path) const;
+
+  bool IsComplete() const { return is_complete_.load(); }
+
+private:
+  // Stops and joins the running scan, if any.
+  void Cancel();
+
+  // Scan thread entry.
+  void ScanDirectory(const std::filesystem::path &directory, bool media_only,
+                     std::uint64_t generation);
+
+  // Appends a batch if the scan that produced it is still current.
+  void Publish(std::vector<DirectoryEntry> &batch, std::uint64_t generation);
+
+  std::function<void()> on_update_;
+
+  std::atomic<std::uint64_t> generation_{0};
+  std::atomic<bool> is_complete_{true};
+
+  std::vector<DirectoryEntry> entries_;
+  // Number of leading fixed entries, and the paths of the scanned ones.
+  std::size_t fixed_count_ = 0;
+  std::unordered_set<std::string> scanned_paths_;
+  mutable std::mutex mutex_entries_;
+
+  std::thread thread_scan_;
+};
+
+} // namespace terminal_animation
@@ -0,0 +1,270 @@
+// header
+#include "directory_watcher.hpp"
+
+// std
+#include <cerrno>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace terminal_animation {
+
+namespace {
+
+// Name -> is_directory for every entry of a directory.
+std::map<std::string, bool> Snapshot(const std::filesystem::path &directory) {
+  std::map<std::string, bool> snapshot;
+  std::error_code ec;
+  std::filesystem::directory_iterator it(
+      directory, std::filesystem::directory_options::skip_permission_denied,
+      ec);
+  for (const std::filesystem::directory_iterator end; !ec && it != end;
+       it.increment(ec)) {
+    std::error_code type_ec;
+    snapshot.emplace(it->path().filename().string(),
+                     it->is_directory(type_ec));
+  }
+  return snapshot;
+}
+
+DirectoryChange MakeChange(DirectoryChange::Type type,
+                           std::filesystem::path path, bool is_directory) {
+  DirectoryChange change;
+  change.type = type;
+  change.path = std::move(path);
+  change.is_directory = is_directory;
+  return change;
+}
+
+} // namespace
+
+void DirectoryWatcher::Watch(const std::filesystem::path &directory) {
+  Stop();
+
+  should_run_.store(true);
+
+#ifdef __linux__
+  if (!force_polling_) {
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    const int inotify_fd = wake_fd_ >= 0 ? AddInotifyWatch(directory) : -1;
+    if (inotify_fd >= 0) {
+      is_event_driven_.store(true);
+      thread_watch_ = std::thread(&DirectoryWatcher::WatchWithInotify, this,
+                                  directory, inotify_fd);
+      return;
+    }
+  }
+#endif
+
+  is_event_driven_.store(false);
+  thread_watch_ =
+      std::thread(&DirectoryWatcher::WatchByPolling, this, directory);
+}
+
+void DirectoryWatcher::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_wake_);
+    should_run_.store(false);
+  }
+  cv_wake_.notify_all();
+
+#ifdef __linux__
+  if (wake_fd_ >= 0) {
+    const std::uint64_t one = 1;
+    [[maybe_unused]] const auto written = write(wake_fd_, &one, sizeof(one));
+  }
+#endif
+
+  if (thread_watch_.joinable()) {
+    thread_watch_.join();
+  }
+
+#ifdef __linux__
+  if (wake_fd_ >= 0) {
+    close(wake_fd_);
+    wake_fd_ = -1;
+  }
+#endif
+}
+
+int DirectoryWatcher::AddInotifyWatch(const std::filesystem::path &directory) {
+#ifdef __linux__
+  const int inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotify_fd < 0) {
+    return -1;
+  }
+  constexpr std::uint32_t kMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+                                  IN_MOVED_TO | IN_CLOSE_WRITE |
+                                  IN_DELETE_SELF | IN_MOVE_SELF;
+  if (inotify_add_watch(inotify_fd, directory.c_str(), kMask) < 0) {
+    close(inotify_fd);
+    return -1;
+  }
+  return inotify_fd;
+#else
+  (void)directory;
+  return -1;
+#endif
+}
+
+void DirectoryWatcher::WatchWithInotify(const std::filesystem::path &directory,
+                                        int inotify_fd) {
+#ifdef __linux__
+  pollfd fds[2] = {{.fd = inotify_fd, .events = POLLIN, .revents = 0},
+                   {.fd = wake_fd_, .events = POLLIN, .revents = 0}};
+  alignas(inotify_event) char buffer[16 * 1024];
+
+  while (should_run_.load()) {
+    if (poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    if (fds[1].revents != 0) {
+      break;
+    }
+
+    std::vector<DirectoryChange> changes;
+    // Pairs IN_MOVED_FROM with IN_MOVED_TO through the event cookie.
+    std::unordered_map<std::uint32_t, DirectoryChange> moved_from;
+    bool is_gone = false;
+
+    ssize_t length = 0;
+    while ((length = read(inotify_fd, buffer, sizeof(buffer))) > 0) {
+      for (char *ptr = buffer; ptr < buffer + length;) {
+        const auto *event = reinterpret_cast<const inotify_event *>(ptr);
+        ptr += sizeof(inotify_event) + event->len;
+
+        if ((event->mask & IN_Q_OVERFLOW) != 0) {
+          changes.push_back(
+              MakeChange(DirectoryChange::Type::kReset, directory, true));
+          continue;
+        }
+        // The directory itself went away. Its events carry no name, and
+        // the kernel drops the watch (IN_IGNORED), so nothing follows.
+        if ((event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) !=
+            0) {
+          is_gone = true;
+          continue;
+        }
+        if (event->len == 0) {
+          continue;
+        }
+
+        auto change = MakeChange(DirectoryChange::Type::kAdded,
+                                 directory / event->name,
+                                 (event->mask & IN_ISDIR) != 0);
+        if ((event->mask & IN_CREATE) != 0) {
+          change.type = DirectoryChange::Type::kAdded;
+        } else if ((event->mask & IN_DELETE) != 0) {
+          change.type = DirectoryChange::Type::kRemoved;
+        } else if ((event->mask & IN_CLOSE_WRITE) != 0) {
+          change.type = DirectoryChange::Type::kModified;
+        } else if ((event->mask & IN_MOVED_FROM) != 0) {
+          moved_from[event->cookie] = std::move(change);
+          continue;
+        } else if ((event->mask & IN_MOVED_TO) != 0) {
+          auto from = moved_from.find(event->cookie);
+          if (from != moved_from.end()) {
+            change.type = DirectoryChange::Type::kRenamed;
+            change.old_path = std::move(from->second.path);
+            moved_from.erase(from);
+          } else {
+            change.type = DirectoryChange::Type::kAdded;
+          }
+        } else {
+          continue;
+        }
+        changes.push_back(std::move(change));
+      }
+    }
+
+    // Moved out of the directory.
+    for (auto &[cookie, change] : moved_from) {
+      change.type = DirectoryChange::Type::kRemoved;
+      changes.push_back(std::move(change));
+    }
+    if (is_gone) {
+      changes.push_back(
+          MakeChange(DirectoryChange::Type::kGone, directory, true));
+    }
+
+    if (!changes.empty() && on_changes_) {
+      on_changes_(directory, changes);
+    }
+    if (is_gone) {
+      break;
+    }
+  }
+
+  close(inotify_fd);
+#else
+  (void)directory;
+  (void)inotify_fd;
+#endif
+}
+
+void DirectoryWatcher::WatchByPolling(const std::filesystem::path &directory) {
+  std::error_code ec;
+  auto modified = std::filesystem::last_write_time(directory, ec);
+  auto snapshot = Snapshot(directory);
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_wake_);
+      cv_wake_.wait_for(lock, poll_interval_,
+                        [this] { return !should_run_.load(); });
+    }
+    if (!should_run_.load()) {
+      break;
+    }
+
+    // A directory's mtime changes whenever an entry is added, removed or
+    // renamed, so the listing is only diffed when it moved.
+    const auto now_modified = std::filesystem::last_write_time(directory, ec);
+    if (ec && !std::filesystem::exists(directory, ec)) {
+      if (on_changes_) {
+        on_changes_(directory, {MakeChange(DirectoryChange::Type::kGone,
+                                           directory, true)});
+      }
+      return;
+    }
+    if (ec || now_modified == modified) {
+      continue;
+    }
+    modified = now_modified;
+
+    auto current = Snapshot(directory);
+    std::vector<DirectoryChange> changes;
+    for (const auto &[name, is_directory] : current) {
+      if (!snapshot.contains(name)) {
+        changes.push_back(MakeChange(DirectoryChange::Type::kAdded,
+                                     directory / name, is_directory));
+      }
+    }
+    for (const auto &[name, is_directory] : snapshot) {
+      if (!current.contains(name)) {
+        changes.push_back(MakeChange(DirectoryChange::Type::kRemoved,
+                                     directory / name, is_directory));
+      }
+    }
+    snapshot = std::move(current);
+
+    if (!changes.empty() && on_changes_) {
+      on_changes_(directory, changes);
+    }
+  }
+}
+
+} // namespace terminal_animation
@@ -0,0 +1,79 @@
+#pragma once
+
+// local
+#include "directory_scanner.hpp"
+
+// std
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace terminal_animation {
+
+// Reports changes to the entries of one directory from a background thread.
+// Uses inotify on Linux and falls back to polling the directory's
+// modification time elsewhere, or when inotify is unavailable.
+class DirectoryWatcher {
+public:
+  using Callback =
+      std::function<void(const std::filesystem::path &directory,
+                         const std::vector<DirectoryChange> &changes)>;
+
+  static constexpr std::chrono::milliseconds kDefaultPollInterval{1000};
+
+  // force_polling skips inotify, e.g. for network mounts that do not report
+  // events.
+  explicit DirectoryWatcher(
+      Callback on_changes,
+      std::chrono::milliseconds poll_interval = kDefaultPollInterval,
+      bool force_polling = false)
+      : on_changes_(std::move(on_changes)), poll_interval_(poll_interval),
+        force_polling_(force_polling) {}
+
+  ~DirectoryWatcher() { Stop(); }
+
+  DirectoryWatcher(const DirectoryWatcher &) = delete;
+  DirectoryWatcher &operator=(const DirectoryWatcher &) = delete;
+
+  // Starts watching directory, replacing the previously watched one. With
+  // inotify, the watch is in place when this returns. If the directory is
+  // deleted or moved, kGone is reported and watching ends.
+  void Watch(const std::filesystem::path &directory);
+
+  // Stops watching and joins the watch thread.
+  void Stop();
+
+  // True while changes are delivered by inotify rather than polling.
+  bool IsEventDriven() const { return is_event_driven_.load(); }
+
+private:
+  // Returns an inotify descriptor watching directory, or -1 if inotify is
+  // unavailable.
+  static int AddInotifyWatch(const std::filesystem::path &directory);
+
+  // Watch thread entries.
+  void WatchWithInotify(const std::filesystem::path &directory,
+                        int inotify_fd);
+  void WatchByPolling(const std::filesystem::path &directory);
+
+  Callback on_changes_;
+  std::chrono::milliseconds poll_interval_;
+  bool force_polling_;
+
+  std::atomic<bool> should_run_{false};
+  std::atomic<bool> is_event_driven_{false};
+
+  // Wakes the watch thread when stopping.
+  std::mutex mutex_wake_;
+  std::condition_variable cv_wake_;
+  int wake_fd_ = -1;
+
+  std::thread thread_watch_;
+};
+
+} // namespace terminal_animation
@@ -0,0 +1,220 @@
+// header
+#include "event_log.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <utility>
+
+namespace terminal_animation {
+
+namespace {
+
+constexpr std::string_view kMagic = "terminal_animation-events";
+constexpr std::uint32_t kVersion = 1;
+
+// Splits line at single spaces.
+std::vector<std::string_view> SplitFields(std::string_view line) {
+  std::vector<std::string_view> fields;
+  while (true) {
+    const auto space = line.find(' ');
+    fields.push_back(line.substr(0, space));
+    if (space == std::string_view::npos) {
+      return fields;
+    }
+    line.remove_prefix(space + 1);
+  }
+}
+
+template <typename T> std::optional<T> ParseNumber(std::string_view text) {
+  T value{};
+  const auto [end, error] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  if (error != std::errc() || end != text.data() + text.size()) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+std::string EncodeHex(std::string_view bytes) {
+  constexpr std::string_view kDigits = "0123456789abcdef";
+  std::string hex;
+  hex.reserve(2 * bytes.size());
+  for (const char byte : bytes) {
+    const auto value = static_cast<unsigned char>(byte);
+    hex.push_back(kDigits[value >> 4]);
+    hex.push_back(kDigits[value & 0xF]);
+  }
+  return hex;
+}
+
+std::optional<std::string> DecodeHex(std::string_view hex) {
+  if (hex.size() % 2 != 0) {
+    return std::nullopt;
+  }
+  std::string bytes;
+  bytes.reserve(hex.size() / 2);
+  for (std::size_t i = 0; i < hex.size(); i += 2) {
+    unsigned int value = 0;
+    const auto [end, error] =
+        std::from_chars(hex.data() + i, hex.data() + i + 2, value, 16);
+    if (error != std::errc() || end != hex.data() + i + 2) {
+      return std::nullopt;
+    }
+    bytes.push_back(static_cast<char>(value));
+  }
+  return bytes;
+}
+
+char KindLetter(RecordedEvent::Kind kind) {
+  switch (kind) {
+  case RecordedEvent::Kind::kCharacter:
+    return 'c';
+  case RecordedEvent::Kind::kMouse:
+    return 'm';
+  case RecordedEvent::Kind::kSpecial:
+    break;
+  }
+  return 's';
+}
+
+} // namespace
+
+std::string FormatEventLogHeader(std::uint32_t columns, std::uint32_t rows) {
+  std::string header(kMagic);
+  header += ' ' + std::to_string(kVersion) + ' ' + std::to_string(columns) +
+            ' ' + std::to_string(rows);
+  return header;
+}
+
+std::string FormatRecordedEvent(const RecordedEvent &event) {
+  std::string line = std::to_string(event.time.count());
+  line += ' ';
+  line += KindLetter(event.kind);
+  line += ' ';
+  // An empty input is written as "-", so the field is never empty.
+  line += event.input.empty() ? "-" : EncodeHex(event.input);
+  if (event.kind == RecordedEvent::Kind::kMouse) {
+    const RecordedEvent::Mouse &mouse = event.mouse;
+    for (const int value :
+         {mouse.button, mouse.motion, static_cast<int>(mouse.shift),
+          static_cast<int>(mouse.meta), static_cast<int>(mouse.control),
+          mouse.x, mouse.y}) {
+      line += ' ' + std::to_string(value);
+    }
+  }
+  return line;
+}
+
+std::optional<RecordedEvent> ParseRecordedEvent(std::string_view line) {
+  const std::vector<std::string_view> fields = SplitFields(line);
+  if (fields.size() < 3 || fields[1].size() != 1) {
+    return std::nullopt;
+  }
+
+  RecordedEvent event;
+  const auto time = ParseNumber<std::int64_t>(fields[0]);
+  if (!time.has_value() || *time < 0) {
+    return std::nullopt;
+  }
+  event.time = std::chrono::microseconds(*time);
+
+  std::size_t field_count = 3;
+  switch (fields[1][0]) {
+  case 'c':
+    event.kind = RecordedEvent::Kind::kCharacter;
+    break;
+  case 's':
+    event.kind = RecordedEvent::Kind::kSpecial;
+    break;
+  case 'm':
+    event.kind = RecordedEvent::Kind::kMouse;
+    field_count = 10;
+    break;
+  default:
+    return std::nullopt;
+  }
+  if (fields.size() != field_count) {
+    return std::nullopt;
+  }
+
+  if (fields[2] != "-") {
+    auto input = DecodeHex(fields[2]);
+    if (!input.has_value() || input->empty()) {
+      return std::nullopt;
+    }
+    event.input = std::move(*input);
+  }
+
+  if (event.kind == RecordedEvent::Kind::kMouse) {
+    std::array<int, 7> values{};
+    for (std::size_t i = 0; i < values.size(); ++i) {
+      const auto value = ParseNumber<int>(fields[3 + i]);
+      if (!value.has_value()) {
+        return std::nullopt;
+      }
+      values[i] = *value;
+    }
+    event.mouse = {.button = values[0],
+                   .motion = values[1],
+                   .shift = values[2] != 0,
+                   .meta = values[3] != 0,
+                   .control = values[4] != 0,
+                   .x = values[5],
+                   .y = values[6]};
+  }
+  return event;
+}
+
+std::optional<EventLog> ReadEventLog(std::istream &in) {
+  std::string line;
+  if (!std::getline(in, line)) {
+    return std::nullopt;
+  }
+  const std::vector<std::string_view> header = SplitFields(line);
+  if (header.size() != 4 || header[0] != kMagic ||
+      ParseNumber<std::uint32_t>(header[1]) != kVersion) {
+    return std::nullopt;
+  }
+  const auto columns = ParseNumber<std::uint32_t>(header[2]);
+  const auto rows = ParseNumber<std::uint32_t>(header[3]);
+  if (!columns.has_value() || !rows.has_value() || *columns == 0 ||
+      *rows == 0) {
+    return std::nullopt;
+  }
+
+  EventLog log{.columns = *columns, .rows = *rows, .events = {}};
+  while (std::getline(in, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    auto event = ParseRecordedEvent(line);
+    if (!event.has_value() ||
+        (!log.events.empty() && event->time < log.events.back().time)) {
+      return std::nullopt;
+    }
+    log.events.push_back(std::move(*event));
+  }
+  return log;
+}
+
+LatencySummary
+SummarizeLatencies(std::vector<std::chrono::nanoseconds> samples) {
+  if (samples.empty()) {
+    return {};
+  }
+  std::sort(samples.begin(), samples.end());
+  const auto percentile = [&samples](double fraction) {
+    const auto index = static_cast<std::size_t>(
+        fraction * static_cast<double>(samples.size() - 1) + 0.5);
+    return std::chrono::duration<double, std::micro>(
+               samples[std::min(index, samples.size() - 1)])
+        .count();
+  };
+  return {.p50_us = percentile(0.50),
+          .p95_us = percentile(0.95),
+          .max_us = percentile(1.0)};
+}
+
+} // namespace terminal_animation
@@ -0,0 +1,81 @@
+#pragma once
+
+// std
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace terminal_animation {
+
+// One input event of an interactive session, independent of FTXUI so logs
+// can be written, read and tested without a terminal.
+struct RecordedEvent {
+  enum class Kind {
+    // A printable character.
+    kCharacter,
+    // Any other key or terminal report, replayed from its raw input.
+    kSpecial,
+    kMouse,
+  };
+
+  // Mirrors ftxui::Mouse.
+  struct Mouse {
+    int button = 0;
+    int motion = 0;
+    bool shift = false;
+    bool meta = false;
+    bool control = false;
+    int x = 0;
+    int y = 0;
+
+    bool operator==(const Mouse &) const = default;
+  };
+
+  // Time since the recording started.
+  std::chrono::microseconds time{0};
+  Kind kind = Kind::kSpecial;
+  // The raw terminal input the event was parsed from.
+  std::string input;
+  // Only meaningful for kMouse.
+  Mouse mouse;
+
+  bool operator==(const RecordedEvent &) const = default;
+};
+
+// A recorded session: the terminal size it ran at and its events in order.
+struct EventLog {
+  std::uint32_t columns = 0;
+  std::uint32_t rows = 0;
+  std::vector<RecordedEvent> events;
+};
+
+// Returns the first line of a log recorded on a columns x rows terminal.
+std::string FormatEventLogHeader(std::uint32_t columns, std::uint32_t rows);
+
+// Returns event as one line of a log. The input is hex-encoded, so lines
+// hold no control characters.
+std::string FormatRecordedEvent(const RecordedEvent &event);
+
+// Parses a line written by FormatRecordedEvent(). Returns nullopt if it is
+// malformed.
+std::optional<RecordedEvent> ParseRecordedEvent(std::string_view line);
+
+// Reads a whole log. Returns nullopt if the header or any event is
+// malformed, or events go back in time.
+std::optional<EventLog> ReadEventLog(std::istream &in);
+
+// Percentiles of a set of durations, in microseconds.
+struct LatencySummary {
+  double p50_us = 0;
+  double p95_us = 0;
+  double max_us = 0;
+};
+
+LatencySummary
+SummarizeLatencies(std::vector<std::chrono::nanoseconds> samples);
+
+} // namespace terminal_animation
@@ -0,0 +1,148 @@
+// header
+#include "frame_protocol.hpp"
+
+// std
+#include <algorithm>
+#include <cstring>
+
+namespace terminal_animation {
+
+namespace {
+
+void PutUint32(std::uint32_t value, char *out) {
+  for (int i = 0; i < 4; ++i) {
+    out[i] = static_cast<char>((value >> (8 * i)) & 0xFFU);
+  }
+}
+
+std::uint32_t GetUint32(const char *in) {
+  std::uint32_t value = 0;
+  for (int i = 0; i < 4; ++i) {
+    value |= static_cast<std::uint32_t>(static_cast<unsigned char>(in[i]))
+             << (8 * i);
+  }
+  return value;
+}
+
+// Resizes out to hold a message with payload_size bytes of payload, writes
+// the header and returns a pointer to the payload.
+char *StartMessage(MessageType type, std::size_t payload_size,
+                   std::vector<char> &out) {
+  out.resize(kMessageHeaderSize + payload_size);
+  out[0] = static_cast<char>(type);
+  PutUint32(static_cast<std::uint32_t>(payload_size), out.data() + 1);
+  return out.data() + kMessageHeaderSize;
+}
+
+bool IsKnownColorDepth(std::uint8_t value) {
+  return value == static_cast<std::uint8_t>(ColorDepth::kMonochrome) ||
+         value == static_cast<std::uint8_t>(ColorDepth::kTrueColor);
+}
+
+} // namespace
+
+void EncodeHello(const StreamParams &params, std::vector<char> &out) {
+  char *payload = StartMessage(MessageType::kHello, 5, out);
+  PutUint32(params.size, payload);
+  payload[4] = static_cast<char>(params.color_depth);
+}
+
+void EncodeFrame(std::uint32_t index, const CharsAndColors &frame,
+                 std::vector<char> &out) {
+  const std::size_t cells =
+      static_cast<std::size_t>(frame.columns) * frame.rows;
+  const bool has_colors = !frame.colors.empty();
+  const std::size_t payload_size = 13 + cells + (has_colors ? 3 * cells : 0);
+
+  char *payload = StartMessage(MessageType::kFrame, payload_size, out);
+  PutUint32(index, payload);
+  PutUint32(frame.columns, payload + 4);
+  PutUint32(frame.rows, payload + 8);
+  payload[12] = static_cast<char>(has_colors ? ColorDepth::kTrueColor
+                                             : ColorDepth::kMonochrome);
+  std::memcpy(payload + 13, frame.chars.data(), cells);
+  if (has_colors) {
+    // std::array<std::uint8_t, 3> has no padding, so the colors are one
+    // contiguous run of RGB bytes.
+    std::memcpy(payload + 13 + cells, frame.colors.data(), 3 * cells);
+  }
+}
+
+std::optional<StreamParams> DecodeHello(const std::vector<char> &payload) {
+  if (payload.size() != 5 ||
+      !IsKnownColorDepth(static_cast<std::uint8_t>(payload[4]))) {
+    return std::nullopt;
+  }
+  return StreamParams{
+      .size = std::max(1U, GetUint32(payload.data())),
+      .color_depth = static_cast<ColorDepth>(payload[4]),
+  };
+}
+
+bool DecodeFrame(const std::vector<char> &payload, std::uint32_t &index,
+                 CharsAndColors &target) {
+  if (payload.size() < 13 ||
+      !IsKnownColorDepth(static_cast<std::uint8_t>(payload[12]))) {
+    return false;
+  }
+  const std::uint32_t columns = GetUint32(payload.data() + 4);
+  const std::uint32_t rows = GetUint32(payload.data() + 8);
+  const bool has_colors =
+      static_cast<ColorDepth>(payload[12]) == ColorDepth::kTrueColor;
+  const std::size_t cells = static_cast<std::size_t>(columns) * rows;
+  if (payload.size() != 13 + cells + (has_colors ? 3 * cells : 0)) {
+    return false;
+  }
+
+  index = GetUint32(payload.data());
+  target.columns = columns;
+  target.rows = rows;
+  const char *chars = payload.data() + 13;
+  target.chars.assign(chars, chars + cells);
+  target.colors.resize(has_colors ? cells : 0);
+  if (has_colors) {
+    std::memcpy(target.colors.data(), chars + cells, 3 * cells);
+  }
+  return true;
+}
+
+void MessageReader::Append(const char *data, std::size_t size) {
+  // Drop consumed bytes before growing, so the buffer stays as large as
+  // the biggest message rather than the whole stream.
+  if (offset_ > 0 && offset_ >= buffer_.size() / 2) {
+    buffer_.erase(buffer_.begin(),
+                  buffer_.begin() + static_cast<std::ptrdiff_t>(offset_));
+    offset_ = 0;
+  }
+  buffer_.insert(buffer_.end(), data, data + size);
+}
+
+bool MessageReader::Next(Message &message) {
+  if (has_error_ || buffer_.size() - offset_ < kMessageHeaderSize) {
+    return false;
+  }
+
+  const char *header = buffer_.data() + offset_;
+  const auto type = static_cast<MessageType>(header[0]);
+  const std::uint32_t payload_size = GetUint32(header + 1);
+  if ((type != MessageType::kHello && type != MessageType::kFrame) ||
+      payload_size > kMaxMessagePayloadSize) {
+    has_error_ = true;
+    return false;
+  }
+  if (buffer_.size() - offset_ < kMessageHeaderSize + payload_size) {
+    return false;
+  }
+
+  const char *payload = header + kMessageHeaderSize;
+  message.type = type;
+  message.payload.assign(payload, payload + payload_size);
+  offset_ += kMessageHeaderSize + payload_size;
+  if (offset_ == buffer_.size()) {
+    buffer_.clear();
+    offset_ = 0;
+  }
+  return true;
+}
+
+} // namespace terminal_animation
@@ -0,0 +1,87 @@
+#pragma once
+
+// local
+#include "chars_and_colors.hpp"
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace terminal_animation {
+
+// Wire format between the broadcast server and its clients. Every message
+// is a 5 byte header, the message type and the payload length as a
+// little-endian uint32, followed by the payload. All integers are
+// little-endian.
+//
+// kHello (client -> server): uint32 size, uint8 color depth. Sent on
+//   connect and again whenever the client wants different parameters.
+// kFrame (server -> client): uint32 index, uint32 columns, uint32 rows,
+//   uint8 color depth, columns * rows characters, then for kTrueColor
+//   columns * rows RGB triplets.
+inline constexpr std::size_t kMessageHeaderSize = 5;
+// Larger payloads are treated as a corrupt stream.
+inline constexpr std::uint32_t kMaxMessagePayloadSize = 64U << 20U;
+
+enum class MessageType : std::uint8_t {
+  kHello = 1,
+  kFrame = 2,
+};
+
+enum class ColorDepth : std::uint8_t {
+  kMonochrome = 0,
+  kTrueColor = 1,
+};
+
+// Conversion parameters a client asks for. Clients with equal parameters
+// share one conversion on the server.
+struct StreamParams {
+  std::uint32_t size = 32;
+  ColorDepth color_depth = ColorDepth::kTrueColor;
+
+  bool operator==(const StreamParams &) const = default;
+  auto operator<=>(const StreamParams &) const = default;
+};
+
+struct Message {
+  MessageType type = MessageType::kHello;
+  std::vector<char> payload;
+};
+
+// Replace the contents of out with an encoded message. Reusing out avoids
+// allocating once it has held a message of the same size.
+void EncodeHello(const StreamParams &params, std::vector<char> &out);
+void EncodeFrame(std::uint32_t index, const CharsAndColors &frame,
+                 std::vector<char> &out);
+
+// Decode the payload of a message of the matching type. Return nullopt or
+// false if the payload is malformed.
+std::optional<StreamParams> DecodeHello(const std::vector<char> &payload);
+// Reuses the buffers of target, like MediaToAscii::GetCharsAndColors().
+bool DecodeFrame(const std::vector<char> &payload, std::uint32_t &index,
+                 CharsAndColors &target);
+
+// Splits a byte stream into messages. Bytes can arrive in any chunks.
+class MessageReader {
+public:
+  void Append(const char *data, std::size_t size);
+
+  // Moves the next complete message into message, reusing its payload
+  // buffer. Returns false if no complete message is buffered or the stream
+  // is corrupt.
+  bool Next(Message &message);
+
+  // True once an unknown message type or an oversized payload was seen.
+  // The connection should then be closed.
+  bool HasError() const { return has_error_; }
+
+private:
+  std::vector<char> buffer_;
+  // Bytes of buffer_ before this offset were already consumed.
+  std::size_t offset_ = 0;
+  bool has_error_ = false;
+};
+
+} // namespace terminal_animation
@@ -0,0 +1,74 @@
+// header
+#include "frame_renderer.hpp"
+
+// libs
+// FTXUI
+#include <ftxui/dom/node.hpp>
+#include <ftxui/screen/box.hpp>
+#include <ftxui/screen/color.hpp>
+#include <ftxui/screen/screen.hpp>
+
+// std
+#include <algorithm>
+#include <utility>
+
+namespace terminal_animation {
+
+namespace {
+
+class AsciiFrameNode : public ftxui::Node {
+public:
+  explicit AsciiFrameNode(
+      std::shared_ptr<const MediaToAscii::CharsAndColors> frame)
+      : frame_(std::move(frame)) {}
+
+  void ComputeRequirement() override {
+    requirement_.min_x = 0;
+    requirement_.min_y = 0;
+    requirement_.flex_grow_x = 1;
+    requirement_.flex_grow_y = 1;
+    requirement_.flex_shrink_x = 1;
+    requirement_.flex_shrink_y = 1;
+  }
+
+  void Render(ftxui::Screen &screen) override {
+    if (!frame_) {
+      return;
+    }
+    const MediaToAscii::CharsAndColors &frame = *frame_;
+    const int columns = std::min(static_cast<int>(frame.columns),
+                                 box_.x_max - box_.x_min + 1);
+    const int rows =
+        std::min(static_cast<int>(frame.rows), box_.y_max - box_.y_min + 1);
+
+    // Monochrome frames keep the default color, so the screen is printed as
+    // plain text without color escapes.
+    const bool has_colors = !frame.colors.empty();
+    for (int y = 0; y < rows; ++y) {
+      const std::size_t row_start = static_cast<std::size_t>(y) * frame.columns;
+      for (int x = 0; x < columns; ++x) {
+        const std::size_t cell = row_start + static_cast<std::size_t>(x);
+        ftxui::Pixel &pixel = screen.PixelAt(box_.x_min + x, box_.y_min + y);
+        // One character fits the small-string buffer, so this does not
+        // allocate.
+        pixel.character.assign(1, frame.chars[cell]);
+        if (has_colors) {
+          const auto &color = frame.colors[cell];
+          pixel.foreground_color = ftxui::Color(color[0], color[1], color[2]);
+        }
+      }
+    }
+  }
+
+private:
+  std::shared_ptr<const MediaToAscii::CharsAndColors> frame_;
+};
+
+} // namespace
+
+ftxui::Element
+AsciiFrame(std::shared_ptr<const MediaToAscii::CharsAndColors> frame) {
+  return std::make_shared<AsciiFrameNode>(std::move(frame));
+}
+
+} // namespace terminal_animation
@@ -0,0 +1,23 @@
+#pragma once
+
+// local
+#include "media_to_ascii.hpp"
+
+// libs
+// FTXUI
+#include <ftxui/dom/elements.hpp>
+
+// std
+#include <memory>
+
+namespace terminal_animation {
+
+// Returns an element that shows an ASCII frame, one character per terminal
+// cell. Its Render() copies the frame's cells straight into the screen,
+// clipped to the element's box, without going through ftxui::Canvas. Like
+// ftxui::canvas() it fills the space it is given. Frames without colors are
+// drawn in the terminal's default color.
+ftxui::Element
+AsciiFrame(std::shared_ptr<const MediaToAscii::CharsAndColors> frame);
+
+} // namespace terminal_animation
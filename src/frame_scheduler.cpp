@@ -0,0 +1,108 @@
+// header
+#include "frame_scheduler.hpp"
+
+// std
+#include <algorithm>
+#include <utility>
+
+namespace terminal_animation {
+
+FrameScheduler::FrameScheduler(TaskScheduler &tasks, TaskPriority priority,
+                               std::uint32_t max_parallel)
+    : tasks_(tasks), priority_(priority),
+      max_parallel_(max_parallel == 0 ? tasks.WorkerCount() : max_parallel) {}
+
+FrameScheduler::~FrameScheduler() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  stopping_ = true;
+  // Queued tasks still run, see stopping_ and return.
+  cv_step_done_.wait(
+      lock, [this] { return queued_steps_ == 0 && running_steps_ == 0; });
+}
+
+FrameScheduler::ClientId FrameScheduler::Add(Step step) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const ClientId id = next_id_++;
+  clients_.emplace(id, Client{.step = std::move(step)});
+  ScheduleSteps();
+  return id;
+}
+
+void FrameScheduler::Remove(ClientId id) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_step_done_.wait(lock, [this, id] {
+    const auto it = clients_.find(id);
+    return it == clients_.end() || !it->second.running;
+  });
+  clients_.erase(id);
+}
+
+void FrameScheduler::Wake(ClientId id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = clients_.find(id);
+  if (it == clients_.end()) {
+    return;
+  }
+  it->second.runnable = true;
+  ScheduleSteps();
+}
+
+void FrameScheduler::ScheduleSteps() {
+  if (stopping_) {
+    return;
+  }
+  const auto ready = static_cast<std::uint32_t>(
+      std::count_if(clients_.begin(), clients_.end(), [](const auto &entry) {
+        return entry.second.runnable && !entry.second.running;
+      }));
+  while (queued_steps_ + running_steps_ < max_parallel_ &&
+         queued_steps_ < ready) {
+    ++queued_steps_;
+    tasks_.Submit(priority_, [this] { RunNextStep(); });
+  }
+}
+
+std::map<FrameScheduler::ClientId, FrameScheduler::Client>::iterator
+FrameScheduler::NextClient() {
+  const auto is_ready = [](const auto &entry) {
+    return entry.second.runnable && !entry.second.running;
+  };
+  auto it = std::find_if(clients_.upper_bound(last_served_), clients_.end(),
+                         is_ready);
+  if (it == clients_.end()) {
+    it = std::find_if(clients_.begin(), clients_.end(), is_ready);
+  }
+  return it;
+}
+
+void FrameScheduler::RunNextStep() {
+  Client *client = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    --queued_steps_;
+    const auto it = stopping_ ? clients_.end() : NextClient();
+    if (it == clients_.end()) {
+      cv_step_done_.notify_all();
+      return;
+    }
+
+    client = &it->second;
+    client->runnable = false;
+    client->running = true;
+    last_served_ = it->first;
+    ++running_steps_;
+  }
+
+  // Remove() waits for running clients, so the client outlives the lock.
+  const bool has_more = client->step();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  // std::map nodes stay put while other clients come and go.
+  client->running = false;
+  client->runnable = client->runnable || has_more;
+  --running_steps_;
+  cv_step_done_.notify_all();
+  ScheduleSteps();
+}
+
+} // namespace terminal_animation
@@ -0,0 +1,85 @@
+#pragma once
+
+// local
+#include "task_scheduler.hpp"
+
+// std
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+
+namespace terminal_animation {
+
+// Shares the workers of a TaskScheduler between clients that each produce a
+// stream of small work items, e.g. the decoders of several mosaic panes.
+// Every step runs as its own task, so more urgent work can run in between.
+// Clients are served round-robin and a client never runs on two workers at
+// once, so every client gets an equal share of the workers under load and
+// none of them starves. Nothing is queued while no client has work.
+class FrameScheduler {
+public:
+  // Runs one unit of work, e.g. decoding and converting one frame. Returns
+  // false when the client has nothing to do until it is woken again.
+  using Step = std::function<bool()>;
+  using ClientId = std::uint64_t;
+
+  // Runs at most max_parallel steps at once; 0 allows one per worker.
+  explicit FrameScheduler(TaskScheduler &tasks,
+                          TaskPriority priority = TaskPriority::kLookAhead,
+                          std::uint32_t max_parallel = 0);
+
+  // Waits for queued and running steps. Must be destroyed before tasks.
+  ~FrameScheduler();
+
+  FrameScheduler(const FrameScheduler &) = delete;
+  FrameScheduler &operator=(const FrameScheduler &) = delete;
+
+  // Registers a client. Its step is runnable right away.
+  ClientId Add(Step step);
+
+  // Unregisters a client, waiting for its running step to return. Must not
+  // be called from the client's own step.
+  void Remove(ClientId id);
+
+  // Makes a client runnable again after its step returned false. Waking a
+  // running client runs its step once more after it returns.
+  void Wake(ClientId id);
+
+private:
+  struct Client {
+    Step step;
+    bool runnable = true;
+    bool running = false;
+  };
+
+  // Task body: runs one step of the next client in round-robin order.
+  void RunNextStep();
+
+  // Submits tasks for clients that are ready, up to max_parallel_.
+  // Requires mutex_.
+  void ScheduleSteps();
+
+  // Returns the next runnable, idle client after last_served_, or
+  // clients_.end(). Requires mutex_.
+  std::map<ClientId, Client>::iterator NextClient();
+
+  TaskScheduler &tasks_;
+  TaskPriority priority_;
+  std::uint32_t max_parallel_;
+
+  // Ordered by id, so round-robin order is registration order.
+  std::map<ClientId, Client> clients_;
+  ClientId next_id_ = 1;
+  ClientId last_served_ = 0;
+  // Tasks submitted but not started, and steps running.
+  std::uint32_t queued_steps_ = 0;
+  std::uint32_t running_steps_ = 0;
+  bool stopping_ = false;
+
+  std::mutex mutex_;
+  std::condition_variable cv_step_done_;
+};
+
+} // namespace terminal_animation
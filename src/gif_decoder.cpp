@@ -0,0 +1,441 @@
+// header
+#include "gif_decoder.hpp"
+
+// std
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+
+namespace terminal_animation {
+
+namespace {
+
+constexpr std::uint8_t kExtensionIntroducer = 0x21;
+constexpr std::uint8_t kImageSeparator = 0x2C;
+constexpr std::uint8_t kTrailer = 0x3B;
+constexpr std::uint8_t kGraphicControlLabel = 0xF9;
+constexpr std::uint8_t kDisposeToBackground = 2;
+constexpr std::uint8_t kDisposeToPrevious = 3;
+constexpr std::uint32_t kMaxLzwCodes = 4096;
+
+// Reads the file's bytes in order, failing softly past the end.
+class ByteReader {
+public:
+  explicit ByteReader(std::span<const std::uint8_t> data) : data_(data) {}
+
+  bool Has(std::size_t count) const { return data_.size() - offset_ >= count; }
+
+  std::uint8_t Byte() { return Has(1) ? data_[offset_++] : 0; }
+
+  std::uint32_t Word() {
+    const std::uint32_t low = Byte();
+    return low | (static_cast<std::uint32_t>(Byte()) << 8);
+  }
+
+  std::vector<std::array<std::uint8_t, 3>> Palette(std::size_t entries) {
+    std::vector<std::array<std::uint8_t, 3>> palette(entries);
+    for (auto &color : palette) {
+      color = {Byte(), Byte(), Byte()};
+    }
+    return palette;
+  }
+
+  // Reads data sub-blocks up to the terminating empty block, appending
+  // their contents to out if given.
+  bool SubBlocks(std::vector<std::uint8_t> *out) {
+    while (Has(1)) {
+      const std::uint8_t size = Byte();
+      if (size == 0) {
+        return true;
+      }
+      if (!Has(size)) {
+        return false;
+      }
+      if (out != nullptr) {
+        out->insert(out->end(), data_.begin() + offset_,
+                    data_.begin() + offset_ + size);
+      }
+      offset_ += size;
+    }
+    return false;
+  }
+
+private:
+  std::span<const std::uint8_t> data_;
+  std::size_t offset_ = 0;
+};
+
+// Returns the row of an interlaced image stored at position pass_row:
+// every 8th row from 0, every 8th from 4, every 4th from 2, then every
+// 2nd from 1.
+std::uint32_t InterlacedRow(std::uint32_t pass_row, std::uint32_t height) {
+  constexpr std::uint32_t kStarts[] = {0, 4, 2, 1};
+  constexpr std::uint32_t kSteps[] = {8, 8, 4, 2};
+  for (std::size_t pass = 0; pass < 4; ++pass) {
+    const std::uint32_t rows =
+        height > kStarts[pass]
+            ? (height - kStarts[pass] + kSteps[pass] - 1) / kSteps[pass]
+            : 0;
+    if (pass_row < rows) {
+      return kStarts[pass] + pass_row * kSteps[pass];
+    }
+    pass_row -= rows;
+  }
+  return height;
+}
+
+// Decodes up to pixel_count indices like DecodeGifLzw(), passing each to
+// output in order. output returns false once it needs no more.
+template <typename Output>
+void DecodeLzw(std::span<const std::uint8_t> data, std::uint8_t min_code_size,
+               std::size_t pixel_count, Output &&output) {
+  if (min_code_size < 2 || min_code_size > 8) {
+    return;
+  }
+
+  // Every code is a prefix code plus one final index; roots have no
+  // prefix.
+  std::array<std::uint16_t, kMaxLzwCodes> prefix{};
+  std::array<std::uint8_t, kMaxLzwCodes> suffix{};
+  std::array<std::uint8_t, kMaxLzwCodes> stack{};
+  const std::uint32_t clear_code = 1U << min_code_size;
+  const std::uint32_t end_code = clear_code + 1;
+  for (std::uint32_t code = 0; code < clear_code; ++code) {
+    suffix[code] = static_cast<std::uint8_t>(code);
+  }
+
+  std::uint32_t code_size = min_code_size + 1;
+  std::uint32_t next_code = clear_code + 2;
+  // The code before this one; none right after a clear code.
+  constexpr std::uint32_t kNoCode = kMaxLzwCodes;
+  std::uint32_t previous = kNoCode;
+  std::uint8_t first_index = 0;
+  std::size_t written = 0;
+
+  std::uint32_t bits = 0;
+  std::uint32_t bit_count = 0;
+  std::size_t offset = 0;
+  while (written < pixel_count) {
+    // Codes are packed least significant bit first.
+    while (bit_count < code_size && offset < data.size()) {
+      bits |= static_cast<std::uint32_t>(data[offset++]) << bit_count;
+      bit_count += 8;
+    }
+    if (bit_count < code_size) {
+      break;
+    }
+    std::uint32_t code = bits & ((1U << code_size) - 1);
+    bits >>= code_size;
+    bit_count -= code_size;
+
+    if (code == clear_code) {
+      code_size = min_code_size + 1;
+      next_code = clear_code + 2;
+      previous = kNoCode;
+      continue;
+    }
+    if (code == end_code) {
+      break;
+    }
+    if (previous == kNoCode) {
+      if (code >= clear_code) {
+        break;
+      }
+      first_index = suffix[code];
+      ++written;
+      if (!output(first_index)) {
+        return;
+      }
+      previous = code;
+      continue;
+    }
+
+    const std::uint32_t current = code;
+    std::size_t depth = 0;
+    if (code >= next_code) {
+      // The code being defined right now: previous string plus its own
+      // first index.
+      if (code > next_code) {
+        break;
+      }
+      stack[depth++] = first_index;
+      code = previous;
+    }
+    while (code >= clear_code) {
+      stack[depth++] = suffix[code];
+      code = prefix[code];
+    }
+    first_index = suffix[code];
+    stack[depth++] = first_index;
+    while (depth > 0 && written < pixel_count) {
+      ++written;
+      if (!output(stack[--depth])) {
+        return;
+      }
+    }
+
+    if (next_code < kMaxLzwCodes) {
+      prefix[next_code] = static_cast<std::uint16_t>(previous);
+      suffix[next_code] = first_index;
+      ++next_code;
+      if (next_code == (1U << code_size) && code_size < 12) {
+        ++code_size;
+      }
+    }
+    previous = current;
+  }
+}
+
+} // namespace
+
+std::vector<std::uint8_t> DecodeGifLzw(std::span<const std::uint8_t> data,
+                                       std::uint8_t min_code_size,
+                                       std::size_t pixel_count) {
+  std::vector<std::uint8_t> pixels(pixel_count, 0);
+  std::size_t written = 0;
+  DecodeLzw(data, min_code_size, pixel_count, [&](std::uint8_t index) {
+    pixels[written++] = index;
+    return true;
+  });
+  return pixels;
+}
+
+bool GifDecoder::Open(const std::filesystem::path &file) {
+  std::ifstream stream(file, std::ios::binary);
+  if (!stream) {
+    Close();
+    return false;
+  }
+  const std::vector<std::uint8_t> data(
+      (std::istreambuf_iterator<char>(stream)),
+      std::istreambuf_iterator<char>());
+  return Load(data);
+}
+
+bool GifDecoder::Load(std::span<const std::uint8_t> data) {
+  Close();
+  const std::string_view signature(
+      reinterpret_cast<const char *>(data.data()),
+      std::min<std::size_t>(data.size(), 6));
+  if (signature != "GIF87a" && signature != "GIF89a") {
+    return false;
+  }
+
+  ByteReader reader(data.subspan(6));
+  if (!reader.Has(7)) {
+    return false;
+  }
+  width_ = reader.Word();
+  height_ = reader.Word();
+  const std::uint8_t screen_flags = reader.Byte();
+  reader.Byte(); // Background color: transparent areas are left black.
+  reader.Byte(); // Pixel aspect ratio.
+  if (width_ == 0 || height_ == 0 ||
+      static_cast<std::size_t>(width_) * height_ > kMaxPixels) {
+    Close();
+    return false;
+  }
+  if ((screen_flags & 0x80) != 0) {
+    global_palette_ = reader.Palette(std::size_t{2} << (screen_flags & 0x07));
+  }
+
+  Frame pending;
+  while (reader.Has(1)) {
+    const std::uint8_t block = reader.Byte();
+    if (block == kTrailer) {
+      break;
+    }
+    if (block == kExtensionIntroducer) {
+      const std::uint8_t label = reader.Byte();
+      if (label == kGraphicControlLabel && reader.Has(6)) {
+        reader.Byte(); // Block size, always 4.
+        const std::uint8_t flags = reader.Byte();
+        const std::uint32_t delay_cs = reader.Word();
+        const std::uint8_t transparent = reader.Byte();
+        pending.disposal = (flags >> 2) & 0x07;
+        pending.delay_ms = delay_cs <= 1 ? kDefaultGifDelayMs : delay_cs * 10;
+        if ((flags & 0x01) != 0) {
+          pending.transparent_index = transparent;
+        }
+      }
+      // The rest of a graphic control block, and comments, text and
+      // application extensions such as the loop count, are not needed.
+      if (!reader.SubBlocks(nullptr)) {
+        break;
+      }
+      continue;
+    }
+    if (block != kImageSeparator || !reader.Has(10)) {
+      break;
+    }
+
+    Frame frame = std::move(pending);
+    pending = Frame{};
+    frame.left = reader.Word();
+    frame.top = reader.Word();
+    frame.width = reader.Word();
+    frame.height = reader.Word();
+    const std::uint8_t image_flags = reader.Byte();
+    frame.interlaced = (image_flags & 0x40) != 0;
+    if ((image_flags & 0x80) != 0) {
+      frame.palette = reader.Palette(std::size_t{2} << (image_flags & 0x07));
+    }
+    frame.min_code_size = reader.Byte();
+    // A truncated last image still shows what it has.
+    const bool complete = reader.SubBlocks(&frame.data);
+    const bool on_screen = frame.left < width_ && frame.top < height_ &&
+                           frame.width > 0 && frame.height > 0;
+    if (!on_screen && !frames_.empty()) {
+      // Nothing of it is drawn; the frame before it is shown that much
+      // longer instead.
+      total_delay_ += frame.delay_ms;
+      frames_.back().delay_ms += frame.delay_ms;
+    } else if (on_screen && !frame.data.empty()) {
+      total_delay_ += frame.delay_ms;
+      frames_.push_back(std::move(frame));
+    }
+    if (!complete) {
+      break;
+    }
+  }
+
+  if (frames_.empty()) {
+    Close();
+    return false;
+  }
+  const std::size_t frame_bytes = std::size_t{3} * width_ * height_;
+  cache_frames_ = frame_bytes * frames_.size() <= kMaxCachedBytes;
+  return true;
+}
+
+void GifDecoder::Close() {
+  width_ = 0;
+  height_ = 0;
+  global_palette_.clear();
+  frames_.clear();
+  total_delay_ = 0;
+  canvas_.clear();
+  saved_.clear();
+  next_index_ = 0;
+  cache_frames_ = false;
+  cache_.clear();
+}
+
+std::uint32_t GifDecoder::GetFrameDelay(std::uint32_t index) const {
+  return index < frames_.size() ? frames_[index].delay_ms
+                                : kDefaultGifDelayMs;
+}
+
+std::size_t GifDecoder::GetMemoryUsage() const {
+  std::size_t bytes = canvas_.capacity() + saved_.capacity();
+  for (const Frame &frame : frames_) {
+    bytes += frame.data.capacity() + 3 * frame.palette.capacity();
+  }
+  for (const auto &frame : cache_) {
+    bytes += frame.capacity();
+  }
+  return bytes;
+}
+
+const std::uint8_t *GifDecoder::DecodeFrame(std::uint32_t index) {
+  if (index >= frames_.size()) {
+    return nullptr;
+  }
+  if (index < cache_.size()) {
+    return cache_[index].data();
+  }
+  if (index + 1 < next_index_ || canvas_.empty()) {
+    // Disposal makes every frame depend on the ones before it.
+    canvas_.assign(std::size_t{3} * width_ * height_, 0);
+    next_index_ = 0;
+  }
+  while (next_index_ <= index) {
+    Composite(next_index_++);
+    if (cache_frames_ && cache_.size() + 1 == next_index_) {
+      cache_.push_back(canvas_);
+    }
+  }
+  return canvas_.data();
+}
+
+void GifDecoder::Composite(std::uint32_t index) {
+  if (index > 0) {
+    const Frame &previous = frames_[index - 1];
+    if (previous.disposal == kDisposeToBackground) {
+      ClearRect(previous);
+    } else if (previous.disposal == kDisposeToPrevious &&
+               saved_.size() == canvas_.size()) {
+      canvas_ = saved_;
+    }
+  }
+
+  const Frame &frame = frames_[index];
+  if (frame.disposal == kDisposeToPrevious) {
+    saved_ = canvas_;
+  }
+  const auto &palette =
+      frame.palette.empty() ? global_palette_ : frame.palette;
+
+  // Palette indices go straight to BGR as they are decompressed; frames
+  // may extend past the logical screen and are clipped. Load() only keeps
+  // frames that start on the screen.
+  const std::uint32_t visible_width =
+      std::min(frame.width, width_ - frame.left);
+  const std::uint32_t visible_rows =
+      std::min(frame.height, height_ - frame.top);
+  std::uint32_t row = 0;
+  std::uint32_t x = 0;
+  std::uint8_t *target = nullptr;
+  const auto start_row = [&] {
+    const std::uint32_t y =
+        frame.interlaced ? InterlacedRow(row, frame.height) : row;
+    target = y < visible_rows
+                 ? canvas_.data() +
+                       3 * (static_cast<std::size_t>(frame.top + y) * width_ +
+                            frame.left)
+                 : nullptr;
+  };
+  start_row();
+  DecodeLzw(frame.data, frame.min_code_size,
+            static_cast<std::size_t>(frame.width) * frame.height,
+            [&](std::uint8_t color_index) {
+              if (target != nullptr && x < visible_width &&
+                  color_index != frame.transparent_index &&
+                  color_index < palette.size()) {
+                const auto &color = palette[color_index];
+                std::uint8_t *pixel = target + 3 * static_cast<std::size_t>(x);
+                pixel[0] = color[2];
+                pixel[1] = color[1];
+                pixel[2] = color[0];
+              }
+              if (++x < frame.width) {
+                return true;
+              }
+              x = 0;
+              ++row;
+              // Rows are stored top to bottom unless interlaced, so the rest
+              // is off the screen.
+              if (!frame.interlaced && row >= visible_rows) {
+                return false;
+              }
+              start_row();
+              return true;
+            });
+}
+
+void GifDecoder::ClearRect(const Frame &frame) {
+  const std::uint32_t right = std::min(width_, frame.left + frame.width);
+  const std::uint32_t bottom = std::min(height_, frame.top + frame.height);
+  if (frame.left >= right) {
+    return;
+  }
+  for (std::uint32_t y = frame.top; y < bottom; ++y) {
+    std::uint8_t *row = canvas_.data() + 3 * static_cast<std::size_t>(y) *
+                                             width_;
+    std::fill(row + 3 * static_cast<std::size_t>(frame.left),
+              row + 3 * static_cast<std::size_t>(right), 0);
+  }
+}
+
+} // namespace terminal_animation
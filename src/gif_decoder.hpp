@@ -0,0 +1,116 @@
+#pragma once
+
+// std
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace terminal_animation {
+
+// Browsers show frames with a delay of 0 or 10 ms for 100 ms, and so do
+// we: such GIFs were made to rely on it.
+inline constexpr std::uint32_t kDefaultGifDelayMs = 100;
+
+// Decodes the LZW-compressed color indices of one GIF image. Stops once
+// pixel_count indices are produced, at the end code, or at the first
+// invalid code, so a damaged image yields its intact part. Returns
+// exactly pixel_count indices; missing ones are 0.
+std::vector<std::uint8_t> DecodeGifLzw(std::span<const std::uint8_t> data,
+                                       std::uint8_t min_code_size,
+                                       std::size_t pixel_count);
+
+// Plays GIF files without a video decoder. The file is parsed once into
+// its frames' compressed data; frames are then decompressed and composited
+// straight from their palette into a BGR canvas, honoring transparency,
+// interlacing and the disposal methods. Small animations keep every
+// composited frame, so looping and seeking cost a copy at most. Not
+// thread-safe.
+class GifDecoder {
+public:
+  // Animations up to this many bytes of composited frames are cached.
+  static constexpr std::size_t kMaxCachedBytes = 32 << 20;
+  // Logical screens with more pixels are rejected, so a corrupt header
+  // cannot make the canvas take gigabytes.
+  static constexpr std::size_t kMaxPixels = std::size_t{1} << 24;
+
+  // Reads and parses file. Returns false if it cannot be read, is not a
+  // GIF, has a logical screen of more than kMaxPixels or has no frames on
+  // it.
+  bool Open(const std::filesystem::path &file);
+
+  // Like Open(), for a GIF already in memory.
+  bool Load(std::span<const std::uint8_t> data);
+
+  void Close();
+
+  bool IsOpen() const { return !frames_.empty(); }
+
+  std::uint32_t GetWidth() const { return width_; }
+  std::uint32_t GetHeight() const { return height_; }
+
+  std::uint32_t GetFrameCount() const {
+    return static_cast<std::uint32_t>(frames_.size());
+  }
+
+  // Returns how long the frame at index is shown, in milliseconds.
+  std::uint32_t GetFrameDelay(std::uint32_t index) const;
+
+  // Returns the sum of all frame delays, in milliseconds.
+  std::uint64_t GetTotalDelay() const { return total_delay_; }
+
+  // Returns the bytes held by the compressed frames, the canvas and the
+  // cached frames.
+  std::size_t GetMemoryUsage() const;
+
+  // Returns the composited frame at index as GetWidth() x GetHeight()
+  // packed B, G, R pixels, or nullptr if there is no such frame. Pixels
+  // never drawn are black. The data stays valid until the next call or
+  // Close(). Frames after the last decoded one are composited in order;
+  // going back starts over from the first frame unless the animation is
+  // cached.
+  const std::uint8_t *DecodeFrame(std::uint32_t index);
+
+private:
+  struct Frame {
+    std::uint32_t left = 0;
+    std::uint32_t top = 0;
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+    bool interlaced = false;
+    // Empty for frames using the global color table.
+    std::vector<std::array<std::uint8_t, 3>> palette;
+    std::optional<std::uint8_t> transparent_index;
+    std::uint8_t disposal = 0;
+    std::uint32_t delay_ms = kDefaultGifDelayMs;
+    std::uint8_t min_code_size = 2;
+    // The image's data sub-blocks, concatenated.
+    std::vector<std::uint8_t> data;
+  };
+
+  // Draws frames_[index] onto canvas_, after disposing of the frame before
+  // it.
+  void Composite(std::uint32_t index);
+
+  // Fills the part of canvas_ covered by frame with black.
+  void ClearRect(const Frame &frame);
+
+  std::uint32_t width_ = 0;
+  std::uint32_t height_ = 0;
+  std::vector<std::array<std::uint8_t, 3>> global_palette_;
+  std::vector<Frame> frames_;
+  std::uint64_t total_delay_ = 0;
+
+  // Compositing state: canvas_ shows frame next_index_ - 1, and saved_
+  // holds the canvas before the last frame that restores it when disposed.
+  std::vector<std::uint8_t> canvas_;
+  std::vector<std::uint8_t> saved_;
+  std::uint32_t next_index_ = 0;
+  bool cache_frames_ = false;
+  std::vector<std::vector<std::uint8_t>> cache_;
+};
+
+} // namespace terminal_animation
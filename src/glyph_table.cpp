@@ -0,0 +1,33 @@
+// header
+#include "glyph_table.hpp"
+
+// std
+#include <algorithm>
+
+namespace terminal_animation {
+
+namespace {
+
+GlyphTable active_table = kDensityGlyphs;
+
+} // namespace
+
+std::optional<GlyphTable> ParseCharset(std::string_view text) {
+  for (const BuiltinCharset &charset : kBuiltinCharsets) {
+    if (text == charset.name) {
+      return charset.table;
+    }
+  }
+  if (text.size() < 2 || !std::all_of(text.begin(), text.end(), [](char c) {
+        return c >= ' ' && c <= '~';
+      })) {
+    return std::nullopt;
+  }
+  return MakeGlyphTable(text);
+}
+
+const GlyphTable &GetGlyphTable() { return active_table; }
+
+void SetGlyphTable(const GlyphTable &table) { active_table = table; }
+
+} // namespace terminal_animation
@@ -0,0 +1,66 @@
+#pragma once
+
+// local
+#include "common.hpp"
+
+// std
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace terminal_animation {
+
+// The glyph drawn for every 8-bit luminance, so converting a cell is one
+// lookup instead of a range mapping.
+using GlyphTable = std::array<char, 256>;
+
+// Builds the table for a charset ordered from dense (dark) to sparse
+// (bright). Luminance v gets the glyph MapValue() picks for it.
+constexpr GlyphTable MakeGlyphTable(std::string_view charset) {
+  GlyphTable table{};
+  const auto last = static_cast<std::uint32_t>(charset.size() - 1);
+  for (std::uint32_t value = 0; value < table.size(); ++value) {
+    table[value] = charset[MapValue(value, 0U, 255U, 0U, last)];
+  }
+  return table;
+}
+
+// Rec. 709 luma of an 8-bit color in 16-bit fixed point. The weights sum
+// to exactly 65536, so white stays 255.
+constexpr std::uint8_t Rec709Luminance(std::uint32_t r, std::uint32_t g,
+                                       std::uint32_t b) {
+  return static_cast<std::uint8_t>((13933 * r + 46871 * g + 4732 * b) >> 16);
+}
+
+// A named charset that ships with the player.
+struct BuiltinCharset {
+  std::string_view name;
+  GlyphTable table;
+};
+
+inline constexpr std::array<BuiltinCharset, 3> kBuiltinCharsets{{
+    // The default: 70 levels for smooth gradients.
+    {.name = "density", .table = MakeGlyphTable(kAsciiDensity)},
+    // 10 levels with strong contrast between neighbors.
+    {.name = "standard", .table = MakeGlyphTable("@%#*+=-:. ")},
+    // Two levels: a stencil of the bright and dark regions.
+    {.name = "binary", .table = MakeGlyphTable("# ")},
+}};
+
+inline constexpr const GlyphTable &kDensityGlyphs = kBuiltinCharsets[0].table;
+
+// Returns the table for a built-in charset name, or for text taken as a
+// custom charset: at least two printable ASCII characters ordered from
+// dense to sparse. Returns nullopt for anything else.
+std::optional<GlyphTable> ParseCharset(std::string_view text);
+
+// Returns the table every conversion uses; kDensityGlyphs unless
+// SetGlyphTable() chose another.
+const GlyphTable &GetGlyphTable();
+
+// Selects the table every conversion uses. Not synchronized: call it at
+// startup, before anything is converted.
+void SetGlyphTable(const GlyphTable &table);
+
+} // namespace terminal_animation
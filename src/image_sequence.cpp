@@ -0,0 +1,149 @@
+// header
+#include "image_sequence.hpp"
+
+// local
+#include "common.hpp"
+
+// std
+#include <algorithm>
+#include <cctype>
+#include <optional>
+#include <string>
+#include <system_error>
+
+namespace terminal_animation {
+
+namespace {
+
+// A file name split around its frame number conversion.
+struct SequencePattern {
+  std::string prefix;
+  std::string suffix;
+  std::size_t min_digits = 1;
+};
+
+bool IsDigit(char c) { return std::isdigit(static_cast<unsigned char>(c)); }
+
+std::optional<SequencePattern> ParsePattern(const std::string &name) {
+  const std::size_t percent = name.find('%');
+  if (percent == std::string::npos) {
+    return std::nullopt;
+  }
+  std::size_t position = percent + 1;
+  const bool zero_padded = position < name.size() && name[position] == '0';
+  std::size_t width = 0;
+  while (position < name.size() && IsDigit(name[position])) {
+    width = width * 10 + static_cast<std::size_t>(name[position] - '0');
+    ++position;
+  }
+  if (position >= name.size() || name[position] != 'd' ||
+      (width > 0 && !zero_padded)) {
+    return std::nullopt;
+  }
+  return SequencePattern{.prefix = name.substr(0, percent),
+                         .suffix = name.substr(position + 1),
+                         .min_digits = std::max<std::size_t>(1, width)};
+}
+
+bool MatchesPattern(const SequencePattern &pattern, const std::string &name) {
+  if (name.size() < pattern.prefix.size() + pattern.suffix.size() ||
+      !name.starts_with(pattern.prefix) || !name.ends_with(pattern.suffix)) {
+    return false;
+  }
+  const std::string_view digits =
+      std::string_view(name).substr(pattern.prefix.size(),
+                                    name.size() - pattern.prefix.size() -
+                                        pattern.suffix.size());
+  return digits.size() >= pattern.min_digits &&
+         std::all_of(digits.begin(), digits.end(), IsDigit);
+}
+
+// Returns the run of digits starting at position, without leading zeros.
+std::string_view TakeNumber(std::string_view text, std::size_t &position) {
+  const std::size_t start = position;
+  while (position < text.size() && IsDigit(text[position])) {
+    ++position;
+  }
+  std::string_view number = text.substr(start, position - start);
+  while (number.size() > 1 && number.front() == '0') {
+    number.remove_prefix(1);
+  }
+  return number;
+}
+
+} // namespace
+
+bool IsImageSequencePattern(const std::filesystem::path &path) {
+  return ParsePattern(path.filename().string()).has_value();
+}
+
+bool NaturalLess(std::string_view a, std::string_view b) {
+  std::size_t i = 0;
+  std::size_t j = 0;
+  while (i < a.size() && j < b.size()) {
+    if (IsDigit(a[i]) && IsDigit(b[j])) {
+      const std::string_view number_a = TakeNumber(a, i);
+      const std::string_view number_b = TakeNumber(b, j);
+      // Without leading zeros, a longer number is a larger one.
+      if (number_a.size() != number_b.size()) {
+        return number_a.size() < number_b.size();
+      }
+      if (number_a != number_b) {
+        return number_a < number_b;
+      }
+      continue;
+    }
+    if (a[i] != b[j]) {
+      return a[i] < b[j];
+    }
+    ++i;
+    ++j;
+  }
+  if (i < a.size() || j < b.size()) {
+    return j < b.size();
+  }
+  // Equal up to leading zeros: fall back to a plain comparison so the
+  // order stays strict.
+  return a < b;
+}
+
+std::vector<std::filesystem::path>
+FindImageSequence(const std::filesystem::path &source) {
+  std::error_code error;
+  const bool is_directory = std::filesystem::is_directory(source, error);
+  std::optional<SequencePattern> pattern;
+  std::filesystem::path directory = source;
+  if (!is_directory) {
+    pattern = ParsePattern(source.filename().string());
+    if (!pattern.has_value()) {
+      return {};
+    }
+    directory = source.has_parent_path() ? source.parent_path() : ".";
+  }
+
+  std::vector<std::filesystem::path> frames;
+  for (std::filesystem::directory_iterator it(directory, error), end;
+       !error && it != end; it.increment(error)) {
+    if (!it->is_regular_file(error)) {
+      continue;
+    }
+    const std::filesystem::path &path = it->path();
+    if (pattern.has_value() ? MatchesPattern(*pattern,
+                                             path.filename().string())
+                            : IsImageExtension(path)) {
+      frames.push_back(path);
+    }
+  }
+  if (error) {
+    return {};
+  }
+
+  std::sort(frames.begin(), frames.end(),
+            [](const std::filesystem::path &a, const std::filesystem::path &b) {
+              return NaturalLess(a.filename().string(),
+                                 b.filename().string());
+            });
+  return frames;
+}
+
+} // namespace terminal_animation
@@ -0,0 +1,31 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+namespace terminal_animation {
+
+// Frame rate of image sequences when none is chosen.
+inline constexpr std::uint32_t kDefaultSequenceFramerate = 24;
+
+// Returns true if the file name contains a printf-style frame number such
+// as %d or %05d, e.g. renders/frame_%05d.png.
+bool IsImageSequencePattern(const std::filesystem::path &path);
+
+// Orders strings with runs of digits compared by value, so frame_9.png
+// comes before frame_10.png.
+bool NaturalLess(std::string_view a, std::string_view b);
+
+// Returns the frames of an image sequence in playback order. source is
+// either a directory, whose images (see IsImageExtension()) are played in
+// natural order, or a pattern (see IsImageSequencePattern()), which matches
+// the files of its directory with any frame number in its place; a width
+// such as %05d is the minimum number of digits. Returns an empty list if
+// nothing matches or the directory cannot be read.
+std::vector<std::filesystem::path>
+FindImageSequence(const std::filesystem::path &source);
+
+} // namespace terminal_animation
@@ -0,0 +1,29 @@
+#pragma once
+
+// lib
+// spdlog
+#include "spdlog/async.h"
+#include "spdlog/sinks/basic_file_sink.h"
+#include "spdlog/spdlog.h"
+
+// std
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace terminal_animation {
+
+// Returns the async file logger with the given name, creating it on first
+// use. spdlog refuses to register two loggers with the same name, so every
+// instance of a class shares one logger through this function.
+inline std::shared_ptr<spdlog::logger> GetLogger(const std::string &name) {
+  static std::mutex mutex_loggers;
+  std::lock_guard<std::mutex> lock(mutex_loggers);
+  if (auto logger = spdlog::get(name)) {
+    return logger;
+  }
+  return spdlog::basic_logger_mt<spdlog::async_factory>(name,
+                                                        "logs/debug.txt");
+}
+
+} // namespace terminal_animation
@@ -0,0 +1,93 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace terminal_animation {
+
+// Least-recently-used cache bounded by a cost budget. Every entry carries a
+// cost (1 by default, or e.g. its size in bytes); inserting past the budget
+// evicts the least recently used entries. Not thread-safe: callers lock.
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache {
+public:
+  explicit LruCache(std::size_t budget) : budget_(budget) {}
+
+  // Returns the cached value and marks it most recently used, or nullptr.
+  Value *Get(const Key &key) {
+    auto found = index_.find(key);
+    if (found == index_.end()) {
+      return nullptr;
+    }
+    items_.splice(items_.begin(), items_, found->second);
+    return &found->second->value;
+  }
+
+  bool Contains(const Key &key) const { return index_.contains(key); }
+
+  // Inserts or replaces the value for key as the most recently used entry,
+  // then evicts older entries until the total cost fits the budget. The new
+  // entry itself is never evicted by this call.
+  void Put(const Key &key, Value value, std::size_t cost = 1) {
+    Erase(key);
+    items_.push_front({key, std::move(value), cost});
+    index_.emplace(key, items_.begin());
+    total_cost_ += cost;
+    Shrink();
+  }
+
+  // Removes the entry for key. Returns false if there was none.
+  bool Erase(const Key &key) {
+    auto found = index_.find(key);
+    if (found == index_.end()) {
+      return false;
+    }
+    total_cost_ -= found->second->cost;
+    items_.erase(found->second);
+    index_.erase(found);
+    return true;
+  }
+
+  void Clear() {
+    items_.clear();
+    index_.clear();
+    total_cost_ = 0;
+  }
+
+  // Changes the budget, evicting entries if the cache no longer fits.
+  void SetBudget(std::size_t budget) {
+    budget_ = budget;
+    Shrink();
+  }
+
+  std::size_t Size() const { return items_.size(); }
+  std::size_t TotalCost() const { return total_cost_; }
+  std::size_t Budget() const { return budget_; }
+
+private:
+  struct Item {
+    Key key;
+    Value value;
+    std::size_t cost;
+  };
+
+  void Shrink() {
+    while (total_cost_ > budget_ && items_.size() > 1) {
+      const Item &oldest = items_.back();
+      total_cost_ -= oldest.cost;
+      index_.erase(oldest.key);
+      items_.pop_back();
+    }
+  }
+
+  std::size_t budget_;
+  std::size_t total_cost_ = 0;
+  std::list<Item> items_;
+  std::unordered_map<Key, typename std::list<Item>::iterator, Hash> index_;
+};
+
+} // namespace terminal_animation
@@ -1,8 +1,123 @@
 // local
 #include "animation_ui.hpp"
+#include "broadcast_server.hpp"
+#include "command_line.hpp"
+#include "frame_scheduler.hpp"
+#include "stream_viewer.hpp"
+#include "task_scheduler.hpp"
+#include "temporal_filter.hpp"
 
-int main() {
-  terminal_animation::AnimationUI animation_ui;
+// std
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <csignal>
+#include <pthread.h>
+#endif
+
+namespace {
+
+// Reads the task scheduler options from the environment:
+// TERMINAL_ANIMATION_WORKERS sets the worker count (default: one per
+// hardware thread), TERMINAL_ANIMATION_PIN_WORKERS=1 pins workers to CPUs.
+terminal_animation::TaskScheduler::Options ReadSchedulerOptions() {
+  terminal_animation::TaskScheduler::Options options;
+  if (const char *workers = std::getenv("TERMINAL_ANIMATION_WORKERS")) {
+    options.worker_count =
+        static_cast<std::uint32_t>(std::strtoul(workers, nullptr, 10));
+  }
+  if (const char *pin = std::getenv("TERMINAL_ANIMATION_PIN_WORKERS")) {
+    options.pin_workers = std::string(pin) == "1";
+  }
+  return options;
+}
+
+// Streams the file to clients until SIGINT or SIGTERM.
+int Serve(const terminal_animation::CommandLine &command_line) {
+#if defined(__linux__) || defined(__APPLE__)
+  // Blocked before any thread starts, so every thread inherits the mask
+  // and sigwait() below is the only receiver.
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+#endif
+
+  terminal_animation::TaskScheduler tasks(ReadSchedulerOptions());
+  terminal_animation::FrameScheduler frames(tasks);
+  terminal_animation::BroadcastServer server(frames, command_line.file,
+                                             command_line.socket);
+  if (!server.Start()) {
+    std::cerr << "Could not serve " << command_line.file << " on "
+              << command_line.socket << ", see logs/debug.txt\n";
+    return 1;
+  }
+  std::cerr << "Serving " << command_line.file << " on "
+            << command_line.socket << ", press Ctrl+C to stop\n";
+
+#if defined(__linux__) || defined(__APPLE__)
+  int received = 0;
+  sigwait(&signals, &received);
+#endif
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const auto command_line = terminal_animation::ParseCommandLine(
+      std::vector<std::string>(argv + 1, argv + argc));
+  if (!command_line.has_value()) {
+    std::cerr << terminal_animation::kUsage;
+    return 2;
+  }
+
+  terminal_animation::SetGlyphTable(command_line->glyphs);
+  terminal_animation::SetStabilizeThreshold(command_line->stabilize_threshold);
+
+  switch (command_line->mode) {
+  case terminal_animation::CommandLine::Mode::kServe:
+    return Serve(*command_line);
+  case terminal_animation::CommandLine::Mode::kConnect: {
+    terminal_animation::StreamViewer viewer(
+        command_line->socket,
+        {.size = command_line->size,
+         .color_depth = command_line->monochrome
+                            ? terminal_animation::ColorDepth::kMonochrome
+                            : terminal_animation::ColorDepth::kTrueColor});
+    if (!viewer.Run()) {
+      std::cerr << "Could not connect to " << command_line->socket << '\n';
+      return 1;
+    }
+    return 0;
+  }
+  case terminal_animation::CommandLine::Mode::kInteractive:
+    break;
+  }
+
+  terminal_animation::AnimationUI animation_ui(
+      ReadSchedulerOptions(),
+      command_line->thumbnail_cache
+          ? terminal_animation::ThumbnailCache::GetDefaultDiskDirectory()
+          : std::filesystem::path());
+  animation_ui.SetSequenceFramerate(command_line->sequence_fps);
+  if (!command_line->file.empty()) {
+    animation_ui.OpenFile(command_line->file);
+  }
+  if (!command_line->replay_file.empty()) {
+    if (!animation_ui.Replay(command_line->replay_file, std::cout)) {
+      std::cerr << "Could not replay " << command_line->replay_file << '\n';
+      return 1;
+    }
+    return 0;
+  }
+  if (!command_line->record_file.empty()) {
+    animation_ui.RecordEvents(command_line->record_file);
+  }
   animation_ui.Run();
   return 0;
 }
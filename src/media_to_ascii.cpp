@@ -1,145 +1,825 @@
 // header
 #include "media_to_ascii.hpp"
 
+// local
+#include "glyph_table.hpp"
+#include "temporal_filter.hpp"
+
 // std
 #include <algorithm>
 #include <cstdint>
 #include <filesystem>
+#include <limits>
+#include <optional>
+#include <thread>
 
 namespace terminal_animation {
 
-void MediaToAscii::OpenFile(const std::filesystem::path &file) {
-  should_render_.store(false);
+namespace {
+
+// Averages every geometry cell of plane, packed BGR pixels if kColor and a
+// single luma channel otherwise, and draws the cell's luminance from
+// glyphs. If kStabilize, cells are held from the previous frame as filter
+// allows. The averages divide by a reciprocal computed once per frame, so
+// the loop over cells has no division and no branch on the pixel format or
+// the filter.
+template <bool kColor, bool kStabilize>
+void ConvertCells(const cv::Mat &plane, const GridGeometry &geometry,
+                  const GlyphTable &glyphs, const TemporalFilter *filter,
+                  CharsAndColors &target) {
+  const std::uint32_t block_width = geometry.block_width;
+  const std::uint32_t block_height = geometry.block_height;
+  const ReciprocalDivider average(block_width * block_height);
+
+  // Walk cells and pixels in memory order of both the target and the frame.
+  std::size_t cell = 0;
+  for (std::uint32_t j = 0; j < geometry.rows; ++j) {
+    for (std::uint32_t i = 0; i < geometry.columns; ++i, ++cell) {
+      if constexpr (kColor) {
+        std::uint32_t sum_r = 0;
+        std::uint32_t sum_g = 0;
+        std::uint32_t sum_b = 0;
+        for (std::uint32_t bj = 0; bj < block_height; ++bj) {
+          const auto *row = plane.ptr<cv::Vec3b>(
+              static_cast<int>(j * block_height + bj));
+          for (std::uint32_t bi = 0; bi < block_width; ++bi) {
+            const cv::Vec3b &pixel = row[i * block_width + bi];
+            sum_b += pixel[0];
+            sum_g += pixel[1];
+            sum_r += pixel[2];
+          }
+        }
+        const std::uint32_t r = average(sum_r);
+        const std::uint32_t g = average(sum_g);
+        const std::uint32_t b = average(sum_b);
+        if constexpr (kStabilize) {
+          if (filter->HoldsColor(cell, r, g, b)) {
+            target.colors[cell] = filter->GetPrevious().colors[cell];
+            target.chars[cell] = filter->GetPrevious().chars[cell];
+            continue;
+          }
+        }
+        target.colors[cell] = {static_cast<std::uint8_t>(r),
+                               static_cast<std::uint8_t>(g),
+                               static_cast<std::uint8_t>(b)};
+        const std::uint8_t luminance = Rec709Luminance(r, g, b);
+        if constexpr (kStabilize) {
+          target.chars[cell] = filter->FilterGlyph(cell, luminance);
+        } else {
+          target.chars[cell] = glyphs[luminance];
+        }
+      } else {
+        std::uint32_t sum = 0;
+        for (std::uint32_t bj = 0; bj < block_height; ++bj) {
+          const auto *row = plane.ptr<std::uint8_t>(
+              static_cast<int>(j * block_height + bj));
+          for (std::uint32_t bi = 0; bi < block_width; ++bi) {
+            sum += row[i * block_width + bi];
+          }
+        }
+        const auto luminance = static_cast<std::uint8_t>(average(sum));
+        if constexpr (kStabilize) {
+          target.chars[cell] = filter->FilterGlyph(cell, luminance);
+        } else {
+          target.chars[cell] = glyphs[luminance];
+        }
+      }
+    }
+  }
+}
+
+} // namespace
+
+MediaToAscii::~MediaToAscii() {
+  std::lock_guard<std::mutex> lock_capture(mutex_video_capture_);
+  CloseImageSequence();
+  video_capture_.release();
+}
 
-  if (IsImageExtension(file)) {
+bool MediaToAscii::OpenFile(const std::filesystem::path &file) {
+  should_render_.store(false);
+  is_video_.store(false);
+  {
+    // frame_ may point into the previous raw video's read-only mapping,
+    // which decoding into it would fault on.
+    std::lock_guard<std::mutex> lock_capture(mutex_video_capture_);
     std::lock_guard<std::mutex> lock_frame(mutex_frame_);
-    frame_ = cv::imread(file.string());
-    if (frame_.empty()) {
+    frame_.release();
+    raw_video_.Close();
+    gif_.Close();
+    CloseImageSequence();
+  }
+
+  std::error_code error;
+  const bool is_sequence = IsImageSequencePattern(file) ||
+                           std::filesystem::is_directory(file, error);
+  if (IsImageExtension(file) && !is_sequence) {
+    // Decode only as many pixels as the current size can display.
+    image_file_ = file;
+    image_dimensions_ = ReadImageDimensions(file);
+    if (!DecodeImage(ChooseReduction())) {
       logger_->error("[MediaToAscii::OpenFile] Could not open image: {}",
                      file.string());
-      return;
+      return false;
+    }
+    {
+      std::lock_guard<std::mutex> lock_data(mutex_chars_and_colors_);
+      chars_and_colors_.assign(1, CharsAndColors{});
+      frame_generations_.assign(1, 0);
     }
-    is_video_.store(false);
   } else {
+    image_dimensions_.reset();
+    bool is_open = false;
     {
       std::lock_guard<std::mutex> lock_capture(mutex_video_capture_);
-      video_capture_.open(file.string());
+      if (is_sequence) {
+        video_capture_.release();
+        sequence_files_ = FindImageSequence(file);
+        sequence_position_.store(0);
+        is_open = IsImageSequence();
+        if (is_open) {
+          // Frames are decoded reduced like still images, assuming the
+          // whole sequence has the size of its first frame.
+          image_dimensions_ = ReadImageDimensions(sequence_files_.front());
+        }
+        if (is_open && sequence_decoder_ == nullptr) {
+          const std::uint32_t workers = std::clamp(
+              std::thread::hardware_concurrency(), 1U, kSequenceReadAhead);
+          sequence_decoder_ =
+              std::make_unique<TaskScheduler>(TaskScheduler::Options{
+                  .worker_count = workers, .pin_workers = false});
+        }
+      } else if (IsGifExtension(file) && gif_.Open(file)) {
+        video_capture_.release();
+        gif_position_.store(0);
+        is_open = true;
+      } else if (IsRawVideoExtension(file)) {
+        video_capture_.release();
+        is_open = raw_video_.Open(file);
+        raw_position_.store(0);
+      } else {
+        video_capture_.open(file.string());
+        is_open = video_capture_.isOpened();
+      }
     }
 
-    if (!video_capture_.isOpened()) {
+    if (!is_open) {
       logger_->error("[MediaToAscii::OpenFile] Could not open video: {}",
                      file.string());
-      return;
+      return false;
     }
 
-    // Some image formats are opened through ffmpeg and report 0 total frames.
-    if (GetTotalFrameCount() == 0) {
-      std::lock_guard<std::mutex> lock_frame(mutex_frame_);
-      video_capture_ >> frame_;
-      is_video_.store(false);
-    } else {
+    {
       std::lock_guard<std::mutex> lock_data(mutex_chars_and_colors_);
-      chars_and_colors_.clear();
-      chars_and_colors_.resize(GetTotalFrameCount());
-      is_video_.store(true);
+      // Some image formats are opened through ffmpeg and report 0 total
+      // frames; they are treated as a single still frame.
+      chars_and_colors_.assign(std::max(1U, GetTotalFrameCount()),
+                               CharsAndColors{});
+      frame_generations_.assign(chars_and_colors_.size(), 0);
     }
+
+    // Decode the first frame right away so it can be displayed while the
+    // rest of the video is rendered in the background.
+    ReadNextFrame();
+    is_video_.store(GetTotalFrameCount() > 0);
   }
 
+  CalculateCharsAndColors(0);
+
   should_render_.store(true);
+  return true;
 }
 
 void MediaToAscii::RenderVideo() {
-  while (GetCurrentFrameIndex() <= GetTotalFrameCount() &&
+  BeginVideoPass();
+  while (RenderVideoChunk(std::numeric_limits<std::uint32_t>::max())) {
+  }
+}
+
+void MediaToAscii::BeginVideoPass() {
+  pass_start_ = GetCurrentFrameIndex();
+  pass_wrapped_ = false;
+}
+
+bool MediaToAscii::RenderVideoChunk(std::uint32_t max_frames) {
+  if (!should_render_.load()) {
+    return false;
+  }
+
+  if (!pass_wrapped_) {
+    if (RenderVideoFrames(max_frames) == max_frames) {
+      return true;
+    }
+    pass_wrapped_ = true;
+
+    // Rendering was restarted mid-video, e.g. after a size or speed change;
+    // fill in the frames before the start position too.
+    bool needs_wrap = false;
+    for (std::uint32_t index = 0; index < pass_start_ && !needs_wrap;
+         ++index) {
+      needs_wrap = NeedsConversion(index);
+    }
+    if (!needs_wrap || !should_render_.load()) {
+      return false;
+    }
+    SetCurrentFrameIndex(0);
+    return true;
+  }
+
+  const std::uint32_t index = GetCurrentFrameIndex();
+  if (index >= pass_start_) {
+    return false;
+  }
+  const std::uint32_t count = std::min(max_frames, pass_start_ - index);
+  return RenderVideoFrames(count) == count &&
+         GetCurrentFrameIndex() < pass_start_;
+}
+
+std::uint32_t MediaToAscii::RenderVideoFrames(std::uint32_t max_frames) {
+  std::uint32_t rendered = 0;
+  while (rendered < max_frames &&
+         GetCurrentFrameIndex() < GetTotalFrameCount() &&
          should_render_.load()) {
-    {
-      std::lock_guard<std::mutex> lock_capture(mutex_video_capture_);
-      std::lock_guard<std::mutex> lock_frame(mutex_frame_);
-      video_capture_ >> frame_;
+    const std::uint32_t index = GetCurrentFrameIndex();
+    if (!NeedsConversion(index)) {
+      if (!SkipFrame()) {
+        break;
+      }
+      ++rendered;
+      continue;
+    }
+
+    // The container may report more frames than it has; stop at the real
+    // end instead of retrying the read until rendering is cancelled.
+    if (!ReadNextFrame()) {
+      break;
+    }
+    CalculateCharsAndColors(index);
+    ++rendered;
+  }
+  return rendered;
+}
+
+std::uint32_t MediaToAscii::GetFramerate() const {
+  if (IsImageSequence()) {
+    return sequence_fps_.load();
+  }
+  if (gif_.IsOpen()) {
+    const std::uint64_t total_delay = gif_.GetTotalDelay();
+    return static_cast<std::uint32_t>(std::max<std::uint64_t>(
+        1, (1000ULL * gif_.GetFrameCount() + total_delay / 2) / total_delay));
+  }
+  if (raw_video_.IsOpen()) {
+    const RawVideoLayout &layout = raw_video_.GetLayout();
+    return std::max(1U, (layout.fps_numerator + layout.fps_denominator / 2) /
+                            layout.fps_denominator);
+  }
+  return std::max(
+      1U, static_cast<std::uint32_t>(video_capture_.get(cv::CAP_PROP_FPS)));
+}
+
+std::chrono::milliseconds
+MediaToAscii::GetFrameDuration(std::uint32_t index) const {
+  if (gif_.IsOpen()) {
+    return std::chrono::milliseconds(gif_.GetFrameDelay(index));
+  }
+  return std::chrono::milliseconds(1000 / GetFramerate());
+}
+
+std::uint32_t MediaToAscii::GetCurrentFrameIndex() const {
+  if (IsImageSequence()) {
+    return sequence_position_.load();
+  }
+  if (gif_.IsOpen()) {
+    return gif_position_.load();
+  }
+  if (raw_video_.IsOpen()) {
+    return raw_position_.load();
+  }
+  return static_cast<std::uint32_t>(
+      video_capture_.get(cv::CAP_PROP_POS_FRAMES));
+}
+
+std::uint32_t MediaToAscii::GetTotalFrameCount() const {
+  if (IsImageSequence()) {
+    return static_cast<std::uint32_t>(sequence_files_.size());
+  }
+  if (gif_.IsOpen()) {
+    return gif_.GetFrameCount();
+  }
+  if (raw_video_.IsOpen()) {
+    return raw_video_.GetFrameCount();
+  }
+  return static_cast<std::uint32_t>(
+      video_capture_.get(cv::CAP_PROP_FRAME_COUNT));
+}
+
+void MediaToAscii::SetCurrentFrameIndex(std::uint32_t index) {
+  if (IsImageSequence()) {
+    sequence_position_.store(std::min(index, GetTotalFrameCount()));
+    return;
+  }
+  if (gif_.IsOpen()) {
+    // GifDecoder composites its way to the frame when it is read.
+    gif_position_.store(std::min(index, gif_.GetFrameCount()));
+    return;
+  }
+  if (raw_video_.IsOpen()) {
+    raw_position_.store(std::min(index, raw_video_.GetFrameCount()));
+    return;
+  }
+  video_capture_.set(cv::CAP_PROP_POS_FRAMES, index);
+}
+
+bool MediaToAscii::ReadNextFrame() {
+  std::lock_guard<std::mutex> lock_capture(mutex_video_capture_);
+  if (IsImageSequence()) {
+    const std::uint32_t index = sequence_position_.load();
+    if (index >= GetTotalFrameCount()) {
+      return false;
+    }
+    // Wait for the decode without holding mutex_frame_, so the shown frame
+    // stays readable meanwhile.
+    cv::Mat image = TakeSequenceFrame(index);
+    sequence_position_.store(index + 1);
+    if (image.empty()) {
+      // Keep the previous frame rather than ending the sequence early.
+      logger_->warn("[MediaToAscii::ReadNextFrame] Could not decode {}",
+                    sequence_files_[index].string());
+      return true;
+    }
+    std::lock_guard<std::mutex> lock_frame(mutex_frame_);
+    frame_ = std::move(image);
+    return true;
+  }
+
+  std::lock_guard<std::mutex> lock_frame(mutex_frame_);
+  if (gif_.IsOpen()) {
+    const std::uint32_t index = gif_position_.load();
+    const std::uint8_t *pixels = gif_.DecodeFrame(index);
+    if (pixels == nullptr) {
+      return false;
+    }
+    // The composited frame is BGR already. cv::Mat wants a mutable
+    // pointer, but the frame is only read.
+    frame_ = cv::Mat(static_cast<int>(gif_.GetHeight()),
+                     static_cast<int>(gif_.GetWidth()), CV_8UC3,
+                     const_cast<std::uint8_t *>(pixels));
+    gif_position_.store(index + 1);
+    return true;
+  }
+  if (raw_video_.IsOpen()) {
+    const std::uint32_t index = raw_position_.load();
+    if (!ReadRawFrame(index)) {
+      return false;
+    }
+    raw_position_.store(index + 1);
+    return true;
+  }
+  // Decodes into frame_'s buffer, which Mat::create() keeps as long as the
+  // frame size does not change.
+  video_capture_ >> frame_;
+  return !frame_.empty();
+}
+
+bool MediaToAscii::SkipFrame() {
+  std::lock_guard<std::mutex> lock_capture(mutex_video_capture_);
+  if (IsImageSequence()) {
+    // Files are decoded independently, so a skipped one is never read.
+    const std::uint32_t index = sequence_position_.load();
+    if (index >= GetTotalFrameCount()) {
+      return false;
+    }
+    sequence_position_.store(index + 1);
+    return true;
+  }
+  if (gif_.IsOpen()) {
+    // Compositing is deferred until a frame is read.
+    const std::uint32_t index = gif_position_.load();
+    if (index >= gif_.GetFrameCount()) {
+      return false;
     }
-    // cv::CAP_PROP_POS_FRAMES starts at 1 after the first read.
-    CalculateCharsAndColors(
-        static_cast<std::uint32_t>(GetCurrentFrameIndex()) - 1);
+    gif_position_.store(index + 1);
+    return true;
   }
+  if (raw_video_.IsOpen()) {
+    // Nothing needs decoding, so skipping a raw frame is free.
+    const std::uint32_t index = raw_position_.load();
+    if (index >= raw_video_.GetFrameCount()) {
+      return false;
+    }
+    raw_position_.store(index + 1);
+    return true;
+  }
+  // grab() demuxes and decodes but skips the BGR conversion in retrieve()
+  // and the ASCII conversion.
+  return video_capture_.grab();
+}
+
+void MediaToAscii::QueueSequenceDecodes(std::uint32_t index) {
+  const std::uint32_t reduction = ChooseReduction();
+  const std::uint32_t end =
+      std::min(index + kSequenceReadAhead, GetTotalFrameCount());
+  for (std::uint32_t next = index; next < end; ++next) {
+    if (sequence_decodes_.contains(next) || !NeedsConversion(next)) {
+      continue;
+    }
+    auto decode = std::make_shared<SequenceDecode>();
+    decode->reduction = reduction;
+    decode->task = sequence_decoder_->Submit(
+        TaskPriority::kLookAhead,
+        [decode, file = sequence_files_[next], reduction] {
+          decode->image = ReadImage(file, reduction);
+        });
+    sequence_decodes_.emplace(next, std::move(decode));
+  }
+}
+
+cv::Mat MediaToAscii::TakeSequenceFrame(std::uint32_t index) {
+  // Drop decodes the position moved past or away from, e.g. after a seek.
+  for (auto it = sequence_decodes_.begin(); it != sequence_decodes_.end();) {
+    if (it->first < index || it->first >= index + kSequenceReadAhead) {
+      it->second->task.Cancel();
+      it = sequence_decodes_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  QueueSequenceDecodes(index);
+
+  const std::uint32_t reduction = ChooseReduction();
+  const auto found = sequence_decodes_.find(index);
+  if (found != sequence_decodes_.end()) {
+    const std::shared_ptr<SequenceDecode> decode = std::move(found->second);
+    sequence_decodes_.erase(found);
+    // A decode queued before a size or zoom change may be too coarse.
+    if (decode->reduction == reduction) {
+      decode->task.Wait();
+      if (!decode->image.empty()) {
+        return std::move(decode->image);
+      }
+    } else {
+      decode->task.Cancel();
+    }
+  }
+  // The frame was not queued, was cancelled, or was decoded at another
+  // scale.
+  return ReadImage(sequence_files_[index], reduction);
+}
+
+void MediaToAscii::CloseImageSequence() {
+  for (const auto &[index, decode] : sequence_decodes_) {
+    decode->task.Cancel();
+  }
+  sequence_decodes_.clear();
+  sequence_files_.clear();
+  sequence_position_.store(0);
+}
+
+bool MediaToAscii::ReadRawFrame(std::uint32_t index) {
+  cv::Mat frame =
+      DecodeRawFrame(raw_video_, index, monochrome_.load(), raw_converted_);
+  if (frame.empty()) {
+    return false;
+  }
+  frame_ = std::move(frame);
+  return true;
+}
+
+cv::Mat MediaToAscii::DecodeRawFrame(const RawVideoReader &reader,
+                                     std::uint32_t index, bool monochrome,
+                                     cv::Mat &converted) {
+  const std::uint8_t *data = reader.GetFrame(index);
+  if (data == nullptr) {
+    return {};
+  }
+  const RawVideoLayout &layout = reader.GetLayout();
+  const auto width = static_cast<int>(layout.width);
+  const auto height = static_cast<int>(layout.height);
+  // cv::Mat wants a mutable pointer, but frames are only ever read.
+  auto *pixels = const_cast<std::uint8_t *>(data);
+
+  switch (layout.format) {
+  case RawPixelFormat::kBgr:
+    return cv::Mat(height, width, CV_8UC3, pixels);
+  case RawPixelFormat::kGray:
+    // ConvertFrame() reads a single plane as it is.
+    return cv::Mat(height, width, CV_8UC1, pixels);
+  case RawPixelFormat::kRgb:
+    cv::cvtColor(cv::Mat(height, width, CV_8UC3, pixels), converted,
+                 cv::COLOR_RGB2BGR);
+    break;
+  case RawPixelFormat::kI420:
+  case RawPixelFormat::kI444:
+    if (monochrome) {
+      // The luma plane comes first and is all monochrome needs.
+      return cv::Mat(height, width, CV_8UC1, pixels);
+    }
+    if (layout.format == RawPixelFormat::kI420) {
+      cv::cvtColor(cv::Mat(height * 3 / 2, width, CV_8UC1, pixels),
+                   converted, cv::COLOR_YUV2BGR_I420);
+    } else {
+      const std::size_t plane = static_cast<std::size_t>(width) * height;
+      const cv::Mat planes[] = {
+          cv::Mat(height, width, CV_8UC1, pixels),
+          cv::Mat(height, width, CV_8UC1, pixels + 2 * plane),
+          cv::Mat(height, width, CV_8UC1, pixels + plane),
+      };
+      thread_local cv::Mat ycrcb;
+      cv::merge(planes, 3, ycrcb);
+      cv::cvtColor(ycrcb, converted, cv::COLOR_YCrCb2BGR);
+    }
+    break;
+  }
+  return converted;
+}
+
+bool MediaToAscii::NeedsConversion(std::uint32_t index) const {
+  if (index % frame_stride_.load() != 0) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock_data(mutex_chars_and_colors_);
+  return index < frame_generations_.size() &&
+         frame_generations_[index] != generation_.load();
+}
+
+bool MediaToAscii::HasStaleFrames() const {
+  const std::uint32_t stride = frame_stride_.load();
+  const std::uint32_t generation = generation_.load();
+  std::lock_guard<std::mutex> lock_data(mutex_chars_and_colors_);
+  for (std::size_t index = 0; index < frame_generations_.size();
+       index += stride) {
+    if (frame_generations_[index] != generation) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::size_t MediaToAscii::GetMemoryUsage() const {
+  std::size_t bytes = 0;
+  {
+    std::lock_guard<std::mutex> lock_data(mutex_chars_and_colors_);
+    bytes += chars_and_colors_.capacity() * sizeof(CharsAndColors) +
+             frame_generations_.capacity() * sizeof(std::uint32_t);
+    for (const auto &frame : chars_and_colors_) {
+      bytes += frame.chars.capacity() +
+               frame.colors.capacity() * sizeof(frame.colors[0]);
+    }
+  }
+  std::lock_guard<std::mutex> lock_capture(mutex_video_capture_);
+  std::lock_guard<std::mutex> lock_frame(mutex_frame_);
+  // frame_ points into the GIF's canvas or cache.
+  if (gif_.IsOpen()) {
+    return bytes + gif_.GetMemoryUsage();
+  }
+  // Raw video frames are either used in place from the mapping or
+  // converted into raw_converted_, which frame_ then shares.
+  const cv::Mat &decoded = raw_video_.IsOpen() ? raw_converted_ : frame_;
+  return bytes + decoded.total() * decoded.elemSize();
 }
 
 void MediaToAscii::CalculateCharsAndColors(std::uint32_t index) {
+  // Read the generation before the size: SetSize() stores the size first,
+  // so a frame is never tagged as current while converted at a stale size.
+  const std::uint32_t generation = generation_.load();
+  const std::uint32_t size = size_.load();
+  const bool monochrome = monochrome_.load();
+  const ZoomView view = GetZoomView();
+
   std::lock_guard<std::mutex> lock_data(mutex_chars_and_colors_);
   std::lock_guard<std::mutex> lock_frame(mutex_frame_);
 
-  if (frame_.empty() || frame_.cols == 0 || frame_.rows == 0) {
+  if (index >= chars_and_colors_.size() || frame_.empty()) {
+    return;
+  }
+  // Convert only the region of interest. The ROI is a view into frame_, so
+  // nothing is copied and the cost does not grow with the zoom.
+  const CropRect crop = ComputeZoomCrop(static_cast<std::uint32_t>(frame_.cols),
+                                        static_cast<std::uint32_t>(frame_.rows),
+                                        view);
+  const cv::Mat roi = frame_(
+      cv::Rect(static_cast<int>(crop.x), static_cast<int>(crop.y),
+               static_cast<int>(crop.width), static_cast<int>(crop.height)));
+  // Stabilize against the frame shown before this one, if it is converted
+  // at the current settings. Frames converted out of order, e.g. after a
+  // seek, start over from their own values.
+  const std::uint32_t stride = frame_stride_.load();
+  const CharsAndColors *previous = nullptr;
+  if (is_video_.load() && index >= stride &&
+      frame_generations_[index - stride] == generation) {
+    previous = &chars_and_colors_[index - stride];
+  }
+  ConvertFrame(roi, size, chars_and_colors_[index], monochrome, previous);
+  frame_generations_[index] = generation;
+}
+
+ImageDimensions MediaToAscii::GetFrameDimensions() const {
+  std::lock_guard<std::mutex> lock_frame(mutex_frame_);
+  return {.width = static_cast<std::uint32_t>(frame_.cols),
+          .height = static_cast<std::uint32_t>(frame_.rows)};
+}
+
+bool MediaToAscii::SetSize(std::uint32_t size) {
+  const std::uint32_t old_size = size_.exchange(size);
+  if (old_size == size) {
+    return false;
+  }
+  // Compare the grids of the converted region, which only depends on the
+  // frame dimensions and the zoom view. Still images are a single
+  // conversion, and a larger size may need a finer decode of them, so they
+  // are always redone.
+  if (!is_video_.load()) {
+    ++generation_;
+    return true;
+  }
+  const ImageDimensions dimensions = GetFrameDimensions();
+  const CropRect crop =
+      ComputeZoomCrop(dimensions.width, dimensions.height, GetZoomView());
+  const ImageDimensions region{.width = crop.width, .height = crop.height};
+  if (region.width > 0 && ComputeGridGeometry(region, old_size) ==
+                              ComputeGridGeometry(region, size)) {
+    return false;
+  }
+  ++generation_;
+  return true;
+}
+
+void MediaToAscii::SetZoomView(const ZoomView &view) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_zoom_view_);
+    if (zoom_view_ == view) {
+      return;
+    }
+    zoom_view_ = view;
+  }
+  // Stored before the bump for the same reason as in SetSize().
+  ++generation_;
+}
+
+ZoomView MediaToAscii::GetZoomView() const {
+  std::lock_guard<std::mutex> lock(mutex_zoom_view_);
+  return zoom_view_;
+}
+
+void MediaToAscii::ConvertFrame(const cv::Mat &frame, std::uint32_t size,
+                                CharsAndColors &target, bool monochrome,
+                                const CharsAndColors *previous) {
+  if (frame.empty() || frame.cols == 0 || frame.rows == 0) {
     return;
   }
 
-  const float aspect_ratio =
-      static_cast<float>(frame_.rows) / static_cast<float>(frame_.cols);
-  const std::uint32_t current_size = size_.load();
-
-  // Scale X for FTXUI's 2x4 character cell geometry.
-  const std::uint32_t block_size_x = std::max(
-      1U, static_cast<std::uint32_t>(frame_.cols) /
-              static_cast<std::uint32_t>(current_size * 2 / aspect_ratio));
-  const std::uint32_t block_size_y =
-      std::max(1U, static_cast<std::uint32_t>(frame_.rows) / current_size);
-
-  const std::uint32_t num_blocks_x =
-      static_cast<std::uint32_t>(frame_.cols) / block_size_x;
-  const std::uint32_t num_blocks_y =
-      static_cast<std::uint32_t>(frame_.rows) / block_size_y;
-
-  auto &target = chars_and_colors_[index];
-  target.chars.assign(num_blocks_x, std::vector<char>(num_blocks_y));
-  target.colors.assign(num_blocks_x,
-                       std::vector<std::array<std::uint8_t, 3>>(
-                           num_blocks_y, std::array<std::uint8_t, 3>()));
-
-  const std::uint32_t pixels_per_block = block_size_x * block_size_y;
-  const auto density_max =
-      static_cast<std::uint32_t>(kAsciiDensity.size() - 1);
-
-  for (std::uint32_t i = 0; i < num_blocks_x; i++) {
-    for (std::uint32_t j = 0; j < num_blocks_y; j++) {
-      std::uint32_t sum_r = 0;
-      std::uint32_t sum_g = 0;
-      std::uint32_t sum_b = 0;
-
-      for (std::uint32_t bi = 0; bi < block_size_x; ++bi) {
-        for (std::uint32_t bj = 0; bj < block_size_y; ++bj) {
-          const cv::Vec3b pixel = frame_.at<cv::Vec3b>(
-              j * block_size_y + bj, i * block_size_x + bi);
-          sum_b += pixel[0];
-          sum_g += pixel[1];
-          sum_r += pixel[2];
-        }
-      }
+  const GridGeometry geometry = ComputeGridGeometry(
+      {.width = static_cast<std::uint32_t>(frame.cols),
+       .height = static_cast<std::uint32_t>(frame.rows)},
+      size);
+  target.columns = geometry.columns;
+  target.rows = geometry.rows;
+  target.chars.resize(static_cast<std::size_t>(geometry.columns) *
+                      geometry.rows);
+
+  const GlyphTable &glyphs = GetGlyphTable();
+  const std::uint8_t threshold = GetStabilizeThreshold();
+  std::optional<TemporalFilter> filter;
+  if (previous != nullptr && threshold > 0 &&
+      previous->columns == geometry.columns &&
+      previous->rows == geometry.rows &&
+      previous->colors.size() == (monochrome ? 0 : target.chars.size())) {
+    filter.emplace(glyphs, *previous, threshold);
+  }
+
+  if (monochrome) {
+    target.colors.clear();
 
-      target.colors[i][j][0] =
-          static_cast<std::uint8_t>(sum_r / pixels_per_block);
-      target.colors[i][j][1] =
-          static_cast<std::uint8_t>(sum_g / pixels_per_block);
-      target.colors[i][j][2] =
-          static_cast<std::uint8_t>(sum_b / pixels_per_block);
+    // One vectorized pass yields a single plane of Rec. 709 luma, so the
+    // kernel reads a third of the bytes and keeps one sum per cell. The
+    // buffer is reused by every conversion on this thread. Frames that
+    // already are a single plane, like the luma of a raw video, are read in
+    // place.
+    thread_local cv::Mat converted;
+    const cv::Mat *plane = &frame;
+    if (frame.channels() != 1) {
+      cv::transform(frame, converted, cv::Matx13f(0.0722f, 0.7152f, 0.2126f));
+      plane = &converted;
+    }
+    if (filter.has_value()) {
+      ConvertCells<false, true>(*plane, geometry, glyphs, &*filter, target);
+    } else {
+      ConvertCells<false, false>(*plane, geometry, glyphs, nullptr, target);
+    }
+    return;
+  }
 
-      const std::uint32_t avg_luminance =
-          (sum_r + sum_g + sum_b) / (3 * pixels_per_block);
+  target.colors.resize(target.chars.size());
 
-      const std::uint32_t density_index =
-          MapValue(avg_luminance, 0U, 255U, 0U, density_max);
+  // A single plane, e.g. a raw luma frame read before switching to color,
+  // is expanded to gray BGR.
+  thread_local cv::Mat expanded;
+  const cv::Mat *bgr = &frame;
+  if (frame.channels() == 1) {
+    cv::cvtColor(frame, expanded, cv::COLOR_GRAY2BGR);
+    bgr = &expanded;
+  }
+  if (filter.has_value()) {
+    ConvertCells<true, true>(*bgr, geometry, glyphs, &*filter, target);
+  } else {
+    ConvertCells<true, false>(*bgr, geometry, glyphs, nullptr, target);
+  }
+}
 
-      target.chars[i][j] = kAsciiDensity[density_index];
+void MediaToAscii::RenderImage() {
+  if (image_dimensions_.has_value()) {
+    const std::uint32_t reduction = ChooseReduction();
+    // Only go back to the file when more detail is needed; a finer decode
+    // is still valid when the size shrinks again.
+    if (reduction < image_reduction_ && !DecodeImage(reduction)) {
+      logger_->error("[MediaToAscii::RenderImage] Could not re-decode image: "
+                     "{}",
+                     image_file_.string());
     }
   }
+  CalculateCharsAndColors(0);
+}
+
+std::uint32_t MediaToAscii::ChooseReduction() const {
+  if (!image_dimensions_.has_value()) {
+    return 1;
+  }
+  const std::uint32_t zoom = ClampZoomView(GetZoomView()).zoom;
+  return ChooseImageReduction({.width = image_dimensions_->width / zoom,
+                               .height = image_dimensions_->height / zoom},
+                              size_.load());
+}
+
+bool MediaToAscii::DecodeImage(std::uint32_t reduction) {
+  cv::Mat decoded = ReadImage(image_file_, reduction);
+  if (decoded.empty()) {
+    return false;
+  }
+
+  logger_->info("[MediaToAscii::DecodeImage] Decoded {} at 1/{} scale: {}x{}",
+                image_file_.string(), reduction, decoded.cols, decoded.rows);
+
+  std::lock_guard<std::mutex> lock_frame(mutex_frame_);
+  frame_ = std::move(decoded);
+  image_reduction_ = reduction;
+  return true;
+}
+
+cv::Mat MediaToAscii::ReadImage(const std::filesystem::path &file,
+                                std::uint32_t reduction) {
+  int flags = cv::IMREAD_COLOR;
+  switch (reduction) {
+  case 2:
+    flags = cv::IMREAD_REDUCED_COLOR_2;
+    break;
+  case 4:
+    flags = cv::IMREAD_REDUCED_COLOR_4;
+    break;
+  case 8:
+    flags = cv::IMREAD_REDUCED_COLOR_8;
+    break;
+  default:
+    break;
+  }
+
+  // JPEG decodes at the reduced scale directly (libjpeg DCT scaling), other
+  // formats are resized right after decoding.
+  return cv::imread(file.string(), flags);
 }
 
 MediaToAscii::CharsAndColors
 MediaToAscii::GetCharsAndColors(std::uint32_t index) const {
+  CharsAndColors target;
+  GetCharsAndColors(index, target);
+  return target;
+}
+
+bool MediaToAscii::GetCharsAndColors(std::uint32_t index,
+                                     CharsAndColors &target) const {
   std::lock_guard<std::mutex> lock_data(mutex_chars_and_colors_);
-  if (IsVideo()) {
-    if (GetCurrentFrameIndex() < 1) {
-      return CharsAndColors{};
+  // The frame vector is resized when a new file is opened, so the index may
+  // briefly refer to the previous file's frame count.
+  if (index < chars_and_colors_.size()) {
+    // Playback can run ahead of the decoder, and fast playback skips frames.
+    for (std::uint32_t i = index + 1; i-- > 0;) {
+      if (frame_generations_[i] == 0) {
+        continue;
+      }
+      const CharsAndColors &source = chars_and_colors_[i];
+      target.columns = source.columns;
+      target.rows = source.rows;
+      // assign() keeps the existing capacity.
+      target.chars.assign(source.chars.begin(), source.chars.end());
+      target.colors.assign(source.colors.begin(), source.colors.end());
+      return true;
     }
-    return chars_and_colors_[std::min(GetCurrentFrameIndex() - 1, index)];
   }
-  return chars_and_colors_[index];
+  target.columns = 0;
+  target.rows = 0;
+  target.chars.clear();
+  target.colors.clear();
+  return false;
 }
 
 } // namespace terminal_animation
\ No newline at end of file
@@ -1,99 +1,288 @@
 #pragma once
 
 // local
+#include "chars_and_colors.hpp"
 #include "common.hpp"
+#include "gif_decoder.hpp"
+#include "image_sequence.hpp"
+#include "logger.hpp"
+#include "raw_video_reader.hpp"
+#include "task_scheduler.hpp"
 
 // lib
 // OpenCV
 #include <opencv2/opencv.hpp>
-// spdlog
-#include "spdlog/async.h"
-#include "spdlog/sinks/basic_file_sink.h"
 
 // std
 #include <array>
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <filesystem>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <vector>
 
 namespace terminal_animation {
 
 class MediaToAscii {
 public:
-  // Per-character RGB color and ASCII character for one frame of output.
-  struct CharsAndColors {
-    std::vector<std::vector<std::array<std::uint8_t, 3>>> colors;
-    std::vector<std::vector<char>> chars;
-  };
+  // Kept as a nested name for the many callers that spell it this way.
+  using CharsAndColors = terminal_animation::CharsAndColors;
 
   MediaToAscii() = default;
 
   explicit MediaToAscii(const std::filesystem::path &file) { OpenFile(file); }
 
-  ~MediaToAscii() { video_capture_.release(); }
+  ~MediaToAscii();
 
   MediaToAscii(const MediaToAscii &) = delete;
   MediaToAscii &operator=(const MediaToAscii &) = delete;
 
-  // Opens a media file (image or video/GIF).
-  void OpenFile(const std::filesystem::path &file);
+  // Opens a media file (image, video/GIF or raw video) and converts its
+  // first frame so it can be shown before the rest of the video is decoded.
+  // Raw video is read from a memory mapping instead of through
+  // cv::VideoCapture; see RawVideoReader. GIFs are decoded by GifDecoder,
+  // falling back to cv::VideoCapture if it rejects the file. A directory or
+  // a pattern such as frame_%05d.png is played as an image sequence; see
+  // FindImageSequence().
+  // Returns false if the file could not be opened.
+  bool OpenFile(const std::filesystem::path &file);
 
-  // Decodes every frame of the loaded video into chars_and_colors_.
+  // Converts every frame of the loaded video that still needs it, starting
+  // at the current capture position and wrapping around to the frames
+  // before it.
   void RenderVideo();
 
+  // RenderVideo() split into chunks, so a task can yield between them:
+  // BeginVideoPass() starts a pass at the current capture position, and each
+  // RenderVideoChunk() call advances it by at most max_frames frames.
+  // RenderVideoChunk() returns false once the pass is done or rendering was
+  // stopped. Only one thread may run a pass at a time.
+  void BeginVideoPass();
+  bool RenderVideoChunk(std::uint32_t max_frames);
+
+  // Advances the capture by at most max_frames frames from its current
+  // position. Frames that are skipped by the frame stride or are already
+  // converted at the current size are only grabbed, not retrieved.
+  // Returns the number of frames the capture advanced.
+  std::uint32_t RenderVideoFrames(std::uint32_t max_frames);
+
   // Converts a single frame at the given index to ASCII.
   void CalculateCharsAndColors(std::uint32_t index);
 
+  // Decodes an image at 1/reduction scale (1, 2, 4 or 8) using the
+  // cv::IMREAD_REDUCED_COLOR_* flags. Returns an empty Mat on failure.
+  static cv::Mat ReadImage(const std::filesystem::path &file,
+                           std::uint32_t reduction);
+
+  // Returns the frame at index of reader in a form ConvertFrame() takes, or
+  // an empty Mat if there is none. Packed BGR frames, and the luma plane of
+  // YUV frames in monochrome, point into reader's mapping; other frames are
+  // converted into converted, which the result shares.
+  static cv::Mat DecodeRawFrame(const RawVideoReader &reader,
+                                std::uint32_t index, bool monochrome,
+                                cv::Mat &converted);
+
+  // Converts a BGR or single-plane grayscale frame to ASCII at the given
+  // size (number of rows), drawing glyphs from GetGlyphTable(). In
+  // monochrome a BGR frame is converted to a single luma plane first and
+  // only characters are stored; target.colors is left empty.
+  // If previous is the frame shown before this one, converted at the same
+  // grid and color mode, cells are held from it as a TemporalFilter with
+  // GetStabilizeThreshold() allows. previous must not be target.
+  // Leaves target untouched if the frame is empty.
+  static void ConvertFrame(const cv::Mat &frame, std::uint32_t size,
+                           CharsAndColors &target, bool monochrome = false,
+                           const CharsAndColors *previous = nullptr);
+
+  // Converts the loaded still image. Re-decodes it at a finer reduction
+  // first if the current size needs more pixels than the last decode kept.
+  void RenderImage();
+
   // Returns the pre-rendered frame data at the given index.
-  // For video, returns the latest available frame if index is not yet decoded.
+  // For video, returns the closest earlier converted frame if index is not
+  // converted yet.
   CharsAndColors GetCharsAndColors(std::uint32_t index) const;
 
-  std::uint32_t GetFramerate() const {
-    return std::max(
-        1U, static_cast<std::uint32_t>(video_capture_.get(cv::CAP_PROP_FPS)));
-  }
+  // Like above, but copies into target, reusing its buffers. Does not
+  // allocate once target has held a frame of the same size. Leaves target
+  // empty and returns false if no frame is converted yet.
+  bool GetCharsAndColors(std::uint32_t index, CharsAndColors &target) const;
 
-  std::uint32_t GetCurrentFrameIndex() const {
-    return static_cast<std::uint32_t>(
-        video_capture_.get(cv::CAP_PROP_POS_FRAMES));
+  // Frame rate image sequences play at; they carry none themselves.
+  void SetSequenceFramerate(std::uint32_t fps) {
+    sequence_fps_.store(std::max(1U, fps));
   }
 
-  std::uint32_t GetTotalFrameCount() const {
-    return static_cast<std::uint32_t>(
-        video_capture_.get(cv::CAP_PROP_FRAME_COUNT));
-  }
+  // For media with per-frame timing (GIFs) this is the average rate.
+  std::uint32_t GetFramerate() const;
+
+  // Returns how long the frame at index is shown at normal speed: its own
+  // delay for GIFs, one frame interval for everything else.
+  std::chrono::milliseconds GetFrameDuration(std::uint32_t index) const;
+
+  std::uint32_t GetCurrentFrameIndex() const;
+  std::uint32_t GetTotalFrameCount() const;
+
+  // Returns true if a frame shown at the current frame stride is not
+  // converted at the current size, color mode and zoom yet.
+  bool HasStaleFrames() const;
+
+  // Returns the bytes held by converted frames and decoded frames. Video
+  // decoder state and memory-mapped raw video are not counted.
+  std::size_t GetMemoryUsage() const;
 
   bool IsVideo() const { return is_video_.load(); }
 
-  void SetSize(std::uint32_t size) { size_.store(size); }
+  // Dimensions of the last decoded frame, or 0x0 before the first one.
+  ImageDimensions GetFrameDimensions() const;
+
+  // Changing the size marks every converted frame as stale, unless the
+  // video's grid (see ComputeGridGeometry()) stays the same, so the
+  // conversions can be reused. Stale frames are still returned until
+  // RenderVideo() replaces them. Returns true if frames became stale.
+  bool SetSize(std::uint32_t size);
   std::uint32_t GetSize() const { return size_.load(); }
 
+  // Converts frames to characters only, skipping color. Like SetSize(), a
+  // change marks every converted frame as stale.
+  void SetMonochrome(bool monochrome) {
+    if (monochrome_.exchange(monochrome) != monochrome) {
+      ++generation_;
+    }
+  }
+  bool IsMonochrome() const { return monochrome_.load(); }
+
   void SetContinueRendering(bool should_render) {
     should_render_.store(should_render);
   }
 
-  void SetCurrentFrameIndex(std::uint32_t index) {
-    video_capture_.set(cv::CAP_PROP_POS_FRAMES, index);
+  // Seeks the video. Raw video seeks in constant time.
+  void SetCurrentFrameIndex(std::uint32_t index);
+
+  // Selects the region of interest that is converted. Like SetSize(), a
+  // change marks every converted frame as stale.
+  void SetZoomView(const ZoomView &view);
+  ZoomView GetZoomView() const;
+
+  // Only every stride-th frame (index % stride == 0) is converted by
+  // RenderVideo(); the others are never shown during fast playback.
+  void SetFrameStride(std::uint32_t stride) {
+    frame_stride_.store(std::max(1U, stride));
   }
+  std::uint32_t GetFrameStride() const { return frame_stride_.load(); }
 
 private:
+  // Returns true if the frame at index is shown at the current frame stride
+  // and is not converted at the current size yet.
+  bool NeedsConversion(std::uint32_t index) const;
+
+  // Returns the decode reduction for the still image at the current size and
+  // zoom. Zooming in leaves fewer source pixels per cell, so it needs a
+  // finer decode.
+  std::uint32_t ChooseReduction() const;
+
+  // Decodes the frame at the capture position into frame_ and advances the
+  // position. Returns false at the end of the video.
+  bool ReadNextFrame();
+
+  // Advances the capture position without converting the frame to BGR.
+  // Returns false at the end of the video.
+  bool SkipFrame();
+
+  // Points frame_ at the raw video frame at index, see DecodeRawFrame().
+  // Converted frames go to raw_converted_. Requires mutex_frame_.
+  bool ReadRawFrame(std::uint32_t index);
+
+  bool IsImageSequence() const { return !sequence_files_.empty(); }
+
+  // Queues decodes of the sequence frames from index on that still need
+  // converting, at most kSequenceReadAhead frames ahead. Requires
+  // mutex_video_capture_.
+  void QueueSequenceDecodes(std::uint32_t index);
+
+  // Returns the decoded sequence frame at index, waiting for its queued
+  // decode or decoding it on the calling thread if none is usable. Requires
+  // mutex_video_capture_.
+  cv::Mat TakeSequenceFrame(std::uint32_t index);
+
+  // Cancels queued decodes and forgets the sequence. Requires
+  // mutex_video_capture_.
+  void CloseImageSequence();
+
+  // Decodes image_file_ into frame_ at the given reduction factor.
+  // Returns false if the image could not be decoded.
+  bool DecodeImage(std::uint32_t reduction);
+
   std::atomic<bool> is_video_{false};
   std::atomic<bool> should_render_{false};
   std::atomic<std::uint32_t> size_{1};
+  std::atomic<bool> monochrome_{false};
+  std::atomic<std::uint32_t> frame_stride_{1};
+  // Bumped whenever the size, color mode or zoom view changes; 0 marks a
+  // frame as never converted.
+  std::atomic<std::uint32_t> generation_{1};
+
+  // Position the current pass started at, and whether it has wrapped around
+  // to the frames before it.
+  std::uint32_t pass_start_ = 0;
+  bool pass_wrapped_ = false;
 
   cv::VideoCapture video_capture_;
+  // Used instead of video_capture_ for raw video files. raw_position_ is
+  // the index of the next frame to read.
+  RawVideoReader raw_video_;
+  std::atomic<std::uint32_t> raw_position_{0};
+  // May point into raw_video_'s read-only mapping. Raw reads replace the
+  // header instead of writing to it, and OpenFile() releases it before
+  // anything else decodes into it.
   cv::Mat frame_;
+  cv::Mat raw_converted_;
+
+  // Used instead of video_capture_ for GIFs it can decode. gif_position_
+  // is the index of the next frame to read. Its frames are used in place
+  // by frame_, like raw video frames.
+  GifDecoder gif_;
+  std::atomic<std::uint32_t> gif_position_{0};
+
+  // Image sequence state, used instead of video_capture_ when
+  // sequence_files_ is not empty. Frames are decoded ahead of
+  // sequence_position_, the index of the next frame to read, in parallel on
+  // sequence_decoder_: unlike the frames of a video stream, every file
+  // decodes on its own. The decoder has its own workers because the
+  // rendering task that waits for the decodes may run on the shared ones.
+  struct SequenceDecode {
+    TaskHandle task;
+    std::uint32_t reduction = 1;
+    cv::Mat image;
+  };
+  static constexpr std::uint32_t kSequenceReadAhead = 8;
+  std::vector<std::filesystem::path> sequence_files_;
+  std::atomic<std::uint32_t> sequence_position_{0};
+  std::atomic<std::uint32_t> sequence_fps_{kDefaultSequenceFramerate};
+  std::map<std::uint32_t, std::shared_ptr<SequenceDecode>> sequence_decodes_;
+  std::unique_ptr<TaskScheduler> sequence_decoder_;
+
+  // Still image and image sequence decode state, used to pick
+  // IMREAD_REDUCED_* flags.
+  std::filesystem::path image_file_;
+  std::optional<ImageDimensions> image_dimensions_;
+  std::uint32_t image_reduction_ = 1;
   std::vector<CharsAndColors> chars_and_colors_{{}};
+  // Generation each entry of chars_and_colors_ was converted at.
+  std::vector<std::uint32_t> frame_generations_{0};
+
+  ZoomView zoom_view_;
+  mutable std::mutex mutex_zoom_view_;
 
   mutable std::mutex mutex_chars_and_colors_;
-  std::mutex mutex_video_capture_;
-  std::mutex mutex_frame_;
+  mutable std::mutex mutex_video_capture_;
+  mutable std::mutex mutex_frame_;
 
-  std::shared_ptr<spdlog::logger> logger_ =
-      spdlog::basic_logger_mt<spdlog::async_factory>("MediaToAscii",
-                                                      "logs/debug.txt");
+  std::shared_ptr<spdlog::logger> logger_ = GetLogger("MediaToAscii");
 };
 
 } // namespace terminal_animation
\ No newline at end of file
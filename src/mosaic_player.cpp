@@ -0,0 +1,138 @@
+// header
+#include "mosaic_player.hpp"
+
+// std
+#include <algorithm>
+#include <utility>
+
+namespace terminal_animation {
+
+MosaicPlayer::MosaicPlayer(FrameScheduler &scheduler,
+                           std::function<void()> on_update)
+    : scheduler_(scheduler), on_update_(std::move(on_update)) {}
+
+MosaicPlayer::~MosaicPlayer() { Clear(); }
+
+bool MosaicPlayer::Add(const std::filesystem::path &file) {
+  if (panes_.size() >= kMaxPanes) {
+    return false;
+  }
+
+  auto pane = std::make_unique<Pane>();
+  pane->file = file;
+  pane->media->SetMonochrome(monochrome_);
+  Pane *raw_pane = pane.get();
+  pane->client = scheduler_.Add([this, raw_pane] { return Step(*raw_pane); });
+  panes_.push_back(std::move(pane));
+  logger_->info("[MosaicPlayer::Add] Added pane {}: {}", panes_.size(),
+                file.string());
+  return true;
+}
+
+void MosaicPlayer::Clear() {
+  for (const auto &pane : panes_) {
+    pane->media->SetContinueRendering(false);
+    scheduler_.Remove(pane->client);
+  }
+  panes_.clear();
+}
+
+std::uint32_t MosaicPlayer::GetMaxFramerate() const {
+  std::uint32_t fps = 0;
+  for (const auto &pane : panes_) {
+    if (pane->is_open.load() && pane->media->IsVideo()) {
+      fps = std::max(fps, pane->fps);
+    }
+  }
+  return fps;
+}
+
+void MosaicPlayer::Relayout(std::uint32_t cell_columns,
+                            std::uint32_t cell_rows) {
+  for (const auto &pane : panes_) {
+    // Until the file is open its aspect ratio is unknown; OpenFile() then
+    // uses the height of the cell and the next relayout corrects it.
+    const ImageDimensions dimensions =
+        pane->is_open.load() ? pane->dimensions : ImageDimensions{};
+    const std::uint32_t size = FitPaneSize(cell_columns, cell_rows, dimensions);
+    // Sizes that round to the same grid keep the converted frames.
+    if (!pane->media->SetSize(size)) {
+      continue;
+    }
+    pane->needs_restart.store(true);
+    scheduler_.Wake(pane->client);
+  }
+}
+
+void MosaicPlayer::SetMonochrome(bool monochrome) {
+  monochrome_ = monochrome;
+  for (const auto &pane : panes_) {
+    if (pane->media->IsMonochrome() == monochrome) {
+      continue;
+    }
+    pane->media->SetMonochrome(monochrome);
+    pane->needs_restart.store(true);
+    scheduler_.Wake(pane->client);
+  }
+}
+
+std::vector<MosaicPlayer::PaneFrame> MosaicPlayer::GetFrames() const {
+  const auto now = std::chrono::steady_clock::now();
+  std::vector<PaneFrame> frames;
+  frames.reserve(panes_.size());
+  for (const auto &pane : panes_) {
+    PaneFrame &frame = frames.emplace_back();
+    frame.file = pane->file;
+    frame.failed = pane->failed.load();
+    if (!pane->is_open.load()) {
+      continue;
+    }
+
+    std::uint32_t index = 0;
+    const std::uint32_t total = pane->media->GetTotalFrameCount();
+    if (pane->media->IsVideo() && total > 0) {
+      // Every pane follows its own wall clock, so a pane whose decoder falls
+      // behind repeats its latest frame instead of slowing the others.
+      const auto elapsed =
+          std::chrono::duration_cast<std::chrono::milliseconds>(now -
+                                                                pane->start);
+      index = static_cast<std::uint32_t>(
+          (static_cast<std::uint64_t>(elapsed.count()) * pane->fps / 1000) %
+          total);
+    }
+    frame.frame = pane->media->GetCharsAndColors(index);
+  }
+  return frames;
+}
+
+bool MosaicPlayer::Step(Pane &pane) {
+  auto &media = *pane.media;
+  if (!pane.is_open.load()) {
+    pane.needs_restart.store(false);
+    if (!media.OpenFile(pane.file)) {
+      pane.failed.store(true);
+      on_update_();
+      return false;
+    }
+    pane.dimensions = media.GetFrameDimensions();
+    pane.fps = media.GetFramerate();
+    pane.start = std::chrono::steady_clock::now();
+    pane.is_open.store(true);
+    on_update_();
+    // The size may have changed while the file was being opened.
+    return media.IsVideo() || pane.needs_restart.load();
+  }
+
+  if (pane.needs_restart.exchange(false)) {
+    if (!media.IsVideo()) {
+      media.RenderImage();
+      return false;
+    }
+    media.SetCurrentFrameIndex(0);
+  }
+
+  return media.RenderVideoFrames(1) == 1 &&
+         media.GetCurrentFrameIndex() < media.GetTotalFrameCount();
+}
+
+} // namespace terminal_animation
@@ -0,0 +1,97 @@
+#pragma once
+
+// local
+#include "common.hpp"
+#include "frame_scheduler.hpp"
+#include "logger.hpp"
+#include "media_to_ascii.hpp"
+
+// std
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace terminal_animation {
+
+// Plays several media files side by side in a grid. Opening, decoding and
+// conversion of every pane run as FrameScheduler clients, so the panes share
+// the scheduler's workers fairly. When the workers cannot keep up, each pane
+// keeps its wall-clock position and shows its latest converted frame, so the
+// frame rate drops evenly instead of some panes freezing.
+class MosaicPlayer {
+public:
+  static constexpr std::size_t kMaxPanes = 16;
+
+  // What one pane shows right now.
+  struct PaneFrame {
+    std::filesystem::path file;
+    // Empty while the file is being opened or if it failed to open.
+    std::optional<MediaToAscii::CharsAndColors> frame;
+    bool failed = false;
+  };
+
+  // on_update is called from scheduler workers when a pane finished opening.
+  MosaicPlayer(FrameScheduler &scheduler, std::function<void()> on_update);
+  ~MosaicPlayer();
+
+  MosaicPlayer(const MosaicPlayer &) = delete;
+  MosaicPlayer &operator=(const MosaicPlayer &) = delete;
+
+  // Adds a pane playing file. Returns false if the mosaic is full.
+  bool Add(const std::filesystem::path &file);
+
+  // Removes every pane.
+  void Clear();
+
+  std::size_t Size() const { return panes_.size(); }
+  bool Empty() const { return panes_.empty(); }
+
+  // Highest frame rate of the open panes, or 0 if none plays a video.
+  std::uint32_t GetMaxFramerate() const;
+
+  // Sizes every pane to fit a cell of cell_columns x cell_rows characters.
+  // Panes whose size changes are reconverted on the scheduler.
+  void Relayout(std::uint32_t cell_columns, std::uint32_t cell_rows);
+
+  // Switches every pane, and panes added later, between color and
+  // monochrome conversion. Changed panes are reconverted on the scheduler.
+  void SetMonochrome(bool monochrome);
+
+  // Returns the frame every pane shows at the current time, in pane order.
+  std::vector<PaneFrame> GetFrames() const;
+
+private:
+  struct Pane {
+    std::filesystem::path file;
+    std::shared_ptr<MediaToAscii> media = std::make_shared<MediaToAscii>();
+    FrameScheduler::ClientId client = 0;
+    std::atomic<bool> is_open{false};
+    std::atomic<bool> failed{false};
+    // Set when the size or color mode changed; the next step restarts
+    // conversion.
+    std::atomic<bool> needs_restart{false};
+    // Written once before is_open is set.
+    ImageDimensions dimensions;
+    std::uint32_t fps = 1;
+    std::chrono::steady_clock::time_point start;
+  };
+
+  // One scheduler step of a pane: opens the file first, then converts one
+  // frame per step until the whole video is converted.
+  bool Step(Pane &pane);
+
+  FrameScheduler &scheduler_;
+  std::function<void()> on_update_;
+  // Only touched by the UI thread; the scheduler only sees single panes.
+  std::vector<std::unique_ptr<Pane>> panes_;
+  bool monochrome_ = false;
+
+  std::shared_ptr<spdlog::logger> logger_ = GetLogger("MosaicPlayer");
+};
+
+} // namespace terminal_animation
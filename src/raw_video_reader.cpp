@@ -0,0 +1,294 @@
+// header
+#include "raw_video_reader.hpp"
+
+// std
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <string>
+#include <utility>
+
+#if defined(__linux__) || defined(__APPLE__)
+#define TERMINAL_ANIMATION_POSIX 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace terminal_animation {
+
+namespace {
+
+constexpr std::string_view kY4mMagic = "YUV4MPEG2";
+constexpr std::string_view kY4mFrameMagic = "FRAME";
+// Longer header lines are treated as garbage rather than searched to the
+// end of a large file.
+constexpr std::size_t kMaxY4mLineLength = 4096;
+
+// Parses the whole of text as a positive number.
+std::optional<std::uint32_t> ParseNumber(std::string_view text) {
+  std::uint32_t value = 0;
+  const auto [end, error] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  if (error != std::errc() || end != text.data() + text.size() ||
+      value == 0) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+std::optional<RawPixelFormat> ParseY4mColorSpace(std::string_view name) {
+  // The 8-bit 4:2:0 variants differ only in chroma siting, not in memory
+  // layout. Deeper ones such as 420p10 store 16-bit samples.
+  if (name == "420" || name == "420jpeg" || name == "420paldv" ||
+      name == "420mpeg2") {
+    return RawPixelFormat::kI420;
+  }
+  if (name == "444") {
+    return RawPixelFormat::kI444;
+  }
+  if (name == "mono") {
+    return RawPixelFormat::kGray;
+  }
+  return std::nullopt;
+}
+
+// Returns the line starting at offset without its '\n', or nullopt if it
+// does not end within kMaxY4mLineLength bytes.
+std::optional<std::string_view> ReadLine(std::string_view data,
+                                         std::size_t offset) {
+  const std::string_view line =
+      data.substr(offset, kMaxY4mLineLength + 1);
+  const std::size_t end = line.find('\n');
+  if (end == std::string_view::npos) {
+    return std::nullopt;
+  }
+  return line.substr(0, end);
+}
+
+} // namespace
+
+std::uint64_t GetRawFrameSize(RawPixelFormat format, std::uint32_t width,
+                              std::uint32_t height) {
+  const std::uint64_t pixels = static_cast<std::uint64_t>(width) * height;
+  switch (format) {
+  case RawPixelFormat::kI420:
+    return pixels + 2 * (static_cast<std::uint64_t>((width + 1) / 2) *
+                         ((height + 1) / 2));
+  case RawPixelFormat::kI444:
+  case RawPixelFormat::kBgr:
+  case RawPixelFormat::kRgb:
+    return 3 * pixels;
+  case RawPixelFormat::kGray:
+    return pixels;
+  }
+  return 0;
+}
+
+std::optional<RawVideoLayout> ParseY4m(std::string_view data) {
+  const auto header = ReadLine(data, 0);
+  if (!header.has_value() || !header->starts_with(kY4mMagic)) {
+    return std::nullopt;
+  }
+
+  RawVideoLayout layout;
+  std::string_view color_space = "420jpeg";
+  std::size_t position = kY4mMagic.size();
+  while (position < header->size()) {
+    if ((*header)[position] != ' ') {
+      return std::nullopt;
+    }
+    const std::size_t start = position + 1;
+    position = std::min(header->find(' ', start), header->size());
+    const std::string_view token = header->substr(start, position - start);
+    if (token.empty()) {
+      continue;
+    }
+    const std::string_view value = token.substr(1);
+    switch (token.front()) {
+    case 'W':
+    case 'H': {
+      const auto number = ParseNumber(value);
+      if (!number.has_value()) {
+        return std::nullopt;
+      }
+      (token.front() == 'W' ? layout.width : layout.height) = *number;
+      break;
+    }
+    case 'F': {
+      const std::size_t colon = value.find(':');
+      const auto numerator = ParseNumber(value.substr(0, colon));
+      const auto denominator =
+          colon == std::string_view::npos
+              ? std::nullopt
+              : ParseNumber(value.substr(colon + 1));
+      if (numerator.has_value() && denominator.has_value()) {
+        layout.fps_numerator = *numerator;
+        layout.fps_denominator = *denominator;
+      }
+      break;
+    }
+    case 'C':
+      color_space = value;
+      break;
+    default:
+      // Interlacing, pixel aspect and X extensions do not change the
+      // layout.
+      break;
+    }
+  }
+
+  const auto format = ParseY4mColorSpace(color_space);
+  if (layout.width == 0 || layout.height == 0 || !format.has_value()) {
+    return std::nullopt;
+  }
+  layout.format = *format;
+  // OpenCV's I420 conversion needs even dimensions.
+  if (layout.format == RawPixelFormat::kI420 &&
+      (layout.width % 2 != 0 || layout.height % 2 != 0)) {
+    return std::nullopt;
+  }
+
+  // Frame headers may carry parameters, so their length varies. Walking
+  // them once touches one page per frame and makes every later lookup O(1).
+  const std::uint64_t frame_size =
+      GetRawFrameSize(layout.format, layout.width, layout.height);
+  std::size_t offset = header->size() + 1;
+  while (offset < data.size()) {
+    const auto frame_header = ReadLine(data, offset);
+    if (!frame_header.has_value() ||
+        !frame_header->starts_with(kY4mFrameMagic)) {
+      break;
+    }
+    const std::uint64_t pixels = offset + frame_header->size() + 1;
+    if (data.size() - pixels < frame_size) {
+      break;
+    }
+    layout.frame_offsets.push_back(pixels);
+    offset = static_cast<std::size_t>(pixels + frame_size);
+  }
+  return layout;
+}
+
+std::optional<RawVideoLayout>
+ParseRawVideoName(const std::filesystem::path &path, std::uint64_t file_size) {
+  std::string extension = path.extension().string();
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+
+  RawVideoLayout layout;
+  if (extension == ".yuv") {
+    layout.format = RawPixelFormat::kI420;
+  } else if (extension == ".gray") {
+    layout.format = RawPixelFormat::kGray;
+  } else if (extension == ".bgr") {
+    layout.format = RawPixelFormat::kBgr;
+  } else if (extension == ".rgb") {
+    layout.format = RawPixelFormat::kRgb;
+  } else {
+    return std::nullopt;
+  }
+
+  // Look for WxH and Nfps among the parts of the name.
+  const std::string stem = path.stem().string();
+  std::size_t start = 0;
+  while (start <= stem.size()) {
+    const std::size_t end =
+        std::min(stem.find_first_of("_-. ", start), stem.size());
+    const std::string_view part =
+        std::string_view(stem).substr(start, end - start);
+    start = end + 1;
+
+    const std::size_t times = part.find('x');
+    if (times != std::string_view::npos) {
+      const auto width = ParseNumber(part.substr(0, times));
+      const auto height = ParseNumber(part.substr(times + 1));
+      if (width.has_value() && height.has_value()) {
+        layout.width = *width;
+        layout.height = *height;
+      }
+    } else if (part.ends_with("fps")) {
+      if (const auto fps = ParseNumber(part.substr(0, part.size() - 3))) {
+        layout.fps_numerator = *fps;
+      }
+    }
+  }
+
+  if (layout.width == 0 || layout.height == 0 ||
+      (layout.format == RawPixelFormat::kI420 &&
+       (layout.width % 2 != 0 || layout.height % 2 != 0))) {
+    return std::nullopt;
+  }
+  const std::uint64_t frame_size =
+      GetRawFrameSize(layout.format, layout.width, layout.height);
+  // A partial frame at the end is ignored like a truncated Y4M frame.
+  for (std::uint64_t offset = 0; offset + frame_size <= file_size;
+       offset += frame_size) {
+    layout.frame_offsets.push_back(offset);
+  }
+  return layout;
+}
+
+bool RawVideoReader::Open([[maybe_unused]] const std::filesystem::path &file) {
+  Close();
+#ifdef TERMINAL_ANIMATION_POSIX
+  const int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat status {};
+  if (fstat(fd, &status) != 0 || status.st_size <= 0) {
+    close(fd);
+    return false;
+  }
+  const auto size = static_cast<std::size_t>(status.st_size);
+  void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps its own reference to the file.
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+  // Playback reads frames in order, so let the kernel read ahead.
+  posix_madvise(mapping, size, POSIX_MADV_SEQUENTIAL);
+  data_ = static_cast<const std::uint8_t *>(mapping);
+  size_ = size;
+
+  std::string extension = file.extension().string();
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  auto layout =
+      extension == ".y4m"
+          ? ParseY4m(std::string_view(reinterpret_cast<const char *>(data_),
+                                      size_))
+          : ParseRawVideoName(file, size_);
+  if (!layout.has_value() || layout->frame_offsets.empty()) {
+    Close();
+    return false;
+  }
+  layout_ = std::move(*layout);
+  return true;
+#else
+  return false;
+#endif
+}
+
+void RawVideoReader::Close() {
+#ifdef TERMINAL_ANIMATION_POSIX
+  if (data_ != nullptr) {
+    munmap(const_cast<std::uint8_t *>(data_), size_);
+  }
+#endif
+  data_ = nullptr;
+  size_ = 0;
+  layout_ = {};
+}
+
+const std::uint8_t *RawVideoReader::GetFrame(std::uint32_t index) const {
+  if (data_ == nullptr || index >= layout_.frame_offsets.size()) {
+    return nullptr;
+  }
+  return data_ + layout_.frame_offsets[index];
+}
+
+} // namespace terminal_animation
@@ -0,0 +1,92 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace terminal_animation {
+
+// Pixel layouts of uncompressed video that RawVideoReader understands.
+enum class RawPixelFormat : std::uint8_t {
+  // Planar Y, then U and V at half width and height.
+  kI420,
+  // Planar Y, U and V at full resolution.
+  kI444,
+  // A single luma plane.
+  kGray,
+  // Packed 8-bit B, G, R.
+  kBgr,
+  // Packed 8-bit R, G, B.
+  kRgb,
+};
+
+// Returns the number of bytes one width x height frame takes.
+std::uint64_t GetRawFrameSize(RawPixelFormat format, std::uint32_t width,
+                              std::uint32_t height);
+
+// Where the frames of an uncompressed video file are and how to read them.
+struct RawVideoLayout {
+  std::uint32_t width = 0;
+  std::uint32_t height = 0;
+  std::uint32_t fps_numerator = 30;
+  std::uint32_t fps_denominator = 1;
+  RawPixelFormat format = RawPixelFormat::kI420;
+  // Offset of every frame's pixel data in the file.
+  std::vector<std::uint64_t> frame_offsets;
+};
+
+// Parses a YUV4MPEG2 stream and finds the pixel data of every complete
+// frame. Supports the 4:2:0 color spaces with even dimensions, 4:4:4 and
+// mono. Returns nullopt if the header is malformed or the color space is
+// not supported. A truncated last frame is ignored.
+std::optional<RawVideoLayout> ParseY4m(std::string_view data);
+
+// Derives the layout of a headerless file from its name and size, e.g.
+// clip_640x360.yuv or clip_640x360_25fps.bgr. The extension gives the pixel
+// format: .yuv is I420, then .gray, .bgr and .rgb. Without an fps in the
+// name, 30 is assumed. Returns nullopt if the name has no dimensions.
+std::optional<RawVideoLayout>
+ParseRawVideoName(const std::filesystem::path &path, std::uint64_t file_size);
+
+// Reads uncompressed video without a decoder. The file is memory-mapped
+// and frames are returned as pointers into the mapping, so nothing is
+// copied and any frame is found in constant time. Only available on POSIX
+// systems.
+class RawVideoReader {
+public:
+  RawVideoReader() = default;
+  ~RawVideoReader() { Close(); }
+
+  RawVideoReader(const RawVideoReader &) = delete;
+  RawVideoReader &operator=(const RawVideoReader &) = delete;
+
+  // Maps a .y4m file or a headerless file named as ParseRawVideoName()
+  // expects. Returns false if the file cannot be mapped or parsed.
+  bool Open(const std::filesystem::path &file);
+
+  // Unmaps the file. Pointers returned by GetFrame() become invalid.
+  void Close();
+
+  bool IsOpen() const { return data_ != nullptr; }
+
+  const RawVideoLayout &GetLayout() const { return layout_; }
+
+  std::uint32_t GetFrameCount() const {
+    return static_cast<std::uint32_t>(layout_.frame_offsets.size());
+  }
+
+  // Returns the pixel data of the frame at index, or nullptr if there is no
+  // such frame. The data is read-only and stays valid until Close().
+  const std::uint8_t *GetFrame(std::uint32_t index) const;
+
+private:
+  const std::uint8_t *data_ = nullptr;
+  std::size_t size_ = 0;
+  RawVideoLayout layout_;
+};
+
+} // namespace terminal_animation
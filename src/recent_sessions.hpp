@@ -0,0 +1,85 @@
+#pragma once
+
+// local
+#include "lru_cache.hpp"
+
+// std
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace terminal_animation {
+
+// Sessions of recently shown files, parked so that switching back to a file
+// can resume it instead of opening it again. Bounded by a memory budget:
+// each session costs its memory, but at least budget / max_sessions, so at
+// most max_sessions are kept however small they are. A session is only
+// handed back while its file is unmodified. Not thread-safe: callers lock.
+template <typename Session> class RecentSessions {
+public:
+  RecentSessions(std::size_t budget, std::size_t max_sessions)
+      : min_cost_(budget / std::max<std::size_t>(max_sessions, 1)),
+        sessions_(budget) {}
+
+  // Returns what parking a session holding memory bytes costs.
+  std::size_t Cost(std::size_t memory) const {
+    return std::max(memory, min_cost_);
+  }
+
+  // Parks session as the most recent one for file, which was last modified
+  // at modified, and evicts the least recent ones past the budget. A
+  // session that alone exceeds the budget is dropped instead; it would
+  // evict everything else and still not fit. Returns whether it was kept.
+  bool Park(const std::filesystem::path &file, Session session,
+            std::filesystem::file_time_type modified, std::size_t memory) {
+    const std::string key = file.string();
+    const std::size_t cost = Cost(memory);
+    if (cost > sessions_.Budget()) {
+      sessions_.Erase(key);
+      return false;
+    }
+    sessions_.Put(key, {.session = std::move(session), .modified = modified},
+                  cost);
+    return true;
+  }
+
+  // Removes the session of file and returns it if file is still at the
+  // modification time it was parked with. modified is nullopt if the file
+  // can no longer be read; such a session is dropped like a modified one.
+  std::optional<Session>
+  Take(const std::filesystem::path &file,
+       std::optional<std::filesystem::file_time_type> modified) {
+    const std::string key = file.string();
+    Parked *parked = sessions_.Get(key);
+    if (parked == nullptr) {
+      return std::nullopt;
+    }
+    Parked taken = std::move(*parked);
+    sessions_.Erase(key);
+    if (modified != taken.modified) {
+      return std::nullopt;
+    }
+    return std::move(taken.session);
+  }
+
+  bool Contains(const std::filesystem::path &file) const {
+    return sessions_.Contains(file.string());
+  }
+
+  std::size_t Size() const { return sessions_.Size(); }
+  std::size_t TotalCost() const { return sessions_.TotalCost(); }
+
+private:
+  struct Parked {
+    Session session;
+    std::filesystem::file_time_type modified;
+  };
+
+  std::size_t min_cost_;
+  LruCache<std::string, Parked> sessions_;
+};
+
+} // namespace terminal_animation
@@ -0,0 +1,49 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace terminal_animation {
+
+// Recycles objects that are handed out as shared_ptr. An object goes back
+// to the pool as soon as the last reference outside the pool is dropped,
+// and Acquire() hands it out again with its contents (and the capacity of
+// any containers in it) intact. Once the pool holds as many objects as are
+// in use at once, Acquire() no longer allocates: not even the shared_ptr
+// control block, which is reused with the object. Thread-safe.
+template <typename T> class SharedPool {
+public:
+  // Returns an object that nobody else references, creating one only if
+  // every pooled object is in use.
+  std::shared_ptr<T> Acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &object : objects_) {
+      // Only the pool can copy its references, and it holds mutex_, so a
+      // count of 1 cannot grow behind our back.
+      if (object.use_count() == 1) {
+        // use_count() is a relaxed load; pair it with the release in the
+        // last owner's decrement so its writes to the object happen before
+        // ours.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return object;
+      }
+    }
+    return objects_.emplace_back(std::make_shared<T>());
+  }
+
+  // Number of objects owned by the pool, in use or not.
+  std::size_t Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return objects_.size();
+  }
+
+private:
+  std::vector<std::shared_ptr<T>> objects_;
+  mutable std::mutex mutex_;
+};
+
+} // namespace terminal_animation
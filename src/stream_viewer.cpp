@@ -0,0 +1,81 @@
+// header
+#include "stream_viewer.hpp"
+
+// local
+#include "frame_renderer.hpp"
+
+// libs
+// FTXUI
+#include <ftxui/component/component.hpp>
+#include <ftxui/screen/terminal.hpp>
+
+// std
+#include <algorithm>
+#include <iostream>
+
+namespace terminal_animation {
+
+bool StreamViewer::Run() {
+  if (!client_.Connect(socket_path_) || !client_.RequestStream(params_)) {
+    return false;
+  }
+
+  screen_.SetCursor(ftxui::Screen::Cursor{
+      .x = 0, .y = 0, .shape = ftxui::Screen::Cursor::Hidden});
+  auto component = ftxui::Renderer([this] { return Render(); });
+  component |= ftxui::CatchEvent(
+      [this](const ftxui::Event &event) { return HandleEvent(event); });
+  // As in AnimationUI::Run(), the terminal is written on its own thread.
+  std::streambuf *const stdout_buffer = std::cout.rdbuf(&terminal_writer_);
+  screen_.Loop(component);
+  terminal_writer_.Drain();
+  std::cout.rdbuf(stdout_buffer);
+  client_.Disconnect();
+  return true;
+}
+
+ftxui::Element StreamViewer::Render() {
+  const ftxui::Dimensions terminal = ftxui::Terminal::Size();
+  terminal_writer_.BeginFrame(
+      static_cast<std::uint32_t>(std::max(0, terminal.dimx)),
+      static_cast<std::uint32_t>(std::max(0, terminal.dimy)));
+  if (!client_.IsConnected()) {
+    return ftxui::text("Disconnected from " + socket_path_.string() +
+                       ", press q to quit") |
+           ftxui::center;
+  }
+  auto frame = client_.GetFrame();
+  if (!frame) {
+    return ftxui::text("Waiting for frames...") | ftxui::center;
+  }
+  return AsciiFrame(std::move(frame));
+}
+
+bool StreamViewer::HandleEvent(const ftxui::Event &event) {
+  if (event == ftxui::Event::Character('q')) {
+    screen_.ExitLoopClosure()();
+    return true;
+  }
+
+  StreamParams params = params_;
+  if (event == ftxui::Event::Character('+') ||
+      event == ftxui::Event::Character('=')) {
+    params.size = std::min(kMaxSize, params.size + kSizeStep);
+  } else if (event == ftxui::Event::Character('-')) {
+    params.size = std::max(1U, params.size - std::min(params.size, kSizeStep));
+  } else if (event == ftxui::Event::Character('c')) {
+    params.color_depth = params.color_depth == ColorDepth::kMonochrome
+                             ? ColorDepth::kTrueColor
+                             : ColorDepth::kMonochrome;
+  } else {
+    return false;
+  }
+
+  if (params != params_) {
+    params_ = params;
+    client_.RequestStream(params_);
+  }
+  return true;
+}
+
+} // namespace terminal_animation
@@ -0,0 +1,47 @@
+#pragma once
+
+// local
+#include "broadcast_client.hpp"
+#include "frame_protocol.hpp"
+#include "terminal_writer.hpp"
+
+// libs
+// FTXUI
+#include <ftxui/component/event.hpp>
+#include <ftxui/component/screen_interactive.hpp>
+#include <ftxui/dom/elements.hpp>
+
+// std
+#include <cstdint>
+#include <filesystem>
+#include <utility>
+
+namespace terminal_animation {
+
+// Full-screen viewer of the frames a BroadcastServer streams. It only draws;
+// decoding and conversion happen on the server.
+class StreamViewer {
+public:
+  static constexpr std::uint32_t kMaxSize = 512;
+  static constexpr std::uint32_t kSizeStep = 4;
+
+  StreamViewer(std::filesystem::path socket_path, StreamParams params)
+      : socket_path_(std::move(socket_path)), params_(params) {}
+
+  // Connects and runs the FTXUI event loop until quit. Returns false if no
+  // server accepts on the socket.
+  bool Run();
+
+private:
+  ftxui::Element Render();
+  bool HandleEvent(const ftxui::Event &event);
+
+  std::filesystem::path socket_path_;
+  StreamParams params_;
+
+  TerminalWriter terminal_writer_;
+  ftxui::ScreenInteractive screen_ = ftxui::ScreenInteractive::Fullscreen();
+  BroadcastClient client_{[this] { screen_.PostEvent(ftxui::Event::Custom); }};
+};
+
+} // namespace terminal_animation
@@ -0,0 +1,264 @@
+// header
+#include "task_scheduler.hpp"
+
+// std
+#include <algorithm>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace terminal_animation {
+
+namespace {
+
+// Identifies the scheduler and deque of the calling worker thread.
+thread_local const TaskScheduler *current_scheduler = nullptr;
+thread_local std::size_t current_worker = 0;
+
+void PinToCpu([[maybe_unused]] std::thread &thread,
+              [[maybe_unused]] std::size_t index) {
+#ifdef __linux__
+  const unsigned cpu_count = std::max(1U, std::thread::hardware_concurrency());
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(index % cpu_count, &cpus);
+  // Best effort: a restricted cpuset only loses the pinning.
+  pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus);
+#endif
+}
+
+} // namespace
+
+bool TaskHandle::Cancel() {
+  if (!state_) {
+    return true;
+  }
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  if (state_->status == Status::kQueued) {
+    state_->status = Status::kCancelled;
+    state_->cv.notify_all();
+  }
+  return state_->status == Status::kCancelled;
+}
+
+void TaskHandle::Wait() const {
+  if (!state_) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(state_->mutex);
+  state_->cv.wait(lock, [this] {
+    return state_->status == Status::kDone ||
+           state_->status == Status::kCancelled;
+  });
+}
+
+bool TaskHandle::IsDone() const {
+  if (!state_) {
+    return true;
+  }
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->status == Status::kDone ||
+         state_->status == Status::kCancelled;
+}
+
+TaskScheduler::TaskScheduler(Options options) {
+  std::uint32_t worker_count = options.worker_count;
+  if (worker_count == 0) {
+    worker_count = std::max(1U, std::thread::hardware_concurrency());
+  }
+
+  local_queues_.reserve(worker_count);
+  for (std::uint32_t i = 0; i < worker_count; ++i) {
+    local_queues_.push_back(std::make_unique<Queues>());
+  }
+  workers_.reserve(worker_count);
+  for (std::uint32_t i = 0; i < worker_count; ++i) {
+    workers_.emplace_back(&TaskScheduler::WorkerLoop, this, i);
+    if (options.pin_workers) {
+      PinToCpu(workers_.back(), i);
+    }
+  }
+}
+
+TaskScheduler::~TaskScheduler() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_sleep_);
+    stopping_ = true;
+  }
+  cv_work_.notify_all();
+  for (auto &worker : workers_) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+
+  // Release anyone waiting on a task that will never run.
+  for (auto &[time, delayed] : delayed_tasks_) {
+    CancelTask(delayed.task);
+  }
+  const auto cancel_all = [](Queues &queues) {
+    for (auto &tasks : queues.tasks) {
+      for (auto &task : tasks) {
+        CancelTask(task);
+      }
+    }
+  };
+  cancel_all(shared_queue_);
+  for (auto &queues : local_queues_) {
+    cancel_all(*queues);
+  }
+}
+
+TaskHandle TaskScheduler::Submit(TaskPriority priority,
+                                 std::function<void()> task) {
+  auto state = std::make_shared<TaskHandle::State>();
+  Enqueue(priority, Task{.run = std::move(task), .state = state});
+  return TaskHandle(std::move(state));
+}
+
+TaskHandle TaskScheduler::SubmitAt(std::chrono::steady_clock::time_point time,
+                                   TaskPriority priority,
+                                   std::function<void()> task) {
+  auto state = std::make_shared<TaskHandle::State>();
+  {
+    std::lock_guard<std::mutex> lock(mutex_sleep_);
+    delayed_tasks_.emplace(
+        time,
+        DelayedTask{.priority = priority,
+                    .task = Task{.run = std::move(task), .state = state}});
+    ++delayed_changes_;
+  }
+  // Some worker must recompute its wake-up time.
+  cv_work_.notify_one();
+  return TaskHandle(std::move(state));
+}
+
+void TaskScheduler::Enqueue(TaskPriority priority, Task task) {
+  Queues &queues = current_scheduler == this ? *local_queues_[current_worker]
+                                             : shared_queue_;
+  {
+    std::lock_guard<std::mutex> lock(queues.mutex);
+    queues.tasks[static_cast<std::size_t>(priority)].push_back(std::move(task));
+  }
+  queued_.fetch_add(1);
+
+  // Taking the mutex orders the increment before a sleeping worker's check.
+  { std::lock_guard<std::mutex> lock(mutex_sleep_); }
+  cv_work_.notify_one();
+}
+
+std::optional<TaskScheduler::Task> TaskScheduler::FindTask(std::size_t index) {
+  if (queued_.load() == 0) {
+    return std::nullopt;
+  }
+
+  const auto take = [this](Queues &queues, std::size_t priority,
+                           bool newest) -> std::optional<Task> {
+    std::lock_guard<std::mutex> lock(queues.mutex);
+    auto &tasks = queues.tasks[priority];
+    if (tasks.empty()) {
+      return std::nullopt;
+    }
+    Task task = std::move(newest ? tasks.back() : tasks.front());
+    if (newest) {
+      tasks.pop_back();
+    } else {
+      tasks.pop_front();
+    }
+    queued_.fetch_sub(1);
+    return task;
+  };
+
+  const std::size_t worker_count = local_queues_.size();
+  for (std::size_t priority = 0; priority < kTaskPriorityCount; ++priority) {
+    if (auto task = take(*local_queues_[index], priority, true)) {
+      return task;
+    }
+    if (auto task = take(shared_queue_, priority, false)) {
+      return task;
+    }
+    for (std::size_t offset = 1; offset < worker_count; ++offset) {
+      auto &victim = *local_queues_[(index + offset) % worker_count];
+      if (auto task = take(victim, priority, false)) {
+        return task;
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+void TaskScheduler::ReleaseDueTasks() {
+  const auto now = std::chrono::steady_clock::now();
+  while (!delayed_tasks_.empty() && delayed_tasks_.begin()->first <= now) {
+    auto node = delayed_tasks_.extract(delayed_tasks_.begin());
+    DelayedTask &delayed = node.mapped();
+    {
+      std::lock_guard<std::mutex> lock(shared_queue_.mutex);
+      shared_queue_.tasks[static_cast<std::size_t>(delayed.priority)]
+          .push_back(std::move(delayed.task));
+    }
+    queued_.fetch_add(1);
+  }
+}
+
+void TaskScheduler::WorkerLoop(std::size_t index) {
+  current_scheduler = this;
+  current_worker = index;
+
+  while (true) {
+    if (auto task = FindTask(index)) {
+      RunTask(*task);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_sleep_);
+    ReleaseDueTasks();
+    if (queued_.load() > 0) {
+      // Tasks became due, or were queued while searching.
+      cv_work_.notify_one();
+      continue;
+    }
+    if (stopping_) {
+      break;
+    }
+
+    const std::uint64_t seen_changes = delayed_changes_;
+    const auto has_news = [this, seen_changes] {
+      return stopping_ || queued_.load() > 0 ||
+             delayed_changes_ != seen_changes;
+    };
+    if (delayed_tasks_.empty()) {
+      cv_work_.wait(lock, has_news);
+    } else {
+      cv_work_.wait_until(lock, delayed_tasks_.begin()->first, has_news);
+    }
+  }
+}
+
+void TaskScheduler::RunTask(Task &task) {
+  {
+    std::lock_guard<std::mutex> lock(task.state->mutex);
+    if (task.state->status == TaskHandle::Status::kCancelled) {
+      return;
+    }
+    task.state->status = TaskHandle::Status::kRunning;
+  }
+
+  task.run();
+  // Drop captured state before waiters resume.
+  task.run = nullptr;
+
+  std::lock_guard<std::mutex> lock(task.state->mutex);
+  task.state->status = TaskHandle::Status::kDone;
+  task.state->cv.notify_all();
+}
+
+void TaskScheduler::CancelTask(Task &task) {
+  std::lock_guard<std::mutex> lock(task.state->mutex);
+  task.state->status = TaskHandle::Status::kCancelled;
+  task.state->cv.notify_all();
+}
+
+} // namespace terminal_animation
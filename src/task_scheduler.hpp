@@ -0,0 +1,152 @@
+#pragma once
+
+// std
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace terminal_animation {
+
+// Priority of a task, from most to least urgent.
+enum class TaskPriority : std::uint8_t {
+  // Work whose result is shown next: opening a file, pacing playback.
+  kVisibleFrame,
+  // Converting video frames ahead of playback.
+  kLookAhead,
+  // Speculatively opening the highlighted file.
+  kPrefetch,
+  // Explorer preview thumbnails.
+  kThumbnail,
+};
+
+inline constexpr std::size_t kTaskPriorityCount = 4;
+
+// Refers to a task submitted to a TaskScheduler. Copies refer to the same
+// task; a default-constructed handle refers to none.
+class TaskHandle {
+public:
+  TaskHandle() = default;
+
+  // Prevents the task from running if it has not started yet. Returns true
+  // if the task will not run.
+  bool Cancel();
+
+  // Blocks until the task finished or was cancelled. Returns immediately
+  // for an empty handle.
+  void Wait() const;
+
+  // True once the task finished or was cancelled, and for an empty handle.
+  bool IsDone() const;
+
+private:
+  friend class TaskScheduler;
+
+  enum class Status { kQueued, kRunning, kDone, kCancelled };
+
+  struct State {
+    std::mutex mutex;
+    std::condition_variable cv;
+    Status status = Status::kQueued;
+  };
+
+  explicit TaskHandle(std::shared_ptr<State> state)
+      : state_(std::move(state)) {}
+
+  std::shared_ptr<State> state_;
+};
+
+// Work-stealing thread pool shared by all background work. Each worker has
+// its own deque per priority: tasks submitted from a worker go to its own
+// deque and are taken newest first, other tasks go to a shared queue, and
+// idle workers steal the oldest tasks of busy ones. A worker always takes
+// the most urgent task it can find. Workers sleep while there is no work.
+class TaskScheduler {
+public:
+  struct Options {
+    // 0 starts one worker per hardware thread.
+    std::uint32_t worker_count = 0;
+    // Pins worker i to CPU i modulo the CPU count. Linux only.
+    bool pin_workers = false;
+  };
+
+  TaskScheduler() : TaskScheduler(Options{}) {}
+  explicit TaskScheduler(Options options);
+
+  // Finishes the tasks already queued and cancels delayed ones that are not
+  // due yet. Owners must stop resubmitting before destroying the scheduler.
+  ~TaskScheduler();
+
+  TaskScheduler(const TaskScheduler &) = delete;
+  TaskScheduler &operator=(const TaskScheduler &) = delete;
+
+  TaskHandle Submit(TaskPriority priority, std::function<void()> task);
+
+  // Like Submit(), but the task does not run before time.
+  TaskHandle SubmitAt(std::chrono::steady_clock::time_point time,
+                      TaskPriority priority, std::function<void()> task);
+
+  std::uint32_t WorkerCount() const {
+    return static_cast<std::uint32_t>(workers_.size());
+  }
+
+private:
+  struct Task {
+    std::function<void()> run;
+    std::shared_ptr<TaskHandle::State> state;
+  };
+
+  struct Queues {
+    std::mutex mutex;
+    std::array<std::deque<Task>, kTaskPriorityCount> tasks;
+  };
+
+  struct DelayedTask {
+    TaskPriority priority;
+    Task task;
+  };
+
+  // Worker thread entry.
+  void WorkerLoop(std::size_t index);
+
+  // Pushes a task onto the calling worker's deque, or the shared queue when
+  // called from another thread, and wakes a worker.
+  void Enqueue(TaskPriority priority, Task task);
+
+  // Takes the most urgent task: own deque (newest first), then the shared
+  // queue, then the other workers' deques (oldest first).
+  std::optional<Task> FindTask(std::size_t index);
+
+  // Moves delayed tasks that are due into the shared queue. Requires
+  // mutex_sleep_.
+  void ReleaseDueTasks();
+
+  static void RunTask(Task &task);
+  static void CancelTask(Task &task);
+
+  std::vector<std::unique_ptr<Queues>> local_queues_;
+  Queues shared_queue_;
+  std::atomic<std::size_t> queued_{0};
+
+  // Guarded by mutex_sleep_.
+  std::multimap<std::chrono::steady_clock::time_point, DelayedTask>
+      delayed_tasks_;
+  std::uint64_t delayed_changes_ = 0;
+  bool stopping_ = false;
+
+  std::mutex mutex_sleep_;
+  std::condition_variable cv_work_;
+  std::vector<std::thread> workers_;
+};
+
+} // namespace terminal_animation
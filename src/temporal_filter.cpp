@@ -0,0 +1,102 @@
+// header
+#include "temporal_filter.hpp"
+
+// std
+#include <optional>
+
+namespace terminal_animation {
+
+namespace {
+
+std::uint8_t active_threshold = 0;
+
+std::size_t DecimalDigits(std::uint32_t value) {
+  std::size_t digits = 1;
+  for (; value >= 10; value /= 10) {
+    ++digits;
+  }
+  return digits;
+}
+
+bool IsSameGrid(const CharsAndColors &previous,
+                const CharsAndColors &current) {
+  return previous.columns == current.columns &&
+         previous.rows == current.rows &&
+         previous.chars.size() == current.chars.size() &&
+         previous.colors.size() == current.colors.size();
+}
+
+bool IsCellChanged(const CharsAndColors &previous,
+                   const CharsAndColors &current, std::size_t cell) {
+  return previous.chars[cell] != current.chars[cell] ||
+         (!current.colors.empty() &&
+          previous.colors[cell] != current.colors[cell]);
+}
+
+} // namespace
+
+TemporalFilter::TemporalFilter(const GlyphTable &glyphs,
+                               const CharsAndColors &previous,
+                               std::uint8_t threshold)
+    : glyphs_(glyphs), previous_(previous), threshold_(threshold) {
+  first_.fill(1024);
+  last_.fill(-1024);
+  for (std::int32_t value = 255; value >= 0; --value) {
+    first_[static_cast<unsigned char>(glyphs[value])] = value;
+  }
+  for (std::int32_t value = 0; value < 256; ++value) {
+    last_[static_cast<unsigned char>(glyphs[value])] = value;
+  }
+}
+
+std::uint8_t GetStabilizeThreshold() { return active_threshold; }
+
+void SetStabilizeThreshold(std::uint8_t threshold) {
+  active_threshold = threshold;
+}
+
+std::size_t CountChangedCells(const CharsAndColors &previous,
+                              const CharsAndColors &current) {
+  if (!IsSameGrid(previous, current)) {
+    return current.chars.size();
+  }
+  std::size_t changed = 0;
+  for (std::size_t cell = 0; cell < current.chars.size(); ++cell) {
+    changed += IsCellChanged(previous, current, cell) ? 1 : 0;
+  }
+  return changed;
+}
+
+std::size_t EstimateDeltaBytes(const CharsAndColors &previous,
+                               const CharsAndColors &current) {
+  const bool redraw_all = !IsSameGrid(previous, current);
+  const bool has_colors = !current.colors.empty();
+  std::optional<std::array<std::uint8_t, 3>> sent_color;
+  std::size_t bytes = 0;
+  std::size_t cell = 0;
+  for (std::uint32_t y = 0; y < current.rows; ++y) {
+    bool in_run = false;
+    for (std::uint32_t x = 0; x < current.columns; ++x, ++cell) {
+      if (!redraw_all && !IsCellChanged(previous, current, cell)) {
+        in_run = false;
+        continue;
+      }
+      if (!in_run) {
+        // ESC [ row ; column H
+        bytes += 4 + DecimalDigits(y + 1) + DecimalDigits(x + 1);
+        in_run = true;
+      }
+      if (has_colors && sent_color != current.colors[cell]) {
+        const std::array<std::uint8_t, 3> &color = current.colors[cell];
+        // ESC [ 38 ; 2 ; r ; g ; b m
+        bytes += 10 + DecimalDigits(color[0]) + DecimalDigits(color[1]) +
+                 DecimalDigits(color[2]);
+        sent_color = color;
+      }
+      ++bytes;
+    }
+  }
+  return bytes;
+}
+
+} // namespace terminal_animation
@@ -0,0 +1,89 @@
+#pragma once
+
+// local
+#include "chars_and_colors.hpp"
+#include "glyph_table.hpp"
+
+// std
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace terminal_animation {
+
+// Hysteresis between consecutive frames of a video: a cell keeps what the
+// previous frame showed until its luminance or color moves further than a
+// threshold. Noise and compression artifacts then no longer flip cells
+// between neighboring glyphs and colors every frame.
+//
+// A glyph is kept while the cell's luminance stays within threshold of the
+// band of luminances the glyph is drawn for, so a cell on the edge of two
+// bands does not alternate between them. A color is kept, together with
+// its glyph, while no channel moved by more than threshold.
+class TemporalFilter {
+public:
+  // previous must have the grid and color mode of the frame being
+  // converted, and outlive the filter.
+  TemporalFilter(const GlyphTable &glyphs, const CharsAndColors &previous,
+                 std::uint8_t threshold);
+
+  // Returns the glyph for cell at the given luminance.
+  char FilterGlyph(std::size_t cell, std::uint8_t luminance) const {
+    const char held = previous_.chars[cell];
+    const auto band = static_cast<unsigned char>(held);
+    if (luminance + threshold_ >= first_[band] &&
+        luminance <= last_[band] + threshold_) {
+      return held;
+    }
+    return glyphs_[luminance];
+  }
+
+  // Returns true if cell keeps its previous color and glyph at the given
+  // color.
+  bool HoldsColor(std::size_t cell, std::uint32_t r, std::uint32_t g,
+                  std::uint32_t b) const {
+    const std::array<std::uint8_t, 3> &held = previous_.colors[cell];
+    return Distance(held[0], r) <= threshold_ &&
+           Distance(held[1], g) <= threshold_ &&
+           Distance(held[2], b) <= threshold_;
+  }
+
+  const CharsAndColors &GetPrevious() const { return previous_; }
+
+private:
+  static std::int32_t Distance(std::uint32_t a, std::uint32_t b) {
+    return a > b ? static_cast<std::int32_t>(a - b)
+                 : static_cast<std::int32_t>(b - a);
+  }
+
+  const GlyphTable &glyphs_;
+  const CharsAndColors &previous_;
+  std::int32_t threshold_;
+  // Lowest and highest luminance each glyph is drawn for. Glyphs the table
+  // never draws get an empty band out of reach of any threshold.
+  std::array<std::int32_t, 256> first_;
+  std::array<std::int32_t, 256> last_;
+};
+
+// Returns the threshold every video conversion filters with, in 8-bit
+// luminance and color steps; 0, no filtering, unless
+// SetStabilizeThreshold() chose another.
+std::uint8_t GetStabilizeThreshold();
+
+// Selects the threshold every video conversion filters with. Not
+// synchronized: call it at startup, before anything is converted.
+void SetStabilizeThreshold(std::uint8_t threshold);
+
+// Returns the number of cells of current that differ from previous in
+// glyph or color; all of them if the grids differ.
+std::size_t CountChangedCells(const CharsAndColors &previous,
+                              const CharsAndColors &current);
+
+// Returns the bytes a terminal would be sent to turn previous into current
+// by redrawing only the changed cells: a cursor move to each run of changed
+// cells in a row, a 24-bit foreground color whenever it differs from the
+// last one sent, and the glyphs. All cells are drawn if the grids differ.
+std::size_t EstimateDeltaBytes(const CharsAndColors &previous,
+                               const CharsAndColors &current);
+
+} // namespace terminal_animation
@@ -0,0 +1,137 @@
+// header
+#include "terminal_writer.hpp"
+
+// std
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <utility>
+
+#if defined(__linux__) || defined(__APPLE__)
+#define TERMINAL_ANIMATION_POSIX 1
+#include <unistd.h>
+#endif
+
+namespace terminal_animation {
+
+void TerminalWriter::WriteToStdout(std::string_view data) {
+#ifdef TERMINAL_ANIMATION_POSIX
+  while (!data.empty()) {
+    const auto result = write(STDOUT_FILENO, data.data(), data.size());
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result <= 0) {
+      // The terminal is gone; there is nobody left to show the output to.
+      return;
+    }
+    data.remove_prefix(static_cast<std::size_t>(result));
+  }
+#else
+  std::fwrite(data.data(), 1, data.size(), stdout);
+  std::fflush(stdout);
+#endif
+}
+
+TerminalWriter::TerminalWriter(Sink sink)
+    : sink_(std::move(sink)), thread_write_([this] { WriteLoop(); }) {}
+
+TerminalWriter::~TerminalWriter() {
+  sync();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    should_run_ = false;
+  }
+  cv_pending_.notify_one();
+  thread_write_.join();
+}
+
+void TerminalWriter::BeginFrame(std::uint32_t columns, std::uint32_t rows) {
+  frame_offset_ = staging_.size();
+  is_frame_replaceable_ = columns == frame_columns_ && rows == frame_rows_;
+  frame_columns_ = columns;
+  frame_rows_ = rows;
+}
+
+void TerminalWriter::Drain() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_written_.wait(lock, [this] { return pending_.empty() && !is_writing_; });
+}
+
+TerminalWriter::Stats TerminalWriter::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+TerminalWriter::int_type TerminalWriter::overflow(int_type ch) {
+  if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+    staging_.push_back(traits_type::to_char_type(ch));
+  }
+  return traits_type::not_eof(ch);
+}
+
+std::streamsize TerminalWriter::xsputn(const char *data,
+                                       std::streamsize count) {
+  staging_.append(data, static_cast<std::size_t>(count));
+  return count;
+}
+
+int TerminalWriter::sync() {
+  if (staging_.empty()) {
+    return 0;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const bool is_frame = frame_offset_.has_value() && is_frame_replaceable_;
+    // Only a frame flushed on its own may drop the waiting one; output
+    // before it would otherwise be reordered.
+    if (is_frame && *frame_offset_ == 0 && replaceable_offset_.has_value()) {
+      pending_.resize(*replaceable_offset_);
+      ++stats_.frames_replaced;
+    }
+    if (is_frame) {
+      replaceable_offset_ = pending_.size() + *frame_offset_;
+    } else {
+      replaceable_offset_.reset();
+    }
+    pending_ += staging_;
+  }
+  cv_pending_.notify_one();
+  staging_.clear();
+  frame_offset_.reset();
+  return 0;
+}
+
+void TerminalWriter::WriteLoop() {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_pending_.wait(lock,
+                       [this] { return !pending_.empty() || !should_run_; });
+      if (pending_.empty()) {
+        return;
+      }
+      // Swap buffers; both keep their capacity, so steady output allocates
+      // nothing.
+      writing_.swap(pending_);
+      replaceable_offset_.reset();
+      is_writing_ = true;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    sink_(writing_);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.bytes_written += writing_.size();
+    ++stats_.writes;
+    stats_.write_time += elapsed;
+    stats_.longest_write = std::max<std::chrono::nanoseconds>(
+        stats_.longest_write, elapsed);
+    is_writing_ = false;
+    writing_.clear();
+    cv_written_.notify_all();
+  }
+}
+
+} // namespace terminal_animation
@@ -0,0 +1,104 @@
+#pragma once
+
+// std
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace terminal_animation {
+
+// Writes terminal output on a background thread, so a slow terminal or SSH
+// link never blocks the thread producing it. Install it as std::cout's
+// buffer: output is collected until the stream is flushed and then handed
+// to the writer thread. Output is double-buffered: while one buffer is
+// written, flushes append to the other.
+//
+// Output marked as a frame with BeginFrame() is redrawn from scratch by the
+// next frame, so a frame still waiting when a newer one of the same
+// dimensions is flushed is replaced by it: the terminal gets the latest
+// frame as soon as it has caught up, instead of a growing backlog. Other
+// output, such as mode changes, is always written, in order.
+//
+// The stream side is not thread-safe: one thread writes and flushes.
+class TerminalWriter : public std::streambuf {
+public:
+  // Blocks until all of data is written.
+  using Sink = std::function<void(std::string_view data)>;
+
+  struct Stats {
+    std::uint64_t bytes_written = 0;
+    // Calls to the sink; one per buffer swap.
+    std::uint64_t writes = 0;
+    // Frames that were replaced by a newer one before being written.
+    std::uint64_t frames_replaced = 0;
+    // Time spent blocked in the sink, in total and for the longest write.
+    std::chrono::nanoseconds write_time{0};
+    std::chrono::nanoseconds longest_write{0};
+  };
+
+  // Writes data to the process's standard output.
+  static void WriteToStdout(std::string_view data);
+
+  explicit TerminalWriter(Sink sink = WriteToStdout);
+
+  // Writes everything flushed so far and joins the writer thread.
+  ~TerminalWriter() override;
+
+  TerminalWriter(const TerminalWriter &) = delete;
+  TerminalWriter &operator=(const TerminalWriter &) = delete;
+
+  // Marks the output from here to the next flush as a complete frame
+  // filling columns x rows cells. A frame can only replace, and be replaced
+  // by, frames of the same dimensions that follow one of them: after a
+  // resize the terminal needs the first frame drawn at the new size.
+  void BeginFrame(std::uint32_t columns, std::uint32_t rows);
+
+  // Blocks until everything flushed so far is written.
+  void Drain();
+
+  Stats GetStats() const;
+
+protected:
+  int_type overflow(int_type ch) override;
+  std::streamsize xsputn(const char *data, std::streamsize count) override;
+  int sync() override;
+
+private:
+  // Writer thread entry.
+  void WriteLoop();
+
+  Sink sink_;
+
+  // Stream side: output since the last flush, and where the frame begun
+  // with BeginFrame() starts in it.
+  std::string staging_;
+  std::optional<std::size_t> frame_offset_;
+  bool is_frame_replaceable_ = false;
+  std::uint32_t frame_columns_ = 0;
+  std::uint32_t frame_rows_ = 0;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_pending_;
+  std::condition_variable cv_written_;
+  // The back buffer: flushed output waiting for the writer thread, and
+  // where the frame that may still be replaced starts in it.
+  std::string pending_;
+  std::optional<std::size_t> replaceable_offset_;
+  bool is_writing_ = false;
+  bool should_run_ = true;
+  Stats stats_;
+
+  // The front buffer, only touched by the writer thread.
+  std::string writing_;
+
+  std::thread thread_write_;
+};
+
+} // namespace terminal_animation
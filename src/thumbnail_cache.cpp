@@ -0,0 +1,328 @@
+// header
+#include "thumbnail_cache.hpp"
+
+// local
+#include "common.hpp"
+#include "glyph_table.hpp"
+#include "raw_video_reader.hpp"
+
+// std
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+#include <utility>
+
+namespace terminal_animation {
+
+namespace {
+
+// Bumped whenever conversion changes, so stale thumbnails are redrawn.
+constexpr char kDiskMagic[8] = {'T', 'A', 'T', 'H', 'U', 'M', 'B', '3'};
+
+template <typename T> void WriteValue(std::ofstream &out, const T &value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T> bool ReadValue(std::ifstream &in, T &value) {
+  return static_cast<bool>(
+      in.read(reinterpret_cast<char *>(&value), sizeof(value)));
+}
+
+} // namespace
+
+std::filesystem::path ThumbnailCache::GetDefaultDiskDirectory() {
+  return GetCacheDirectory() / "thumbnails";
+}
+
+ThumbnailCache::ThumbnailCache(std::filesystem::path disk_directory,
+                               std::function<void()> on_ready,
+                               TaskScheduler &tasks)
+    : disk_directory_(std::move(disk_directory)),
+      on_ready_(std::move(on_ready)), tasks_(tasks) {
+  if (!disk_directory_.empty()) {
+    std::error_code ec;
+    std::filesystem::create_directories(disk_directory_, ec);
+    if (ec) {
+      logger_->warn("[ThumbnailCache::ThumbnailCache] Disk cache disabled, "
+                    "could not create {}: {}",
+                    disk_directory_.string(), ec.message());
+      disk_directory_.clear();
+    }
+  }
+  if (!disk_directory_.empty()) {
+    // Listing the directory may take a while; keep it off the UI thread.
+    std::lock_guard<std::mutex> lock(mutex_thumbnails_);
+    ++active_tasks_;
+    tasks_.Submit(TaskPriority::kThumbnail, [this] {
+      TrimDisk();
+      std::lock_guard<std::mutex> lock_done(mutex_thumbnails_);
+      --active_tasks_;
+      cv_tasks_done_.notify_all();
+      ScheduleGeneration();
+    });
+  }
+}
+
+ThumbnailCache::~ThumbnailCache() {
+  std::unique_lock<std::mutex> lock(mutex_thumbnails_);
+  should_run_ = false;
+  // Queued tasks still run, see should_run_ and return.
+  cv_tasks_done_.wait(lock, [this] { return active_tasks_ == 0; });
+}
+
+std::optional<MediaToAscii::CharsAndColors>
+ThumbnailCache::Get(const std::filesystem::path &file) {
+  const std::string key = file.string();
+
+  std::lock_guard<std::mutex> lock(mutex_thumbnails_);
+  if (const auto *thumbnail = memory_cache_.Get(key)) {
+    return *thumbnail;
+  }
+
+  if (requested_.insert(key).second) {
+    queue_.push_front(file);
+    if (queue_.size() > kMaxQueued) {
+      requested_.erase(queue_.back().string());
+      queue_.pop_back();
+    }
+    ScheduleGeneration();
+  }
+  return std::nullopt;
+}
+
+void ThumbnailCache::Invalidate(const std::filesystem::path &file) {
+  std::lock_guard<std::mutex> lock(mutex_thumbnails_);
+  memory_cache_.Erase(file.string());
+}
+
+void ThumbnailCache::ScheduleGeneration() {
+  while (should_run_ && active_tasks_ < kWorkerCount &&
+         active_tasks_ < queue_.size()) {
+    ++active_tasks_;
+    tasks_.Submit(TaskPriority::kThumbnail, [this] { GenerateNext(); });
+  }
+}
+
+void ThumbnailCache::GenerateNext() {
+  std::optional<std::filesystem::path> file;
+  {
+    std::lock_guard<std::mutex> lock(mutex_thumbnails_);
+    if (should_run_ && !queue_.empty()) {
+      file = std::move(queue_.front());
+      queue_.pop_front();
+    }
+  }
+
+  std::optional<MediaToAscii::CharsAndColors> thumbnail;
+  if (file.has_value()) {
+    thumbnail = Generate(*file);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_thumbnails_);
+  if (thumbnail.has_value()) {
+    requested_.erase(file->string());
+    memory_cache_.Put(file->string(), std::move(*thumbnail));
+    if (on_ready_) {
+      on_ready_();
+    }
+  }
+
+  --active_tasks_;
+  cv_tasks_done_.notify_all();
+  ScheduleGeneration();
+}
+
+void ThumbnailCache::TrimDisk() {
+  const std::size_t removed = TrimDirectory(disk_directory_, kDiskEntries);
+  if (removed > 0) {
+    logger_->info("[ThumbnailCache::TrimDisk] Removed {} old thumbnails "
+                  "from {}",
+                  removed, disk_directory_.string());
+  }
+}
+
+MediaToAscii::CharsAndColors
+ThumbnailCache::Generate(const std::filesystem::path &file) {
+  std::error_code ec;
+  const auto modified = std::filesystem::last_write_time(file, ec);
+  if (ec) {
+    return {};
+  }
+
+  if (auto cached = LoadFromDisk(file, modified)) {
+    return std::move(*cached);
+  }
+
+  cv::Mat frame;
+  if (IsImageExtension(file)) {
+    const auto dimensions = ReadImageDimensions(file);
+    frame = MediaToAscii::ReadImage(
+        file, dimensions.has_value()
+                  ? ChooseImageReduction(*dimensions, kMaxRows)
+                  : 1);
+  } else if (IsRawVideoExtension(file)) {
+    // FFmpeg cannot tell the layout of headerless files; the reader takes
+    // it from the name like playback does.
+    RawVideoReader reader;
+    cv::Mat converted;
+    if (reader.Open(file)) {
+      // The mapping goes away with reader.
+      frame = MediaToAscii::DecodeRawFrame(reader, 0, false, converted)
+                  .clone();
+    }
+  } else {
+    cv::VideoCapture capture(file.string());
+    if (capture.isOpened()) {
+      capture >> frame;
+    }
+  }
+
+  MediaToAscii::CharsAndColors thumbnail;
+  if (frame.empty()) {
+    logger_->warn("[ThumbnailCache::Generate] Could not decode {}",
+                  file.string());
+    return thumbnail;
+  }
+
+  // Largest size whose grid, rounded to whole blocks, still fits
+  // kMaxCols x kMaxRows, so LoadFromDisk() accepts what is saved.
+  const std::uint32_t size = FitPaneSize(
+      kMaxCols, kMaxRows,
+      {.width = static_cast<std::uint32_t>(frame.cols),
+       .height = static_cast<std::uint32_t>(frame.rows)});
+  MediaToAscii::ConvertFrame(frame, size, thumbnail);
+
+  // Even the smallest grid of a very wide frame can be wider; it is only
+  // kept in memory.
+  if (thumbnail.columns > kMaxCols || thumbnail.rows > kMaxRows) {
+    return thumbnail;
+  }
+  SaveToDisk(file, modified, thumbnail);
+  bool should_trim = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_thumbnails_);
+    should_trim = !disk_directory_.empty() &&
+                  ++saves_since_trim_ >= kDiskTrimInterval;
+    if (should_trim) {
+      saves_since_trim_ = 0;
+    }
+  }
+  if (should_trim) {
+    TrimDisk();
+  }
+  return thumbnail;
+}
+
+std::filesystem::path
+ThumbnailCache::DiskPath(const std::filesystem::path &file,
+                         std::filesystem::file_time_type modified) const {
+  // The glyph table is part of the key: each charset has its thumbnails.
+  const GlyphTable &glyphs = GetGlyphTable();
+  const std::size_t hash = std::hash<std::string>{}(
+      file.string() + '\0' +
+      std::to_string(modified.time_since_epoch().count()) + '\0' +
+      std::string(glyphs.begin(), glyphs.end()));
+
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016zx.thumb", hash);
+  return disk_directory_ / name;
+}
+
+std::optional<MediaToAscii::CharsAndColors> ThumbnailCache::LoadFromDisk(
+    const std::filesystem::path &file,
+    std::filesystem::file_time_type modified) const {
+  if (disk_directory_.empty()) {
+    return std::nullopt;
+  }
+
+  std::ifstream in(DiskPath(file, modified), std::ios::binary);
+  if (!in) {
+    return std::nullopt;
+  }
+
+  char magic[sizeof(kDiskMagic)];
+  std::int64_t stored_modified = 0;
+  std::uint32_t path_length = 0;
+  std::uint32_t cols = 0;
+  std::uint32_t rows = 0;
+  if (!in.read(magic, sizeof(magic)) ||
+      std::memcmp(magic, kDiskMagic, sizeof(magic)) != 0 ||
+      !ReadValue(in, stored_modified) || !ReadValue(in, path_length) ||
+      path_length > 4096) {
+    return std::nullopt;
+  }
+
+  // The hash may collide, so the entry stores what it was generated from.
+  std::string stored_path(path_length, '\0');
+  if (!in.read(stored_path.data(), path_length) ||
+      stored_path != file.string() ||
+      stored_modified != modified.time_since_epoch().count() ||
+      !ReadValue(in, cols) || !ReadValue(in, rows) || cols > kMaxCols ||
+      rows > kMaxRows) {
+    return std::nullopt;
+  }
+
+  MediaToAscii::CharsAndColors thumbnail;
+  thumbnail.columns = cols;
+  thumbnail.rows = rows;
+  thumbnail.chars.resize(static_cast<std::size_t>(cols) * rows);
+  thumbnail.colors.resize(thumbnail.chars.size());
+  // Entries store the cells column by column.
+  for (std::uint32_t i = 0; i < cols; ++i) {
+    for (std::uint32_t j = 0; j < rows; ++j) {
+      const std::size_t cell = static_cast<std::size_t>(j) * cols + i;
+      if (!ReadValue(in, thumbnail.chars[cell]) ||
+          !ReadValue(in, thumbnail.colors[cell])) {
+        return std::nullopt;
+      }
+    }
+  }
+  return thumbnail;
+}
+
+void ThumbnailCache::SaveToDisk(
+    const std::filesystem::path &file,
+    std::filesystem::file_time_type modified,
+    const MediaToAscii::CharsAndColors &thumbnail) const {
+  if (disk_directory_.empty() || thumbnail.chars.empty()) {
+    return;
+  }
+
+  const std::filesystem::path target = DiskPath(file, modified);
+  std::filesystem::path temporary = target;
+  temporary += ".tmp";
+
+  {
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      return;
+    }
+
+    const std::string path = file.string();
+    out.write(kDiskMagic, sizeof(kDiskMagic));
+    WriteValue(out, static_cast<std::int64_t>(
+                        modified.time_since_epoch().count()));
+    WriteValue(out, static_cast<std::uint32_t>(path.size()));
+    out.write(path.data(), static_cast<std::streamsize>(path.size()));
+    WriteValue(out, thumbnail.columns);
+    WriteValue(out, thumbnail.rows);
+    for (std::uint32_t i = 0; i < thumbnail.columns; ++i) {
+      for (std::uint32_t j = 0; j < thumbnail.rows; ++j) {
+        const std::size_t cell =
+            static_cast<std::size_t>(j) * thumbnail.columns + i;
+        WriteValue(out, thumbnail.chars[cell]);
+        WriteValue(out, thumbnail.colors[cell]);
+      }
+    }
+  }
+
+  // Rename so a concurrent reader never sees a partially written entry.
+  std::error_code ec;
+  std::filesystem::rename(temporary, target, ec);
+  if (ec) {
+    std::filesystem::remove(temporary, ec);
+  }
+}
+
+} // namespace terminal_animation
@@ -0,0 +1,110 @@
+#pragma once
+
+// local
+#include "logger.hpp"
+#include "lru_cache.hpp"
+#include "media_to_ascii.hpp"
+#include "task_scheduler.hpp"
+
+// std
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_set>
+
+namespace terminal_animation {
+
+// Generates small ASCII previews of media files as kThumbnail tasks on a
+// TaskScheduler. Thumbnails are kept in an in-memory LRU and, if a disk
+// directory is given, persisted there keyed by path and modification time.
+// The disk directory is trimmed to kDiskEntries files, least recently
+// written first, when the cache opens and every kDiskTrimInterval saves.
+class ThumbnailCache {
+public:
+  // Largest thumbnail, in character cells.
+  static constexpr std::uint32_t kMaxRows = 10;
+  static constexpr std::uint32_t kMaxCols = 28;
+
+  static constexpr std::size_t kMemoryEntries = 512;
+  // About 2 MB with the largest thumbnails.
+  static constexpr std::size_t kDiskEntries = 4096;
+  static constexpr std::uint32_t kDiskTrimInterval = 256;
+  // Thumbnails generated at once.
+  static constexpr std::uint32_t kWorkerCount = 2;
+  // Older requests are dropped first when scrolling quickly.
+  static constexpr std::size_t kMaxQueued = 16;
+
+  // Returns GetCacheDirectory()/thumbnails.
+  static std::filesystem::path GetDefaultDiskDirectory();
+
+  // An empty disk_directory disables persistence. on_ready is called from a
+  // task whenever a new thumbnail becomes available.
+  ThumbnailCache(std::filesystem::path disk_directory,
+                 std::function<void()> on_ready, TaskScheduler &tasks);
+
+  // Waits for thumbnails being generated. Must be destroyed before tasks.
+  ~ThumbnailCache();
+
+  ThumbnailCache(const ThumbnailCache &) = delete;
+  ThumbnailCache &operator=(const ThumbnailCache &) = delete;
+
+  // Returns the thumbnail of file if it is in memory. Otherwise queues it for
+  // generation and returns std::nullopt. A thumbnail with no characters means
+  // the file could not be decoded.
+  std::optional<MediaToAscii::CharsAndColors>
+  Get(const std::filesystem::path &file);
+
+  // Drops the in-memory thumbnail of file, e.g. after it was rewritten.
+  // The disk entry is keyed by mtime and goes stale on its own.
+  void Invalidate(const std::filesystem::path &file);
+
+private:
+  // Task body: generates the newest queued thumbnail.
+  void GenerateNext();
+
+  // Submits tasks for queued thumbnails, up to kWorkerCount at once.
+  // Requires mutex_thumbnails_.
+  void ScheduleGeneration();
+
+  // Task body: trims the disk directory to kDiskEntries files.
+  void TrimDisk();
+
+  // Decodes a reduced frame of file and converts it to a thumbnail.
+  MediaToAscii::CharsAndColors Generate(const std::filesystem::path &file);
+
+  std::filesystem::path
+  DiskPath(const std::filesystem::path &file,
+           std::filesystem::file_time_type modified) const;
+
+  std::optional<MediaToAscii::CharsAndColors>
+  LoadFromDisk(const std::filesystem::path &file,
+               std::filesystem::file_time_type modified) const;
+
+  void SaveToDisk(const std::filesystem::path &file,
+                  std::filesystem::file_time_type modified,
+                  const MediaToAscii::CharsAndColors &thumbnail) const;
+
+  std::filesystem::path disk_directory_;
+  std::function<void()> on_ready_;
+  TaskScheduler &tasks_;
+
+  LruCache<std::string, MediaToAscii::CharsAndColors> memory_cache_{
+      kMemoryEntries};
+  std::deque<std::filesystem::path> queue_;
+  std::unordered_set<std::string> requested_;
+  // Tasks submitted and not finished yet.
+  std::uint32_t active_tasks_ = 0;
+  std::uint32_t saves_since_trim_ = 0;
+  bool should_run_ = true;
+  std::mutex mutex_thumbnails_;
+  std::condition_variable cv_tasks_done_;
+
+  std::shared_ptr<spdlog::logger> logger_ = GetLogger("ThumbnailCache");
+};
+
+} // namespace terminal_animation
@@ -0,0 +1,154 @@
+#include "command_line.hpp"
+
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace terminal_animation {
+namespace {
+
+TEST(ParseCommandLineTest, NoArgumentsRunsInteractively) {
+  const auto command_line = ParseCommandLine({});
+  ASSERT_TRUE(command_line.has_value());
+  EXPECT_EQ(command_line->mode, CommandLine::Mode::kInteractive);
+}
+
+TEST(ParseCommandLineTest, ParsesServeMode) {
+  const auto command_line =
+      ParseCommandLine({"--serve=clip.mp4", "--socket=/tmp/feed.sock"});
+  ASSERT_TRUE(command_line.has_value());
+  EXPECT_EQ(command_line->mode, CommandLine::Mode::kServe);
+  EXPECT_EQ(command_line->file, "clip.mp4");
+  EXPECT_EQ(command_line->socket, "/tmp/feed.sock");
+}
+
+TEST(ParseCommandLineTest, ParsesConnectModeWithDefaults) {
+  const auto command_line =
+      ParseCommandLine({"--connect", "--size=48", "--monochrome"});
+  ASSERT_TRUE(command_line.has_value());
+  EXPECT_EQ(command_line->mode, CommandLine::Mode::kConnect);
+  EXPECT_EQ(command_line->socket, GetDefaultSocketPath());
+  EXPECT_EQ(command_line->size, 48U);
+  EXPECT_TRUE(command_line->monochrome);
+}
+
+#ifndef _WIN32
+TEST(GetDefaultSocketPathTest, IsPrivateToTheUser) {
+  const char *previous = std::getenv("XDG_RUNTIME_DIR");
+  const std::string saved = previous != nullptr ? previous : "";
+
+  setenv("XDG_RUNTIME_DIR", "/run/user/1000", 1);
+  EXPECT_EQ(GetDefaultSocketPath(),
+            std::filesystem::path("/run/user/1000/terminal_animation.sock"));
+
+  // Without a runtime directory, not a socket shared by all users.
+  unsetenv("XDG_RUNTIME_DIR");
+  const std::filesystem::path fallback = GetDefaultSocketPath();
+  EXPECT_EQ(fallback.filename(), "terminal_animation.sock");
+  EXPECT_NE(fallback.parent_path(), std::filesystem::temp_directory_path());
+  EXPECT_EQ(fallback.parent_path().parent_path(),
+            std::filesystem::temp_directory_path());
+
+  if (previous != nullptr) {
+    setenv("XDG_RUNTIME_DIR", saved.c_str(), 1);
+  }
+}
+#endif
+
+TEST(ParseCommandLineTest, ParsesFileToOpenAtStart) {
+  const auto command_line =
+      ParseCommandLine({"--fps=12", "renders/frame_%05d.png"});
+  ASSERT_TRUE(command_line.has_value());
+  EXPECT_EQ(command_line->mode, CommandLine::Mode::kInteractive);
+  EXPECT_EQ(command_line->file, "renders/frame_%05d.png");
+  EXPECT_EQ(command_line->sequence_fps, 12U);
+
+  const auto defaults = ParseCommandLine({"clip.mp4"});
+  ASSERT_TRUE(defaults.has_value());
+  EXPECT_EQ(defaults->sequence_fps, kDefaultSequenceFramerate);
+}
+
+TEST(ParseCommandLineTest, ParsesEventRecording) {
+  const auto record = ParseCommandLine({"--record=session.events"});
+  ASSERT_TRUE(record.has_value());
+  EXPECT_EQ(record->record_file, "session.events");
+  EXPECT_TRUE(record->replay_file.empty());
+
+  const auto replay = ParseCommandLine({"--replay=session.events", "a.gif"});
+  ASSERT_TRUE(replay.has_value());
+  EXPECT_EQ(replay->mode, CommandLine::Mode::kInteractive);
+  EXPECT_EQ(replay->replay_file, "session.events");
+  EXPECT_EQ(replay->file, "a.gif");
+}
+
+TEST(ParseCommandLineTest, ParsesCharset) {
+  const auto builtin = ParseCommandLine({"--charset=binary"});
+  ASSERT_TRUE(builtin.has_value());
+  EXPECT_EQ(builtin->glyphs, ParseCharset("binary"));
+
+  const auto custom = ParseCommandLine({"--serve=a.mp4", "--charset=#=- "});
+  ASSERT_TRUE(custom.has_value());
+  EXPECT_EQ(custom->glyphs[0], '#');
+  EXPECT_EQ(custom->glyphs[255], ' ');
+
+  EXPECT_EQ(ParseCommandLine({})->glyphs, kDensityGlyphs);
+}
+
+TEST(ParseCommandLineTest, ParsesStabilizeThreshold) {
+  const auto player = ParseCommandLine({"--stabilize=12", "a.mp4"});
+  ASSERT_TRUE(player.has_value());
+  EXPECT_EQ(player->stabilize_threshold, 12);
+
+  const auto server = ParseCommandLine({"--serve=a.mp4", "--stabilize=255"});
+  ASSERT_TRUE(server.has_value());
+  EXPECT_EQ(server->stabilize_threshold, 255);
+
+  EXPECT_EQ(ParseCommandLine({})->stabilize_threshold, 0);
+}
+
+TEST(ParseCommandLineTest, ParsesThumbnailCacheSwitch) {
+  EXPECT_TRUE(ParseCommandLine({})->thumbnail_cache);
+  const auto disabled = ParseCommandLine({"--no-thumbnail-cache", "a.mp4"});
+  ASSERT_TRUE(disabled.has_value());
+  EXPECT_FALSE(disabled->thumbnail_cache);
+}
+
+TEST(ParseCommandLineTest, RejectsInvalidArguments) {
+  const std::vector<std::vector<std::string>> invalid = {
+      {"--bogus"},
+      {"--serve"},
+      {"--serve="},
+      {"--connect=yes"},
+      {"--connect", "--size=0"},
+      {"--connect", "--size=12abc"},
+      {"--serve=a.mp4", "--connect"},
+      // Options that do not apply to the mode.
+      {"--size=20"},
+      {"--socket=/tmp/feed.sock"},
+      {"--serve=a.mp4", "--monochrome"},
+      {"a.mp4", "b.mp4"},
+      {"--fps=0"},
+      {"--serve=a.mp4", "b.mp4"},
+      {"--connect", "--fps=30"},
+      {"--charset=x"},
+      {"--charset"},
+      {"--connect", "--charset=binary"},
+      {"--stabilize=0"},
+      {"--stabilize=256"},
+      {"--connect", "--stabilize=8"},
+      {"--no-thumbnail-cache=1"},
+      {"--serve=a.mp4", "--no-thumbnail-cache"},
+      {"--record="},
+      {"--record=a.events", "--replay=b.events"},
+      {"--serve=a.mp4", "--replay=b.events"},
+  };
+  for (const auto &args : invalid) {
+    EXPECT_FALSE(ParseCommandLine(args).has_value()) << args.front();
+  }
+}
+
+} // namespace
+} // namespace terminal_animation
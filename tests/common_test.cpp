@@ -1,7 +1,11 @@
 #include "common.hpp"
 
+#include <chrono>
+#include <cstdlib>
 #include <filesystem>
 #include <fstream>
+#include <string>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -46,6 +50,32 @@ TEST(MapValueTest, DensityArrayFullRange) {
   EXPECT_LT(mid, max_idx);
 }
 
+// --- ReciprocalDivider tests ---
+
+TEST(ReciprocalDividerTest, MatchesDivisionForBlockSums) {
+  // Every block size up to 64x64, and a few large ones.
+  std::vector<std::uint32_t> divisors;
+  for (std::uint32_t divisor = 1; divisor <= 4096; ++divisor) {
+    divisors.push_back(divisor);
+  }
+  divisors.insert(divisors.end(), {65535, 1U << 20, (1U << 24) - 1});
+
+  for (const std::uint32_t divisor : divisors) {
+    const ReciprocalDivider divide(divisor);
+    const std::uint64_t max = 255ULL * divisor;
+    const std::uint64_t step = std::max<std::uint64_t>(1, max / 997);
+    for (std::uint64_t dividend = 0; dividend <= max; dividend += step) {
+      ASSERT_EQ(divide(dividend), dividend / divisor)
+          << dividend << " / " << divisor;
+    }
+    for (std::uint64_t quotient = 1; quotient <= 255; ++quotient) {
+      // Just below and at each multiple, where rounding would show.
+      ASSERT_EQ(divide(quotient * divisor - 1), quotient - 1) << divisor;
+      ASSERT_EQ(divide(quotient * divisor), quotient) << divisor;
+    }
+  }
+}
+
 // --- kAsciiDensity tests ---
 
 TEST(AsciiDensityTest, StartsWithDenseChars) {
@@ -116,6 +146,247 @@ TEST(IsImageExtensionTest, HandlesPathWithDirectories) {
       IsImageExtension(std::filesystem::path("/home/user/pics/photo.jpg")));
 }
 
+// --- IsVideoExtension / IsMediaExtension tests ---
+
+TEST(IsVideoExtensionTest, RecognizesCommonContainers) {
+  EXPECT_TRUE(IsVideoExtension(std::filesystem::path("clip.mp4")));
+  EXPECT_TRUE(IsVideoExtension(std::filesystem::path("clip.MKV")));
+  EXPECT_TRUE(IsVideoExtension(std::filesystem::path("anim.gif")));
+}
+
+TEST(IsVideoExtensionTest, RejectsImages) {
+  EXPECT_FALSE(IsVideoExtension(std::filesystem::path("photo.jpg")));
+}
+
+TEST(IsMediaExtensionTest, AcceptsImagesAndVideos) {
+  EXPECT_TRUE(IsMediaExtension(std::filesystem::path("photo.png")));
+  EXPECT_TRUE(IsMediaExtension(std::filesystem::path("movie.webm")));
+}
+
+TEST(IsRawVideoExtensionTest, RecognizesUncompressedVideo) {
+  EXPECT_TRUE(IsRawVideoExtension(std::filesystem::path("clip.y4m")));
+  EXPECT_TRUE(IsRawVideoExtension(std::filesystem::path("clip_64x36.BGR")));
+  EXPECT_FALSE(IsRawVideoExtension(std::filesystem::path("clip.mp4")));
+  EXPECT_TRUE(IsMediaExtension(std::filesystem::path("clip_64x36.yuv")));
+}
+
+TEST(IsGifExtensionTest, RecognizesGifs) {
+  EXPECT_TRUE(IsGifExtension(std::filesystem::path("sticker.GIF")));
+  EXPECT_FALSE(IsGifExtension(std::filesystem::path("sticker.gif.mp4")));
+}
+
+TEST(IsMediaExtensionTest, RejectsOtherFiles) {
+  EXPECT_FALSE(IsMediaExtension(std::filesystem::path("notes.txt")));
+  EXPECT_FALSE(IsMediaExtension(std::filesystem::path("README")));
+}
+
+// --- ReadImageDimensions tests ---
+
+namespace {
+
+std::filesystem::path WriteBytes(const std::string &name,
+                                 const std::vector<unsigned char> &bytes) {
+  auto path = std::filesystem::temp_directory_path() / name;
+  std::ofstream f(path, std::ios::binary);
+  f.write(reinterpret_cast<const char *>(bytes.data()),
+          static_cast<std::streamsize>(bytes.size()));
+  return path;
+}
+
+} // namespace
+
+TEST(ReadImageDimensionsTest, ReadsPngHeader) {
+  auto path = WriteBytes(
+      "ta_test_dims.png",
+      {0x89, 'P',  'N',  'G',  '\r', '\n', 0x1A, '\n', 0x00,
+       0x00, 0x00, 0x0D, 'I',  'H',  'D',  'R',  0x00, 0x00,
+       0x0F, 0xA0, 0x00, 0x00, 0x0B, 0xB8, 0x08, 0x02});
+  auto dims = ReadImageDimensions(path);
+  ASSERT_TRUE(dims.has_value());
+  EXPECT_EQ(dims->width, 4000u);
+  EXPECT_EQ(dims->height, 3000u);
+  std::filesystem::remove(path);
+}
+
+TEST(ReadImageDimensionsTest, ReadsJpegStartOfFrame) {
+  // SOI, an APP0 segment to skip, then SOF0 with 3000x4000.
+  auto path = WriteBytes("ta_test_dims.jpg",
+                         {0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x04, 0x00, 0x00,
+                          0xFF, 0xC0, 0x00, 0x11, 0x08, 0x0F, 0xA0, 0x0B,
+                          0xB8, 0x03});
+  auto dims = ReadImageDimensions(path);
+  ASSERT_TRUE(dims.has_value());
+  EXPECT_EQ(dims->width, 3000u);
+  EXPECT_EQ(dims->height, 4000u);
+  std::filesystem::remove(path);
+}
+
+TEST(ReadImageDimensionsTest, ReadsTopDownBmpHeader) {
+  std::vector<unsigned char> bytes(26, 0);
+  bytes[0] = 'B';
+  bytes[1] = 'M';
+  bytes[18] = 0x40; // width 64
+  // height -32 (top-down)
+  bytes[22] = 0xE0;
+  bytes[23] = 0xFF;
+  bytes[24] = 0xFF;
+  bytes[25] = 0xFF;
+  auto path = WriteBytes("ta_test_dims.bmp", bytes);
+  auto dims = ReadImageDimensions(path);
+  ASSERT_TRUE(dims.has_value());
+  EXPECT_EQ(dims->width, 64u);
+  EXPECT_EQ(dims->height, 32u);
+  std::filesystem::remove(path);
+}
+
+TEST(ReadImageDimensionsTest, RejectsUnknownFormat) {
+  auto path = WriteBytes("ta_test_dims.txt",
+                         std::vector<unsigned char>(32, 'x'));
+  EXPECT_FALSE(ReadImageDimensions(path).has_value());
+  std::filesystem::remove(path);
+}
+
+TEST(ReadImageDimensionsTest, RejectsMissingFile) {
+  EXPECT_FALSE(
+      ReadImageDimensions(std::filesystem::path("/nonexistent_xyz.png"))
+          .has_value());
+}
+
+// --- ChooseImageReduction tests ---
+
+TEST(ChooseImageReductionTest, ReducesLargePhotoAtDefaultSize) {
+  EXPECT_EQ(ChooseImageReduction({.width = 4000, .height = 3000}, 32), 8u);
+}
+
+TEST(ChooseImageReductionTest, ReducesLessAtLargerSize) {
+  EXPECT_EQ(ChooseImageReduction({.width = 4000, .height = 3000}, 128), 4u);
+}
+
+TEST(ChooseImageReductionTest, KeepsSmallImagesAtFullResolution) {
+  EXPECT_EQ(ChooseImageReduction({.width = 320, .height = 240}, 64), 1u);
+}
+
+TEST(ChooseImageReductionTest, UsesShorterSideForPortraitImages) {
+  EXPECT_EQ(ChooseImageReduction({.width = 3000, .height = 4000}, 128), 4u);
+}
+
+// --- ZoomView tests ---
+
+TEST(ClampZoomViewTest, ClampsZoomLevel) {
+  EXPECT_EQ(ClampZoomView({.zoom = 0}).zoom, 1u);
+  EXPECT_EQ(ClampZoomView({.zoom = kMaxZoom * 2}).zoom, kMaxZoom);
+}
+
+TEST(ClampZoomViewTest, KeepsRegionInsideFrame) {
+  const ZoomView view =
+      ClampZoomView({.zoom = 4, .center_x = 0.0, .center_y = 1.0});
+  EXPECT_DOUBLE_EQ(view.center_x, 0.125);
+  EXPECT_DOUBLE_EQ(view.center_y, 0.875);
+}
+
+TEST(ComputeZoomCropTest, CoversWholeFrameWithoutZoom) {
+  EXPECT_EQ(ComputeZoomCrop(640, 480, {}),
+            (CropRect{.x = 0, .y = 0, .width = 640, .height = 480}));
+}
+
+TEST(ComputeZoomCropTest, CentersZoomedRegion) {
+  EXPECT_EQ(ComputeZoomCrop(640, 480, {.zoom = 2}),
+            (CropRect{.x = 160, .y = 120, .width = 320, .height = 240}));
+}
+
+TEST(ComputeZoomCropTest, PansToCorner) {
+  EXPECT_EQ(ComputeZoomCrop(640, 480,
+                            {.zoom = 4, .center_x = 1.0, .center_y = 0.0}),
+            (CropRect{.x = 480, .y = 0, .width = 160, .height = 120}));
+}
+
+TEST(ComputeZoomCropTest, HandlesTinyAndEmptyFrames) {
+  EXPECT_EQ(ComputeZoomCrop(3, 2, {.zoom = kMaxZoom}),
+            (CropRect{.x = 1, .y = 1, .width = 1, .height = 1}));
+  EXPECT_EQ(ComputeZoomCrop(0, 480, {.zoom = 2}), CropRect{});
+}
+
+// --- Mosaic layout tests ---
+
+TEST(ComputeMosaicGridTest, ReturnsEmptyGridForNoPanes) {
+  EXPECT_EQ(ComputeMosaicGrid(0), GridShape{});
+}
+
+TEST(ComputeMosaicGridTest, PrefersColumnsOverRows) {
+  EXPECT_EQ(ComputeMosaicGrid(1), (GridShape{.columns = 1, .rows = 1}));
+  EXPECT_EQ(ComputeMosaicGrid(2), (GridShape{.columns = 2, .rows = 1}));
+  EXPECT_EQ(ComputeMosaicGrid(3), (GridShape{.columns = 2, .rows = 2}));
+  EXPECT_EQ(ComputeMosaicGrid(5), (GridShape{.columns = 3, .rows = 2}));
+  EXPECT_EQ(ComputeMosaicGrid(9), (GridShape{.columns = 3, .rows = 3}));
+}
+
+TEST(ComputeGridGeometryTest, MatchesSizeForWideFrames) {
+  // A 16:9 frame at size 18 is 64 columns wide.
+  EXPECT_EQ(ComputeGridGeometry({.width = 1920, .height = 1080}, 18),
+            (GridGeometry{.block_width = 30,
+                          .block_height = 60,
+                          .columns = 64,
+                          .rows = 18}));
+}
+
+TEST(ComputeGridGeometryTest, RoundsNeighbouringSizesToTheSameGrid) {
+  const ImageDimensions frame{.width = 1920, .height = 1080};
+  const GridGeometry geometry = ComputeGridGeometry(frame, 121);
+  EXPECT_EQ(geometry.columns, 480u);
+  EXPECT_EQ(geometry.rows, 135u);
+  EXPECT_EQ(ComputeGridGeometry(frame, 135), geometry);
+  EXPECT_NE(ComputeGridGeometry(frame, 136), geometry);
+}
+
+TEST(ComputeGridGeometryTest, UsesSinglePixelsBeyondTheFrameSize) {
+  EXPECT_EQ(ComputeGridGeometry({.width = 40, .height = 30}, 500),
+            (GridGeometry{.block_width = 1,
+                          .block_height = 1,
+                          .columns = 40,
+                          .rows = 30}));
+  EXPECT_EQ(ComputeGridGeometry({}, 32), GridGeometry{});
+}
+
+TEST(FitPaneSizeTest, IsLimitedByCellHeightForNarrowFrames) {
+  EXPECT_EQ(FitPaneSize(100, 20, {.width = 480, .height = 640}), 20u);
+}
+
+TEST(FitPaneSizeTest, IsLimitedByCellWidthForWideFrames) {
+  // A 16:9 frame at size 18 is 64 columns wide.
+  EXPECT_EQ(FitPaneSize(64, 40, {.width = 1920, .height = 1080}), 18u);
+}
+
+TEST(FitPaneSizeTest, ReturnsLargestSizeWhoseGridFits) {
+  const ImageDimensions frames[] = {
+      {.width = 1920, .height = 1080},
+      {.width = 640, .height = 480},
+      {.width = 1080, .height = 1920},
+      {.width = 3840, .height = 1600},
+  };
+  for (const ImageDimensions &frame : frames) {
+    for (std::uint32_t columns = 20; columns <= 500; columns += 37) {
+      for (std::uint32_t rows = 10; rows <= 160; rows += 13) {
+        const std::uint32_t size = FitPaneSize(columns, rows, frame);
+        const GridGeometry fitted = ComputeGridGeometry(frame, size);
+        EXPECT_LE(fitted.columns, columns);
+        EXPECT_LE(fitted.rows, rows);
+        for (std::uint32_t larger = size + 1; larger <= size + 64;
+             ++larger) {
+          const GridGeometry geometry = ComputeGridGeometry(frame, larger);
+          EXPECT_TRUE(geometry.columns > columns || geometry.rows > rows)
+              << frame.width << "x" << frame.height << " in " << columns
+              << "x" << rows << ": size " << larger << " fits too";
+        }
+      }
+    }
+  }
+}
+
+TEST(FitPaneSizeTest, NeverReturnsZero) {
+  EXPECT_EQ(FitPaneSize(0, 0, {.width = 1920, .height = 1080}), 1u);
+  EXPECT_EQ(FitPaneSize(10, 0, {}), 1u);
+}
+
 // --- GetHomeDirectory tests ---
 
 TEST(GetHomeDirectoryTest, ReturnsExistingDirectory) {
@@ -124,6 +395,58 @@ TEST(GetHomeDirectoryTest, ReturnsExistingDirectory) {
   EXPECT_TRUE(std::filesystem::is_directory(home));
 }
 
+// --- GetCacheDirectory tests ---
+
+#ifndef _WIN32
+TEST(GetCacheDirectoryTest, HonorsXdgCacheHome) {
+  const char *previous = std::getenv("XDG_CACHE_HOME");
+  const std::string saved = previous != nullptr ? previous : "";
+
+  setenv("XDG_CACHE_HOME", "/tmp/ta_cache", 1);
+  EXPECT_EQ(GetCacheDirectory(),
+            std::filesystem::path("/tmp/ta_cache/terminal_animation"));
+
+  unsetenv("XDG_CACHE_HOME");
+  EXPECT_EQ(GetCacheDirectory(),
+            GetHomeDirectory() / ".cache" / "terminal_animation");
+
+  if (previous != nullptr) {
+    setenv("XDG_CACHE_HOME", saved.c_str(), 1);
+  }
+}
+#endif
+
+// --- TrimDirectory tests ---
+
+TEST(TrimDirectoryTest, DeletesTheOldestFiles) {
+  const auto dir =
+      std::filesystem::temp_directory_path() / "ta_test_trim_directory";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir / "subdirectory");
+  const auto now = std::filesystem::file_time_type::clock::now();
+  for (int i = 0; i < 5; ++i) {
+    const auto file = dir / (std::to_string(i) + ".thumb");
+    std::ofstream(file) << i;
+    std::filesystem::last_write_time(file, now - std::chrono::hours(10 - i));
+  }
+
+  EXPECT_EQ(TrimDirectory(dir, 5), 0U);
+  EXPECT_EQ(TrimDirectory(dir, 2), 3U);
+  EXPECT_FALSE(std::filesystem::exists(dir / "0.thumb"));
+  EXPECT_FALSE(std::filesystem::exists(dir / "2.thumb"));
+  EXPECT_TRUE(std::filesystem::exists(dir / "3.thumb"));
+  EXPECT_TRUE(std::filesystem::exists(dir / "4.thumb"));
+  // Only files are deleted.
+  EXPECT_TRUE(std::filesystem::exists(dir / "subdirectory"));
+
+  EXPECT_EQ(TrimDirectory(dir, 0), 2U);
+  std::filesystem::remove_all(dir);
+}
+
+TEST(TrimDirectoryTest, IgnoresMissingDirectory) {
+  EXPECT_EQ(TrimDirectory("/nonexistent_dir_xyz", 0), 0U);
+}
+
 // --- ListDirectoryEntries tests ---
 
 TEST(ListDirectoryEntriesTest, ReturnsEmptyForNonexistent) {
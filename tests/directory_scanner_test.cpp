@@ -0,0 +1,159 @@
+#include "directory_scanner.hpp"
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace terminal_animation {
+namespace {
+
+class DirectoryScannerTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    dir_ = std::filesystem::temp_directory_path() / "ta_scanner_test";
+    std::filesystem::remove_all(dir_);
+    std::filesystem::create_directories(dir_ / "subdir");
+    for (const char *name : {"clip.mp4", "photo.JPG", "notes.txt"}) {
+      std::ofstream(dir_ / name) << "x";
+    }
+  }
+
+  void TearDown() override { std::filesystem::remove_all(dir_); }
+
+  bool Contains(const DirectoryScanner &scanner, const std::string &name) {
+    for (std::size_t i = 0; i < scanner.Size(); ++i) {
+      if (scanner.At(i)->path.filename() == name) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::filesystem::path dir_;
+};
+
+TEST_F(DirectoryScannerTest, ListsAllEntriesAfterFixedOnes) {
+  DirectoryScanner scanner;
+  scanner.Scan(dir_, {{.path = "..", .is_directory = true}}, false);
+  scanner.Wait();
+
+  EXPECT_TRUE(scanner.IsComplete());
+  ASSERT_EQ(scanner.Size(), 5u);
+  EXPECT_EQ(scanner.At(0)->path, "..");
+  EXPECT_TRUE(Contains(scanner, "notes.txt"));
+}
+
+TEST_F(DirectoryScannerTest, UsesCachedDirectoryType) {
+  DirectoryScanner scanner;
+  scanner.Scan(dir_, {}, false);
+  scanner.Wait();
+
+  for (std::size_t i = 0; i < scanner.Size(); ++i) {
+    auto entry = scanner.At(i);
+    EXPECT_EQ(entry->is_directory, entry->path.filename() == "subdir");
+  }
+}
+
+TEST_F(DirectoryScannerTest, MediaOnlyKeepsDirectoriesAndMedia) {
+  DirectoryScanner scanner;
+  scanner.Scan(dir_, {}, true);
+  scanner.Wait();
+
+  EXPECT_EQ(scanner.Size(), 3u);
+  EXPECT_TRUE(Contains(scanner, "subdir"));
+  EXPECT_TRUE(Contains(scanner, "clip.mp4"));
+  EXPECT_TRUE(Contains(scanner, "photo.JPG"));
+  EXPECT_FALSE(Contains(scanner, "notes.txt"));
+}
+
+TEST_F(DirectoryScannerTest, StreamsLargeDirectoriesInBatches) {
+  const std::size_t count = DirectoryScanner::kBatchSize * 3 + 7;
+  for (std::size_t i = 0; i < count; ++i) {
+    std::ofstream(dir_ / ("f" + std::to_string(i) + ".png")) << "x";
+  }
+
+  std::atomic<int> updates{0};
+  DirectoryScanner scanner([&] { updates.fetch_add(1); });
+  scanner.Scan(dir_, {}, false);
+  scanner.Wait();
+
+  EXPECT_EQ(scanner.Size(), count + 4);
+  // Four batches plus the completion notification.
+  EXPECT_GE(updates.load(), 4);
+}
+
+TEST_F(DirectoryScannerTest, RescanReplacesEntries) {
+  DirectoryScanner scanner;
+  scanner.Scan(dir_, {}, false);
+  scanner.Scan(dir_ / "subdir", {{.path = "..", .is_directory = true}}, false);
+  scanner.Wait();
+
+  EXPECT_EQ(scanner.Size(), 1u);
+  EXPECT_FALSE(scanner.At(1).has_value());
+}
+
+TEST_F(DirectoryScannerTest, AppliesChangesWithoutRescanning) {
+  DirectoryScanner scanner;
+  scanner.Scan(dir_, {{.path = "..", .is_directory = true}}, false);
+  scanner.Wait();
+  const auto clip_index = scanner.IndexOf(dir_ / "clip.mp4");
+  ASSERT_TRUE(clip_index.has_value());
+
+  scanner.ApplyChanges(
+      {
+          {.type = DirectoryChange::Type::kAdded, .path = dir_ / "new.gif"},
+          {.type = DirectoryChange::Type::kRemoved,
+           .path = dir_ / "notes.txt"},
+          {.type = DirectoryChange::Type::kRenamed,
+           .path = dir_ / "movie.mp4",
+           .old_path = dir_ / "clip.mp4"},
+          // Already listed, must not be duplicated.
+          {.type = DirectoryChange::Type::kAdded, .path = dir_ / "photo.JPG"},
+      },
+      false);
+
+  EXPECT_EQ(scanner.Size(), 5u);
+  EXPECT_TRUE(Contains(scanner, "new.gif"));
+  EXPECT_FALSE(Contains(scanner, "notes.txt"));
+  EXPECT_FALSE(Contains(scanner, "clip.mp4"));
+  // Renamed entries keep their position unless earlier ones were removed.
+  const auto movie_index = scanner.IndexOf(dir_ / "movie.mp4");
+  ASSERT_TRUE(movie_index.has_value());
+  EXPECT_LE(*movie_index, *clip_index);
+  EXPECT_EQ(scanner.At(0)->path, "..");
+}
+
+TEST_F(DirectoryScannerTest, AppliedChangesRespectMediaFilter) {
+  DirectoryScanner scanner;
+  scanner.Scan(dir_, {}, true);
+  scanner.Wait();
+
+  scanner.ApplyChanges(
+      {
+          {.type = DirectoryChange::Type::kAdded, .path = dir_ / "todo.txt"},
+          {.type = DirectoryChange::Type::kRenamed,
+           .path = dir_ / "clip.bak",
+           .old_path = dir_ / "clip.mp4"},
+      },
+      true);
+
+  EXPECT_FALSE(Contains(scanner, "todo.txt"));
+  EXPECT_FALSE(Contains(scanner, "clip.bak"));
+  EXPECT_FALSE(Contains(scanner, "clip.mp4"));
+  EXPECT_EQ(scanner.Size(), 2u);
+}
+
+TEST_F(DirectoryScannerTest, MissingDirectoryCompletesEmpty) {
+  DirectoryScanner scanner;
+  scanner.Scan(dir_ / "missing", {}, false);
+  scanner.Wait();
+
+  EXPECT_TRUE(scanner.IsComplete());
+  EXPECT_EQ(scanner.Size(), 0u);
+}
+
+} // namespace
+} // namespace terminal_animation
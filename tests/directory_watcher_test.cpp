@@ -0,0 +1,130 @@
+#include "directory_watcher.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace terminal_animation {
+namespace {
+
+using namespace std::chrono_literals;
+
+class DirectoryWatcherTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    dir_ = std::filesystem::temp_directory_path() / "ta_watcher_test";
+    std::filesystem::remove_all(dir_);
+    std::filesystem::create_directories(dir_);
+  }
+
+  void TearDown() override { std::filesystem::remove_all(dir_); }
+
+  DirectoryWatcher::Callback Collect() {
+    return [this](const std::filesystem::path &,
+                  const std::vector<DirectoryChange> &changes) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      changes_.insert(changes_.end(), changes.begin(), changes.end());
+      cv_.notify_all();
+    };
+  }
+
+  // Waits until a change of the given type for the given file arrives.
+  bool WaitFor(DirectoryChange::Type type, const std::string &name) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, 5s, [&] {
+      for (const auto &change : changes_) {
+        if (change.type == type && change.path.filename() == name) {
+          return true;
+        }
+      }
+      return false;
+    });
+  }
+
+  std::filesystem::path dir_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<DirectoryChange> changes_;
+};
+
+#ifdef __linux__
+TEST_F(DirectoryWatcherTest, ReportsAddRenameRemoveWithInotify) {
+  DirectoryWatcher watcher(Collect());
+  watcher.Watch(dir_);
+
+  std::ofstream(dir_ / "new.mp4") << "x";
+  EXPECT_TRUE(WaitFor(DirectoryChange::Type::kAdded, "new.mp4"));
+
+  std::filesystem::rename(dir_ / "new.mp4", dir_ / "renamed.mp4");
+  EXPECT_TRUE(WaitFor(DirectoryChange::Type::kRenamed, "renamed.mp4"));
+  EXPECT_TRUE(watcher.IsEventDriven());
+
+  std::filesystem::remove(dir_ / "renamed.mp4");
+  EXPECT_TRUE(WaitFor(DirectoryChange::Type::kRemoved, "renamed.mp4"));
+}
+
+TEST_F(DirectoryWatcherTest, ReportsRemovedDirectoryWithInotify) {
+  DirectoryWatcher watcher(Collect());
+  watcher.Watch(dir_);
+  ASSERT_TRUE(watcher.IsEventDriven());
+
+  std::ofstream(dir_ / "inside.mp4") << "x";
+  std::filesystem::remove_all(dir_);
+  EXPECT_TRUE(
+      WaitFor(DirectoryChange::Type::kGone, dir_.filename().string()));
+}
+
+TEST_F(DirectoryWatcherTest, ReportsMovedDirectoryWithInotify) {
+  const auto moved = dir_.string() + "_moved";
+  std::filesystem::remove_all(moved);
+  DirectoryWatcher watcher(Collect());
+  watcher.Watch(dir_);
+
+  std::filesystem::rename(dir_, moved);
+  EXPECT_TRUE(
+      WaitFor(DirectoryChange::Type::kGone, dir_.filename().string()));
+  std::filesystem::remove_all(moved);
+}
+#endif
+
+TEST_F(DirectoryWatcherTest, PollingFallbackReportsRemovedDirectory) {
+  DirectoryWatcher watcher(Collect(), 20ms, true);
+  watcher.Watch(dir_);
+  std::this_thread::sleep_for(50ms);
+
+  std::filesystem::remove_all(dir_);
+  EXPECT_TRUE(
+      WaitFor(DirectoryChange::Type::kGone, dir_.filename().string()));
+}
+
+TEST_F(DirectoryWatcherTest, PollingFallbackReportsAddAndRemove) {
+  DirectoryWatcher watcher(Collect(), 20ms, true);
+  watcher.Watch(dir_);
+  std::this_thread::sleep_for(50ms);
+
+  std::ofstream(dir_ / "polled.png") << "x";
+  EXPECT_TRUE(WaitFor(DirectoryChange::Type::kAdded, "polled.png"));
+  EXPECT_FALSE(watcher.IsEventDriven());
+
+  std::filesystem::remove(dir_ / "polled.png");
+  EXPECT_TRUE(WaitFor(DirectoryChange::Type::kRemoved, "polled.png"));
+}
+
+TEST_F(DirectoryWatcherTest, StopsPromptly) {
+  DirectoryWatcher watcher(Collect(), 10s, true);
+  watcher.Watch(dir_);
+
+  const auto start = std::chrono::steady_clock::now();
+  watcher.Stop();
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 1s);
+}
+
+} // namespace
+} // namespace terminal_animation
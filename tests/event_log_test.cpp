@@ -0,0 +1,117 @@
+#include "event_log.hpp"
+
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace terminal_animation {
+namespace {
+
+using std::chrono::microseconds;
+
+TEST(RecordedEventTest, RoundTripsEveryKind) {
+  const std::vector<RecordedEvent> events = {
+      {.time = microseconds(0),
+       .kind = RecordedEvent::Kind::kCharacter,
+       .input = "q",
+       .mouse = {}},
+      {.time = microseconds(1500),
+       .kind = RecordedEvent::Kind::kSpecial,
+       .input = "\x1b[A",
+       .mouse = {}},
+      {.time = microseconds(2000),
+       .kind = RecordedEvent::Kind::kCharacter,
+       .input = " ",
+       .mouse = {}},
+      {.time = microseconds(123456789),
+       .kind = RecordedEvent::Kind::kMouse,
+       .input = "\x1b[<0;12;7M",
+       .mouse = {.button = 0,
+                 .motion = 1,
+                 .shift = false,
+                 .meta = true,
+                 .control = false,
+                 .x = 11,
+                 .y = 6}},
+      {.time = microseconds(5),
+       .kind = RecordedEvent::Kind::kSpecial,
+       .input = "",
+       .mouse = {}},
+  };
+  for (const RecordedEvent &event : events) {
+    const std::string line = FormatRecordedEvent(event);
+    EXPECT_EQ(line.find_first_of("\x1b\n\r"), std::string::npos) << line;
+    EXPECT_EQ(ParseRecordedEvent(line), event) << line;
+  }
+}
+
+TEST(RecordedEventTest, RejectsMalformedLines) {
+  const std::vector<std::string> invalid = {
+      "",
+      "10 c",
+      "10 x 71",
+      "-1 c 71",
+      "abc c 71",
+      "10 c 7",
+      "10 c zz",
+      "10 c 71 extra",
+      "10 m 1b 0 0 0 0 0 1",
+      "10 m 1b 0 0 0 0 0 1 y",
+      "10  c 71",
+  };
+  for (const std::string &line : invalid) {
+    EXPECT_FALSE(ParseRecordedEvent(line).has_value()) << line;
+  }
+}
+
+TEST(EventLogTest, ReadsHeaderAndEvents) {
+  std::stringstream log;
+  log << FormatEventLogHeader(120, 40) << '\n';
+  log << "0 c 71\n\n";
+  log << "2500 s 1b5b42\n";
+
+  const auto parsed = ReadEventLog(log);
+  ASSERT_TRUE(parsed.has_value());
+  EXPECT_EQ(parsed->columns, 120U);
+  EXPECT_EQ(parsed->rows, 40U);
+  ASSERT_EQ(parsed->events.size(), 2U);
+  EXPECT_EQ(parsed->events[0].input, "q");
+  EXPECT_EQ(parsed->events[1].time, microseconds(2500));
+  EXPECT_EQ(parsed->events[1].input, "\x1b[B");
+}
+
+TEST(EventLogTest, RejectsBadLogs) {
+  const std::vector<std::string> invalid = {
+      "",
+      "something else 1 80 24\n",
+      "terminal_animation-events 2 80 24\n",
+      "terminal_animation-events 1 0 24\n",
+      // Events must be in order.
+      "terminal_animation-events 1 80 24\n20 c 71\n10 c 71\n",
+      "terminal_animation-events 1 80 24\n20 c\n",
+  };
+  for (const std::string &text : invalid) {
+    std::istringstream in(text);
+    EXPECT_FALSE(ReadEventLog(in).has_value()) << text;
+  }
+}
+
+TEST(SummarizeLatenciesTest, ReportsPercentiles) {
+  std::vector<std::chrono::nanoseconds> samples;
+  for (int i = 100; i >= 1; --i) {
+    samples.push_back(microseconds(i));
+  }
+  const LatencySummary summary = SummarizeLatencies(samples);
+  EXPECT_DOUBLE_EQ(summary.p50_us, 51.0);
+  EXPECT_DOUBLE_EQ(summary.p95_us, 95.0);
+  EXPECT_DOUBLE_EQ(summary.max_us, 100.0);
+
+  const LatencySummary empty = SummarizeLatencies({});
+  EXPECT_DOUBLE_EQ(empty.max_us, 0.0);
+}
+
+} // namespace
+} // namespace terminal_animation
@@ -0,0 +1,132 @@
+#include "frame_protocol.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace terminal_animation {
+namespace {
+
+CharsAndColors MakeFrame(std::uint32_t columns, std::uint32_t rows,
+                         bool with_colors) {
+  CharsAndColors frame;
+  frame.columns = columns;
+  frame.rows = rows;
+  for (std::uint32_t cell = 0; cell < columns * rows; ++cell) {
+    frame.chars.push_back(static_cast<char>('a' + cell % 26));
+    if (with_colors) {
+      frame.colors.push_back({static_cast<std::uint8_t>(cell),
+                              static_cast<std::uint8_t>(255 - cell),
+                              static_cast<std::uint8_t>(cell * 7)});
+    }
+  }
+  return frame;
+}
+
+// Feeds encoded bytes through a reader and returns the single message.
+Message ReadBack(const std::vector<char> &bytes) {
+  MessageReader reader;
+  reader.Append(bytes.data(), bytes.size());
+  Message message;
+  EXPECT_TRUE(reader.Next(message));
+  EXPECT_FALSE(reader.Next(message));
+  return message;
+}
+
+TEST(FrameProtocolTest, HelloRoundTrips) {
+  std::vector<char> bytes;
+  EncodeHello({.size = 48, .color_depth = ColorDepth::kMonochrome}, bytes);
+  const Message message = ReadBack(bytes);
+  ASSERT_EQ(message.type, MessageType::kHello);
+
+  const auto params = DecodeHello(message.payload);
+  ASSERT_TRUE(params.has_value());
+  EXPECT_EQ(params->size, 48U);
+  EXPECT_EQ(params->color_depth, ColorDepth::kMonochrome);
+}
+
+TEST(FrameProtocolTest, ColorFrameRoundTrips) {
+  const CharsAndColors frame = MakeFrame(7, 3, true);
+  std::vector<char> bytes;
+  EncodeFrame(42, frame, bytes);
+  const Message message = ReadBack(bytes);
+  ASSERT_EQ(message.type, MessageType::kFrame);
+
+  std::uint32_t index = 0;
+  CharsAndColors decoded;
+  ASSERT_TRUE(DecodeFrame(message.payload, index, decoded));
+  EXPECT_EQ(index, 42U);
+  EXPECT_EQ(decoded.columns, 7U);
+  EXPECT_EQ(decoded.rows, 3U);
+  EXPECT_EQ(decoded.chars, frame.chars);
+  EXPECT_EQ(decoded.colors, frame.colors);
+}
+
+TEST(FrameProtocolTest, MonochromeFrameCarriesNoColors) {
+  const CharsAndColors frame = MakeFrame(10, 4, false);
+  std::vector<char> color_bytes;
+  EncodeFrame(0, MakeFrame(10, 4, true), color_bytes);
+  std::vector<char> bytes;
+  EncodeFrame(0, frame, bytes);
+  EXPECT_EQ(bytes.size() + 3 * 40, color_bytes.size());
+
+  std::uint32_t index = 0;
+  CharsAndColors decoded = MakeFrame(2, 2, true);
+  ASSERT_TRUE(DecodeFrame(ReadBack(bytes).payload, index, decoded));
+  EXPECT_EQ(decoded.chars, frame.chars);
+  EXPECT_TRUE(decoded.colors.empty());
+}
+
+TEST(FrameProtocolTest, ReaderReassemblesChunkedMessages) {
+  std::vector<char> stream;
+  std::vector<char> bytes;
+  for (std::uint32_t index = 0; index < 3; ++index) {
+    EncodeFrame(index, MakeFrame(5 + index, 2, index % 2 == 0), bytes);
+    stream.insert(stream.end(), bytes.begin(), bytes.end());
+  }
+
+  MessageReader reader;
+  Message message;
+  std::vector<std::uint32_t> indices;
+  // Three bytes at a time splits headers and payloads alike.
+  for (std::size_t offset = 0; offset < stream.size(); offset += 3) {
+    reader.Append(stream.data() + offset,
+                  std::min<std::size_t>(3, stream.size() - offset));
+    while (reader.Next(message)) {
+      std::uint32_t index = 0;
+      CharsAndColors frame;
+      ASSERT_TRUE(DecodeFrame(message.payload, index, frame));
+      EXPECT_EQ(frame.columns, 5 + index);
+      indices.push_back(index);
+    }
+  }
+  EXPECT_EQ(indices, (std::vector<std::uint32_t>{0, 1, 2}));
+  EXPECT_FALSE(reader.HasError());
+}
+
+TEST(FrameProtocolTest, RejectsMalformedInput) {
+  MessageReader reader;
+  // Unknown message type 0x7f.
+  const std::vector<char> garbage = {'\x7f', '\x01', '\x00', '\x00', '\x00',
+                                     'x'};
+  reader.Append(garbage.data(), garbage.size());
+  Message message;
+  EXPECT_FALSE(reader.Next(message));
+  EXPECT_TRUE(reader.HasError());
+
+  // A frame whose payload is shorter than its dimensions promise.
+  std::vector<char> bytes;
+  EncodeFrame(1, MakeFrame(4, 4, true), bytes);
+  Message frame = ReadBack(bytes);
+  frame.payload.pop_back();
+  std::uint32_t index = 0;
+  CharsAndColors decoded;
+  EXPECT_FALSE(DecodeFrame(frame.payload, index, decoded));
+
+  EXPECT_FALSE(DecodeHello({'\x01', '\x00', '\x00', '\x00', '\x09'}));
+}
+
+} // namespace
+} // namespace terminal_animation
@@ -0,0 +1,115 @@
+#include "frame_scheduler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace terminal_animation {
+namespace {
+
+using namespace std::chrono_literals;
+
+// Polls until condition() holds or a generous timeout expires.
+template <typename Condition> bool WaitUntil(Condition condition) {
+  const auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (!condition()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(1ms);
+  }
+  return true;
+}
+
+TEST(FrameSchedulerTest, RunsStepsUntilClientIsDone) {
+  TaskScheduler tasks({.worker_count = 2});
+  FrameScheduler scheduler(tasks);
+  std::atomic<int> steps{0};
+  scheduler.Add([&steps] { return ++steps < 10; });
+
+  ASSERT_TRUE(WaitUntil([&] { return steps.load() == 10; }));
+  std::this_thread::sleep_for(20ms);
+  EXPECT_EQ(steps.load(), 10);
+}
+
+TEST(FrameSchedulerTest, WakeRunsDoneClientAgain) {
+  TaskScheduler tasks({.worker_count = 1});
+  FrameScheduler scheduler(tasks);
+  std::atomic<int> steps{0};
+  const auto id = scheduler.Add([&steps] {
+    ++steps;
+    return false;
+  });
+  ASSERT_TRUE(WaitUntil([&] { return steps.load() == 1; }));
+
+  scheduler.Wake(id);
+  EXPECT_TRUE(WaitUntil([&] { return steps.load() == 2; }));
+}
+
+TEST(FrameSchedulerTest, SharesWorkerFairlyBetweenClients) {
+  TaskScheduler tasks({.worker_count = 1});
+  FrameScheduler scheduler(tasks);
+  std::atomic<bool> stop{false};
+  std::atomic<int> fast_steps{0};
+  std::atomic<int> slow_steps{0};
+  // With one worker and round-robin order the clients alternate, however
+  // long each step takes.
+  const auto fast = scheduler.Add([&] {
+    ++fast_steps;
+    return !stop.load();
+  });
+  const auto slow = scheduler.Add([&] {
+    ++slow_steps;
+    std::this_thread::sleep_for(1ms);
+    return !stop.load();
+  });
+
+  ASSERT_TRUE(WaitUntil([&] { return slow_steps.load() >= 20; }));
+  stop.store(true);
+  scheduler.Remove(fast);
+  scheduler.Remove(slow);
+  EXPECT_LE(std::abs(fast_steps.load() - slow_steps.load()), 1);
+}
+
+TEST(FrameSchedulerTest, RemoveWaitsForRunningStep) {
+  TaskScheduler tasks({.worker_count = 1});
+  FrameScheduler scheduler(tasks);
+  std::atomic<bool> started{false};
+  std::atomic<bool> finished{false};
+  const auto id = scheduler.Add([&] {
+    started.store(true);
+    std::this_thread::sleep_for(50ms);
+    finished.store(true);
+    return false;
+  });
+
+  ASSERT_TRUE(WaitUntil([&] { return started.load(); }));
+  scheduler.Remove(id);
+  EXPECT_TRUE(finished.load());
+}
+
+TEST(FrameSchedulerTest, NeverRunsClientOnTwoWorkers) {
+  TaskScheduler tasks({.worker_count = 4});
+  FrameScheduler scheduler(tasks);
+  std::atomic<int> concurrent{0};
+  std::atomic<int> max_concurrent{0};
+  std::atomic<int> steps{0};
+  const auto id = scheduler.Add([&] {
+    const int now = ++concurrent;
+    max_concurrent.store(std::max(max_concurrent.load(), now));
+    std::this_thread::sleep_for(100us);
+    --concurrent;
+    return ++steps < 200;
+  });
+
+  ASSERT_TRUE(WaitUntil([&] { return steps.load() >= 200; }));
+  scheduler.Remove(id);
+  EXPECT_EQ(max_concurrent.load(), 1);
+}
+
+} // namespace
+} // namespace terminal_animation
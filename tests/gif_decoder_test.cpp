@@ -0,0 +1,285 @@
+#include "gif_decoder.hpp"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace terminal_animation {
+namespace {
+
+using Bytes = std::vector<std::uint8_t>;
+
+// Packs codes least significant bit first, as GIF does.
+Bytes PackCodes(const std::vector<std::uint32_t> &codes,
+                std::uint32_t code_size) {
+  Bytes bytes;
+  std::uint32_t bits = 0;
+  std::uint32_t bit_count = 0;
+  for (const std::uint32_t code : codes) {
+    bits |= code << bit_count;
+    bit_count += code_size;
+    while (bit_count >= 8) {
+      bytes.push_back(static_cast<std::uint8_t>(bits));
+      bits >>= 8;
+      bit_count -= 8;
+    }
+  }
+  if (bit_count > 0) {
+    bytes.push_back(static_cast<std::uint8_t>(bits));
+  }
+  return bytes;
+}
+
+// Compresses indices without ever growing the code size: a clear code
+// before every pair of literals keeps the table from filling up.
+Bytes CompressIndices(const Bytes &indices) {
+  constexpr std::uint32_t kClear = 8;
+  std::vector<std::uint32_t> codes;
+  for (std::size_t i = 0; i < indices.size(); ++i) {
+    if (i % 2 == 0) {
+      codes.push_back(kClear);
+    }
+    codes.push_back(indices[i]);
+  }
+  codes.push_back(kClear + 1);
+  return PackCodes(codes, 4);
+}
+
+struct TestFrame {
+  std::uint16_t left = 0;
+  std::uint16_t top = 0;
+  std::uint16_t width = 0;
+  std::uint16_t height = 0;
+  Bytes indices;
+  std::uint16_t delay_cs = 0;
+  std::uint8_t disposal = 0;
+  std::optional<std::uint8_t> transparent = std::nullopt;
+  bool interlaced = false;
+};
+
+// Palette entry i is (10 * i, 20 * i, 30 * i).
+std::array<std::uint8_t, 3> Color(std::uint8_t index) {
+  return {static_cast<std::uint8_t>(10 * index),
+          static_cast<std::uint8_t>(20 * index),
+          static_cast<std::uint8_t>(30 * index)};
+}
+
+void PutWord(Bytes &out, std::uint16_t value) {
+  out.push_back(static_cast<std::uint8_t>(value));
+  out.push_back(static_cast<std::uint8_t>(value >> 8));
+}
+
+// Builds a GIF89a with an 8-color global palette.
+Bytes MakeGif(std::uint16_t width, std::uint16_t height,
+              const std::vector<TestFrame> &frames) {
+  Bytes gif = {'G', 'I', 'F', '8', '9', 'a'};
+  PutWord(gif, width);
+  PutWord(gif, height);
+  gif.insert(gif.end(), {0x82, 0, 0});
+  for (std::uint8_t i = 0; i < 8; ++i) {
+    const auto color = Color(i);
+    gif.insert(gif.end(), color.begin(), color.end());
+  }
+
+  for (const TestFrame &frame : frames) {
+    gif.insert(gif.end(), {0x21, 0xF9, 4});
+    gif.push_back(static_cast<std::uint8_t>(frame.disposal << 2 |
+                                            (frame.transparent ? 1 : 0)));
+    PutWord(gif, frame.delay_cs);
+    gif.push_back(frame.transparent.value_or(0));
+    gif.push_back(0);
+
+    gif.push_back(0x2C);
+    PutWord(gif, frame.left);
+    PutWord(gif, frame.top);
+    PutWord(gif, frame.width);
+    PutWord(gif, frame.height);
+    gif.push_back(frame.interlaced ? 0x40 : 0);
+    gif.push_back(3);
+    const Bytes data = CompressIndices(frame.indices);
+    for (std::size_t offset = 0; offset < data.size(); offset += 255) {
+      const std::size_t size = std::min<std::size_t>(255, data.size() - offset);
+      gif.push_back(static_cast<std::uint8_t>(size));
+      gif.insert(gif.end(), data.begin() + offset,
+                 data.begin() + offset + size);
+    }
+    gif.push_back(0);
+  }
+  gif.push_back(0x3B);
+  return gif;
+}
+
+// Returns the palette index whose BGR color is at pixel (x, y), or -1.
+int IndexAt(const std::uint8_t *frame, std::uint32_t width, std::uint32_t x,
+            std::uint32_t y) {
+  const std::uint8_t *pixel = frame + 3 * (y * width + x);
+  for (std::uint8_t i = 0; i < 8; ++i) {
+    const auto color = Color(i);
+    if (pixel[0] == color[2] && pixel[1] == color[1] &&
+        pixel[2] == color[0]) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+TEST(DecodeGifLzwTest, DecodesLiteralsAndNewCodes) {
+  // Clear, 0, then code 6, which is being defined: "0" + "0".
+  EXPECT_EQ(DecodeGifLzw(PackCodes({4, 0, 6, 5}, 3), 2, 3),
+            (Bytes{0, 0, 0}));
+  // 1, 2, then code 6 = "1 2".
+  EXPECT_EQ(DecodeGifLzw(PackCodes({4, 1, 2, 6, 5}, 3), 2, 4),
+            (Bytes{1, 2, 1, 2}));
+}
+
+TEST(DecodeGifLzwTest, PadsDamagedData) {
+  EXPECT_EQ(DecodeGifLzw(CompressIndices({3, 1}), 3, 4),
+            (Bytes{3, 1, 0, 0}));
+  // A code past the table ends decoding.
+  EXPECT_EQ(DecodeGifLzw(PackCodes({4, 1, 7}, 3), 2, 2), (Bytes{1, 0}));
+  EXPECT_EQ(DecodeGifLzw({}, 9, 2), (Bytes{0, 0}));
+}
+
+TEST(GifDecoderTest, ReadsFramesAndDelays) {
+  GifDecoder decoder;
+  ASSERT_TRUE(decoder.Load(MakeGif(
+      2, 2,
+      {{.width = 2, .height = 2, .indices = {1, 2, 3, 4}, .delay_cs = 5},
+       {.left = 1,
+        .top = 1,
+        .width = 1,
+        .height = 1,
+        .indices = {5},
+        .delay_cs = 1}})));
+  EXPECT_EQ(decoder.GetWidth(), 2u);
+  EXPECT_EQ(decoder.GetHeight(), 2u);
+  ASSERT_EQ(decoder.GetFrameCount(), 2u);
+  EXPECT_EQ(decoder.GetFrameDelay(0), 50u);
+  EXPECT_EQ(decoder.GetFrameDelay(1), kDefaultGifDelayMs);
+  EXPECT_EQ(decoder.GetTotalDelay(), 50u + kDefaultGifDelayMs);
+
+  const std::uint8_t *first = decoder.DecodeFrame(0);
+  ASSERT_NE(first, nullptr);
+  EXPECT_EQ(IndexAt(first, 2, 0, 0), 1);
+  EXPECT_EQ(IndexAt(first, 2, 1, 1), 4);
+
+  // The second frame only covers one pixel.
+  const std::uint8_t *second = decoder.DecodeFrame(1);
+  EXPECT_EQ(IndexAt(second, 2, 0, 0), 1);
+  EXPECT_EQ(IndexAt(second, 2, 1, 1), 5);
+  EXPECT_EQ(decoder.DecodeFrame(2), nullptr);
+
+  // Going back gives the same frame again.
+  EXPECT_EQ(IndexAt(decoder.DecodeFrame(0), 2, 1, 1), 4);
+}
+
+TEST(GifDecoderTest, AppliesTransparencyAndDisposal) {
+  GifDecoder decoder;
+  ASSERT_TRUE(decoder.Load(MakeGif(
+      2, 1,
+      {{.width = 2, .height = 1, .indices = {1, 1}},
+       // Transparent index 7 keeps the pixel below.
+       {.width = 2,
+        .height = 1,
+        .indices = {2, 7},
+        .disposal = 3,
+        .transparent = 7},
+       // Drawn after restoring the canvas from before frame 1.
+       {.left = 1, .width = 1, .height = 1, .indices = {3}, .disposal = 2},
+       // Drawn after clearing frame 2's pixel to black.
+       {.width = 1, .height = 1, .indices = {4}}})));
+
+  EXPECT_EQ(IndexAt(decoder.DecodeFrame(1), 2, 0, 0), 2);
+  EXPECT_EQ(IndexAt(decoder.DecodeFrame(1), 2, 1, 0), 1);
+  const std::uint8_t *restored = decoder.DecodeFrame(2);
+  EXPECT_EQ(IndexAt(restored, 2, 0, 0), 1);
+  EXPECT_EQ(IndexAt(restored, 2, 1, 0), 3);
+  const std::uint8_t *cleared = decoder.DecodeFrame(3);
+  EXPECT_EQ(IndexAt(cleared, 2, 0, 0), 4);
+  EXPECT_EQ(IndexAt(cleared, 2, 1, 0), 0);
+}
+
+TEST(GifDecoderTest, DeinterlacesRows) {
+  GifDecoder decoder;
+  ASSERT_TRUE(decoder.Load(MakeGif(
+      1, 5,
+      {{.width = 1,
+        .height = 5,
+        .indices = {1, 2, 3, 4, 5},
+        .interlaced = true}})));
+  // Stored in the order of rows 0, 4, 2, 1, 3.
+  const std::uint8_t *frame = decoder.DecodeFrame(0);
+  EXPECT_EQ(IndexAt(frame, 1, 0, 0), 1);
+  EXPECT_EQ(IndexAt(frame, 1, 0, 1), 4);
+  EXPECT_EQ(IndexAt(frame, 1, 0, 2), 3);
+  EXPECT_EQ(IndexAt(frame, 1, 0, 3), 5);
+  EXPECT_EQ(IndexAt(frame, 1, 0, 4), 2);
+}
+
+TEST(GifDecoderTest, ClipsFramesToTheScreen) {
+  GifDecoder decoder;
+  ASSERT_TRUE(decoder.Load(MakeGif(
+      2, 2,
+      {{.width = 3, .height = 3, .indices = {1, 2, 3, 4, 5, 6, 7, 1, 2}},
+       {.left = 1,
+        .top = 1,
+        .width = 2,
+        .height = 3,
+        .indices = {3, 4, 5, 6, 7, 1},
+        .interlaced = true}})));
+  const std::uint8_t *first = decoder.DecodeFrame(0);
+  EXPECT_EQ(IndexAt(first, 2, 0, 0), 1);
+  EXPECT_EQ(IndexAt(first, 2, 1, 0), 2);
+  EXPECT_EQ(IndexAt(first, 2, 0, 1), 4);
+  EXPECT_EQ(IndexAt(first, 2, 1, 1), 5);
+  // Only the first stored row of the second frame is on the screen.
+  const std::uint8_t *second = decoder.DecodeFrame(1);
+  EXPECT_EQ(IndexAt(second, 2, 0, 1), 4);
+  EXPECT_EQ(IndexAt(second, 2, 1, 1), 3);
+}
+
+TEST(GifDecoderTest, SkipsFramesOffTheScreen) {
+  GifDecoder decoder;
+  ASSERT_TRUE(decoder.Load(MakeGif(
+      2, 2,
+      {{.width = 2, .height = 2, .indices = {1, 2, 3, 4}, .delay_cs = 5},
+       {.left = 2, .width = 1, .height = 1, .indices = {5}, .delay_cs = 7},
+       {.top = 9, .width = 1, .height = 1, .indices = {6}, .delay_cs = 8},
+       {.width = 1, .height = 1, .indices = {7}, .delay_cs = 10}})));
+  ASSERT_EQ(decoder.GetFrameCount(), 2u);
+  // The first frame stays up while the skipped ones would have shown.
+  EXPECT_EQ(decoder.GetFrameDelay(0), 200u);
+  EXPECT_EQ(decoder.GetFrameDelay(1), 100u);
+  EXPECT_EQ(decoder.GetTotalDelay(), 300u);
+  EXPECT_EQ(IndexAt(decoder.DecodeFrame(1), 2, 0, 0), 7);
+
+  // Without a frame on the screen there is nothing to play.
+  EXPECT_FALSE(decoder.Load(MakeGif(
+      2, 2, {{.left = 3, .width = 1, .height = 1, .indices = {1}}})));
+}
+
+TEST(GifDecoderTest, RejectsHugeScreens) {
+  GifDecoder decoder;
+  EXPECT_FALSE(decoder.Load(MakeGif(
+      65535, 65535, {{.width = 1, .height = 1, .indices = {1}}})));
+  EXPECT_FALSE(decoder.IsOpen());
+  EXPECT_TRUE(decoder.Load(
+      MakeGif(4096, 4096, {{.width = 1, .height = 1, .indices = {1}}})));
+}
+
+TEST(GifDecoderTest, RejectsFilesWithoutFrames) {
+  GifDecoder decoder;
+  EXPECT_FALSE(decoder.Load(Bytes{'P', 'N', 'G'}));
+  EXPECT_FALSE(decoder.Load(MakeGif(2, 2, {})));
+  Bytes header_only = MakeGif(2, 2, {});
+  header_only.resize(8);
+  EXPECT_FALSE(decoder.Load(header_only));
+  EXPECT_FALSE(decoder.IsOpen());
+  EXPECT_FALSE(decoder.Open("/nonexistent/animation.gif"));
+}
+
+} // namespace
+} // namespace terminal_animation
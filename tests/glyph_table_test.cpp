@@ -0,0 +1,69 @@
+#include "glyph_table.hpp"
+
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+namespace terminal_animation {
+namespace {
+
+TEST(GlyphTableTest, MatchesRangeMapping) {
+  const auto last = static_cast<std::uint32_t>(kAsciiDensity.size() - 1);
+  for (std::uint32_t value = 0; value < 256; ++value) {
+    EXPECT_EQ(kDensityGlyphs[value],
+              kAsciiDensity[MapValue(value, 0U, 255U, 0U, last)])
+        << value;
+  }
+}
+
+TEST(GlyphTableTest, SpansTheCharsetFromDenseToSparse) {
+  constexpr GlyphTable binary = MakeGlyphTable("# ");
+  static_assert(binary[0] == '#' && binary[254] == '#' && binary[255] == ' ');
+
+  const GlyphTable custom = MakeGlyphTable("abc");
+  EXPECT_EQ(custom[0], 'a');
+  EXPECT_EQ(custom[127], 'a');
+  EXPECT_EQ(custom[128], 'b');
+  EXPECT_EQ(custom[255], 'c');
+}
+
+TEST(Rec709LuminanceTest, WeightsChannels) {
+  static_assert(Rec709Luminance(0, 0, 0) == 0);
+  static_assert(Rec709Luminance(255, 255, 255) == 255);
+  EXPECT_EQ(Rec709Luminance(255, 0, 0), 54);
+  EXPECT_EQ(Rec709Luminance(0, 255, 0), 182);
+  EXPECT_EQ(Rec709Luminance(0, 0, 255), 18);
+  for (std::uint32_t gray = 0; gray < 256; ++gray) {
+    EXPECT_EQ(Rec709Luminance(gray, gray, gray), gray);
+  }
+}
+
+TEST(ParseCharsetTest, AcceptsBuiltinNames) {
+  for (const BuiltinCharset &charset : kBuiltinCharsets) {
+    EXPECT_EQ(ParseCharset(charset.name), charset.table) << charset.name;
+  }
+  EXPECT_EQ(ParseCharset("density"), kDensityGlyphs);
+}
+
+TEST(ParseCharsetTest, CompilesCustomCharsets) {
+  EXPECT_EQ(ParseCharset("@. "), MakeGlyphTable("@. "));
+  EXPECT_EQ(ParseCharset("  "), MakeGlyphTable("  "));
+}
+
+TEST(ParseCharsetTest, RejectsUnusableCharsets) {
+  EXPECT_FALSE(ParseCharset("").has_value());
+  EXPECT_FALSE(ParseCharset("#").has_value());
+  EXPECT_FALSE(ParseCharset("#\t").has_value());
+  EXPECT_FALSE(ParseCharset("#\xc3\xa9").has_value());
+}
+
+TEST(GlyphTableTest, SelectsTheActiveTable) {
+  EXPECT_EQ(GetGlyphTable(), kDensityGlyphs);
+  SetGlyphTable(MakeGlyphTable("# "));
+  EXPECT_EQ(GetGlyphTable()[0], '#');
+  SetGlyphTable(kDensityGlyphs);
+  EXPECT_EQ(GetGlyphTable(), kDensityGlyphs);
+}
+
+} // namespace
+} // namespace terminal_animation
@@ -0,0 +1,90 @@
+#include "image_sequence.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace terminal_animation {
+namespace {
+
+class ImageSequenceTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    directory_ = std::filesystem::temp_directory_path() /
+                 "terminal_animation_image_sequence_test";
+    std::filesystem::remove_all(directory_);
+    std::filesystem::create_directories(directory_);
+  }
+
+  void TearDown() override { std::filesystem::remove_all(directory_); }
+
+  void Touch(const std::string &name) {
+    std::ofstream(directory_ / name) << "x";
+  }
+
+  std::vector<std::string> Names(const std::filesystem::path &source) {
+    std::vector<std::string> names;
+    for (const auto &path : FindImageSequence(source)) {
+      names.push_back(path.filename().string());
+    }
+    return names;
+  }
+
+  std::filesystem::path directory_;
+};
+
+TEST(IsImageSequencePatternTest, RecognizesFrameNumberConversions) {
+  EXPECT_TRUE(IsImageSequencePattern("renders/frame_%05d.png"));
+  EXPECT_TRUE(IsImageSequencePattern("%d.jpg"));
+  EXPECT_FALSE(IsImageSequencePattern("frame_00001.png"));
+  EXPECT_FALSE(IsImageSequencePattern("frame_%s.png"));
+  // Space padding cannot be matched against file names.
+  EXPECT_FALSE(IsImageSequencePattern("frame_%5d.png"));
+  // Only the file name is a pattern.
+  EXPECT_FALSE(IsImageSequencePattern("take_%d/frame.png"));
+}
+
+TEST(NaturalLessTest, ComparesDigitRunsByValue) {
+  EXPECT_TRUE(NaturalLess("frame_9.png", "frame_10.png"));
+  EXPECT_FALSE(NaturalLess("frame_10.png", "frame_9.png"));
+  EXPECT_TRUE(NaturalLess("a2b3", "a2b10"));
+  EXPECT_TRUE(NaturalLess("frame", "frame_1"));
+  EXPECT_TRUE(NaturalLess("a.png", "b.png"));
+  // Equal values stay strictly ordered.
+  EXPECT_NE(NaturalLess("frame_01", "frame_1"),
+            NaturalLess("frame_1", "frame_01"));
+  EXPECT_FALSE(NaturalLess("frame_1", "frame_1"));
+}
+
+TEST_F(ImageSequenceTest, PlaysDirectoryImagesInNaturalOrder) {
+  for (const char *name : {"10.png", "9.jpg", "1.png", "notes.txt"}) {
+    Touch(name);
+  }
+  std::filesystem::create_directories(directory_ / "sub.png");
+
+  EXPECT_EQ(Names(directory_),
+            (std::vector<std::string>{"1.png", "9.jpg", "10.png"}));
+}
+
+TEST_F(ImageSequenceTest, MatchesPatternFrames) {
+  for (const char *name :
+       {"frame_00002.png", "frame_00010.png", "frame_00001.png",
+        "frame_123456.png", "frame_12.png", "frame_0000x.png",
+        "other_00003.png", "frame_00004.jpg"}) {
+    Touch(name);
+  }
+
+  EXPECT_EQ(Names(directory_ / "frame_%05d.png"),
+            (std::vector<std::string>{"frame_00001.png", "frame_00002.png",
+                                      "frame_00010.png",
+                                      "frame_123456.png"}));
+  EXPECT_EQ(Names(directory_ / "frame_%d.png").size(), 5u);
+  EXPECT_TRUE(Names(directory_ / "missing_%d.png").empty());
+  EXPECT_TRUE(Names(directory_ / "frame_00001.png").empty());
+}
+
+} // namespace
+} // namespace terminal_animation
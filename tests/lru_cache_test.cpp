@@ -0,0 +1,79 @@
+#include "lru_cache.hpp"
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace terminal_animation {
+namespace {
+
+TEST(LruCacheTest, ReturnsNullForMissingKey) {
+  LruCache<std::string, int> cache(2);
+  EXPECT_EQ(cache.Get("a"), nullptr);
+}
+
+TEST(LruCacheTest, StoresAndReturnsValues) {
+  LruCache<std::string, int> cache(2);
+  cache.Put("a", 1);
+  ASSERT_NE(cache.Get("a"), nullptr);
+  EXPECT_EQ(*cache.Get("a"), 1);
+}
+
+TEST(LruCacheTest, EvictsLeastRecentlyUsed) {
+  LruCache<std::string, int> cache(2);
+  cache.Put("a", 1);
+  cache.Put("b", 2);
+  cache.Get("a");
+  cache.Put("c", 3);
+
+  EXPECT_TRUE(cache.Contains("a"));
+  EXPECT_FALSE(cache.Contains("b"));
+  EXPECT_TRUE(cache.Contains("c"));
+}
+
+TEST(LruCacheTest, EvictsByCost) {
+  LruCache<int, int> cache(100);
+  cache.Put(1, 1, 40);
+  cache.Put(2, 2, 40);
+  cache.Put(3, 3, 40);
+
+  EXPECT_FALSE(cache.Contains(1));
+  EXPECT_EQ(cache.TotalCost(), 80u);
+}
+
+TEST(LruCacheTest, KeepsOversizedNewestEntry) {
+  LruCache<int, int> cache(10);
+  cache.Put(1, 1, 5);
+  cache.Put(2, 2, 50);
+
+  EXPECT_FALSE(cache.Contains(1));
+  EXPECT_TRUE(cache.Contains(2));
+  EXPECT_EQ(cache.Size(), 1u);
+}
+
+TEST(LruCacheTest, ReplacingUpdatesCost) {
+  LruCache<int, int> cache(100);
+  cache.Put(1, 1, 30);
+  cache.Put(1, 2, 10);
+
+  EXPECT_EQ(cache.Size(), 1u);
+  EXPECT_EQ(cache.TotalCost(), 10u);
+  EXPECT_EQ(*cache.Get(1), 2);
+}
+
+TEST(LruCacheTest, EraseAndShrinkingBudget) {
+  LruCache<int, int> cache(3);
+  cache.Put(1, 1);
+  cache.Put(2, 2);
+  cache.Put(3, 3);
+
+  EXPECT_TRUE(cache.Erase(2));
+  EXPECT_FALSE(cache.Erase(2));
+
+  cache.SetBudget(1);
+  EXPECT_EQ(cache.Size(), 1u);
+  EXPECT_TRUE(cache.Contains(3));
+}
+
+} // namespace
+} // namespace terminal_animation
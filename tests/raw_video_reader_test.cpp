@@ -0,0 +1,148 @@
+#include "raw_video_reader.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace terminal_animation {
+namespace {
+
+// A frame whose bytes are all value.
+std::string MakeFrame(std::uint64_t size, char value) {
+  return std::string(static_cast<std::size_t>(size), value);
+}
+
+std::filesystem::path WriteFile(const std::string &name,
+                                const std::string &contents) {
+  auto path = std::filesystem::temp_directory_path() / name;
+  std::ofstream file(path, std::ios::binary);
+  file << contents;
+  return path;
+}
+
+TEST(GetRawFrameSizeTest, CountsPlanes) {
+  EXPECT_EQ(GetRawFrameSize(RawPixelFormat::kI420, 640, 360), 345600u);
+  EXPECT_EQ(GetRawFrameSize(RawPixelFormat::kI444, 4, 2), 24u);
+  EXPECT_EQ(GetRawFrameSize(RawPixelFormat::kGray, 4, 2), 8u);
+  EXPECT_EQ(GetRawFrameSize(RawPixelFormat::kBgr, 4, 2), 24u);
+}
+
+TEST(ParseY4mTest, FindsFramesWithAndWithoutParameters) {
+  const std::string header = "YUV4MPEG2 W4 H2 F30000:1001 Ip A1:1 C420jpeg\n";
+  const std::string frame = MakeFrame(12, 'a');
+  const std::string data = header + "FRAME\n" + frame + "FRAME Ixyz\n" +
+                           frame + "FRAME\n" + frame.substr(0, 5);
+
+  const auto layout = ParseY4m(data);
+  ASSERT_TRUE(layout.has_value());
+  EXPECT_EQ(layout->width, 4u);
+  EXPECT_EQ(layout->height, 2u);
+  EXPECT_EQ(layout->fps_numerator, 30000u);
+  EXPECT_EQ(layout->fps_denominator, 1001u);
+  EXPECT_EQ(layout->format, RawPixelFormat::kI420);
+  // The truncated third frame is dropped.
+  const std::uint64_t first = header.size() + 6;
+  EXPECT_EQ(layout->frame_offsets,
+            (std::vector<std::uint64_t>{first, first + 12 + 11}));
+}
+
+TEST(ParseY4mTest, ReadsOtherColorSpaces) {
+  const auto mono = ParseY4m("YUV4MPEG2 W3 H3 Cmono\nFRAME\n" +
+                             MakeFrame(9, 'm'));
+  ASSERT_TRUE(mono.has_value());
+  EXPECT_EQ(mono->format, RawPixelFormat::kGray);
+  EXPECT_EQ(mono->frame_offsets.size(), 1u);
+
+  const auto full = ParseY4m("YUV4MPEG2 W2 H2 C444\n");
+  ASSERT_TRUE(full.has_value());
+  EXPECT_EQ(full->format, RawPixelFormat::kI444);
+  EXPECT_TRUE(full->frame_offsets.empty());
+
+  for (const char *name : {"420", "420jpeg", "420paldv", "420mpeg2"}) {
+    const auto layout =
+        ParseY4m(std::string("YUV4MPEG2 W2 H2 C") + name + "\n");
+    ASSERT_TRUE(layout.has_value()) << name;
+    EXPECT_EQ(layout->format, RawPixelFormat::kI420) << name;
+  }
+}
+
+TEST(ParseY4mTest, RejectsMalformedHeaders) {
+  EXPECT_FALSE(ParseY4m("YUV4MPEG W4 H2\n").has_value());
+  EXPECT_FALSE(ParseY4m("YUV4MPEG2 W4\n").has_value());
+  EXPECT_FALSE(ParseY4m("YUV4MPEG2 W4 H2 C422\n").has_value());
+  // High bit depth stores two bytes per sample.
+  EXPECT_FALSE(ParseY4m("YUV4MPEG2 W4 H2 C420p10\n").has_value());
+  EXPECT_FALSE(ParseY4m("YUV4MPEG2 W4 H2 C420p16\n").has_value());
+  // 4:2:0 with odd dimensions.
+  EXPECT_FALSE(ParseY4m("YUV4MPEG2 W3 H2\n").has_value());
+  // No end of line.
+  EXPECT_FALSE(ParseY4m("YUV4MPEG2 W4 H2").has_value());
+}
+
+TEST(ParseRawVideoNameTest, ReadsDimensionsAndFramerate) {
+  const auto layout = ParseRawVideoName("clip_64x36_25fps.bgr",
+                                        2 * 64 * 36 * 3 + 10);
+  ASSERT_TRUE(layout.has_value());
+  EXPECT_EQ(layout->width, 64u);
+  EXPECT_EQ(layout->height, 36u);
+  EXPECT_EQ(layout->fps_numerator, 25u);
+  EXPECT_EQ(layout->format, RawPixelFormat::kBgr);
+  EXPECT_EQ(layout->frame_offsets,
+            (std::vector<std::uint64_t>{0, 64 * 36 * 3}));
+
+  const auto yuv = ParseRawVideoName("Capture-1280x720.YUV", 1382400);
+  ASSERT_TRUE(yuv.has_value());
+  EXPECT_EQ(yuv->format, RawPixelFormat::kI420);
+  EXPECT_EQ(yuv->fps_numerator, 30u);
+  EXPECT_EQ(yuv->frame_offsets.size(), 1u);
+}
+
+TEST(ParseRawVideoNameTest, RejectsNamesWithoutLayout) {
+  EXPECT_FALSE(ParseRawVideoName("clip.yuv", 1000).has_value());
+  EXPECT_FALSE(ParseRawVideoName("clip_3x2.yuv", 1000).has_value());
+  EXPECT_FALSE(ParseRawVideoName("clip_64x36.txt", 1000).has_value());
+}
+
+#if defined(__linux__) || defined(__APPLE__)
+
+TEST(RawVideoReaderTest, ReturnsFramesInPlace) {
+  const auto path = WriteFile(
+      "terminal_animation_raw_video_test.y4m",
+      "YUV4MPEG2 W2 H2 Cmono\nFRAME\n" + MakeFrame(4, '\x01') + "FRAME\n" +
+          MakeFrame(4, '\x02') + "FRAME\n" + MakeFrame(4, '\x03'));
+
+  RawVideoReader reader;
+  ASSERT_TRUE(reader.Open(path));
+  EXPECT_EQ(reader.GetFrameCount(), 3u);
+  EXPECT_EQ(reader.GetLayout().format, RawPixelFormat::kGray);
+  // Any frame, in any order.
+  ASSERT_NE(reader.GetFrame(2), nullptr);
+  EXPECT_EQ(reader.GetFrame(2)[3], 3);
+  EXPECT_EQ(reader.GetFrame(0)[0], 1);
+  EXPECT_EQ(reader.GetFrame(1) - reader.GetFrame(0), 4 + 6);
+  EXPECT_EQ(reader.GetFrame(3), nullptr);
+
+  reader.Close();
+  EXPECT_FALSE(reader.IsOpen());
+  EXPECT_EQ(reader.GetFrame(0), nullptr);
+  std::filesystem::remove(path);
+}
+
+TEST(RawVideoReaderTest, RejectsFilesWithoutFrames) {
+  RawVideoReader reader;
+  EXPECT_FALSE(reader.Open("/nonexistent/clip_4x2.bgr"));
+
+  const auto path =
+      WriteFile("terminal_animation_raw_video_test_64x36.bgr", "short");
+  EXPECT_FALSE(reader.Open(path));
+  EXPECT_FALSE(reader.IsOpen());
+  std::filesystem::remove(path);
+}
+
+#endif
+
+} // namespace
+} // namespace terminal_animation
@@ -0,0 +1,95 @@
+#include "recent_sessions.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <optional>
+
+#include <gtest/gtest.h>
+
+namespace terminal_animation {
+namespace {
+
+using namespace std::chrono_literals;
+
+const std::filesystem::file_time_type kModified{1000s};
+
+// A budget of 100 for at most 4 sessions: every session costs at least 25.
+RecentSessions<int> MakeSessions() { return {100, 4}; }
+
+TEST(RecentSessionsTest, ResumesUnmodifiedFile) {
+  auto sessions = MakeSessions();
+  EXPECT_TRUE(sessions.Park("a.mp4", 7, kModified, 10));
+  EXPECT_TRUE(sessions.Contains("a.mp4"));
+
+  EXPECT_EQ(sessions.Take("a.mp4", kModified), 7);
+  // Taking hands the session over.
+  EXPECT_FALSE(sessions.Contains("a.mp4"));
+  EXPECT_EQ(sessions.Take("a.mp4", kModified), std::nullopt);
+}
+
+TEST(RecentSessionsTest, ModifiedFileIsReopened) {
+  auto sessions = MakeSessions();
+  sessions.Park("a.mp4", 7, kModified, 10);
+  EXPECT_EQ(sessions.Take("a.mp4", kModified + 1s), std::nullopt);
+  // The stale session is dropped, not kept for later.
+  EXPECT_FALSE(sessions.Contains("a.mp4"));
+  EXPECT_EQ(sessions.TotalCost(), 0U);
+
+  sessions.Park("b.mp4", 8, kModified, 10);
+  // The file can no longer be read.
+  EXPECT_EQ(sessions.Take("b.mp4", std::nullopt), std::nullopt);
+  EXPECT_FALSE(sessions.Contains("b.mp4"));
+}
+
+TEST(RecentSessionsTest, SmallSessionsCostTheFloor) {
+  auto sessions = MakeSessions();
+  EXPECT_EQ(sessions.Cost(0), 25U);
+  EXPECT_EQ(sessions.Cost(40), 40U);
+
+  for (const char *file : {"a", "b", "c", "d", "e"}) {
+    sessions.Park(file, 0, kModified, 1);
+  }
+  // The floor bounds the number of sessions, oldest out first.
+  EXPECT_EQ(sessions.Size(), 4U);
+  EXPECT_EQ(sessions.TotalCost(), 100U);
+  EXPECT_FALSE(sessions.Contains("a"));
+  EXPECT_TRUE(sessions.Contains("b"));
+  EXPECT_TRUE(sessions.Contains("e"));
+}
+
+TEST(RecentSessionsTest, EvictsLeastRecentlyParkedFirst) {
+  auto sessions = MakeSessions();
+  sessions.Park("a", 0, kModified, 1);
+  sessions.Park("b", 0, kModified, 1);
+  sessions.Park("c", 0, kModified, 1);
+  // Re-parking a file makes it the most recent again.
+  sessions.Park("a", 0, kModified, 1);
+  // 60 evicts the two least recent sessions of 25: b, then c.
+  sessions.Park("d", 0, kModified, 60);
+
+  EXPECT_TRUE(sessions.Contains("a"));
+  EXPECT_FALSE(sessions.Contains("b"));
+  EXPECT_FALSE(sessions.Contains("c"));
+  EXPECT_TRUE(sessions.Contains("d"));
+  EXPECT_EQ(sessions.TotalCost(), 85U);
+}
+
+TEST(RecentSessionsTest, SessionLargerThanBudgetIsNotKept) {
+  auto sessions = MakeSessions();
+  sessions.Park("a", 0, kModified, 1);
+  EXPECT_TRUE(sessions.Park("full", 0, kModified, 100));
+  EXPECT_FALSE(sessions.Contains("a"));
+
+  EXPECT_FALSE(sessions.Park("b", 0, kModified, 101));
+  EXPECT_FALSE(sessions.Contains("b"));
+  // Nothing else is evicted for it.
+  EXPECT_TRUE(sessions.Contains("full"));
+
+  // Parking a file again replaces its session, even if the new one is
+  // dropped.
+  EXPECT_FALSE(sessions.Park("full", 0, kModified, 500));
+  EXPECT_EQ(sessions.Size(), 0U);
+}
+
+} // namespace
+} // namespace terminal_animation
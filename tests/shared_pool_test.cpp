@@ -0,0 +1,76 @@
+#include "allocation_counter.hpp"
+#include "shared_pool.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace terminal_animation {
+namespace {
+
+TEST(SharedPoolTest, ReusesReleasedObjects) {
+  SharedPool<std::vector<char>> pool;
+  std::vector<char> *first = pool.Acquire().get();
+  EXPECT_EQ(pool.Acquire().get(), first);
+  EXPECT_EQ(pool.Size(), 1U);
+}
+
+TEST(SharedPoolTest, DoesNotHandOutObjectsInUse) {
+  SharedPool<std::vector<char>> pool;
+  auto first = pool.Acquire();
+  auto copy = first;
+  auto second = pool.Acquire();
+  EXPECT_NE(first.get(), second.get());
+  EXPECT_EQ(pool.Size(), 2U);
+
+  first.reset();
+  // copy still refers to the first object.
+  EXPECT_NE(pool.Acquire().get(), copy.get());
+}
+
+TEST(SharedPoolTest, KeepsContentsAndCapacity) {
+  SharedPool<std::vector<char>> pool;
+  pool.Acquire()->assign(1000, 'x');
+  auto reused = pool.Acquire();
+  EXPECT_GE(reused->capacity(), 1000U);
+}
+
+TEST(SharedPoolTest, SteadyStateDoesNotAllocate) {
+  if (!kCountsAllocations) {
+    GTEST_SKIP() << "Allocations are only counted in debug builds";
+  }
+
+  SharedPool<std::vector<char>> pool;
+  const std::vector<char> source(4096, 'a');
+  std::shared_ptr<const std::vector<char>> shown;
+  const auto show_frame = [&] {
+    auto buffer = pool.Acquire();
+    buffer->assign(source.begin(), source.end());
+    shown = std::move(buffer);
+  };
+
+  // Warm up: the pool grows to the number of buffers in flight.
+  for (int i = 0; i < 4; ++i) {
+    show_frame();
+  }
+  const std::uint64_t before = ThreadAllocationCount();
+  for (int i = 0; i < 100; ++i) {
+    show_frame();
+  }
+  EXPECT_EQ(ThreadAllocationCount(), before);
+  EXPECT_TRUE(std::equal(shown->begin(), shown->end(), source.begin()));
+}
+
+TEST(AllocationCounterTest, CountsAllocations) {
+  if (!kCountsAllocations) {
+    GTEST_SKIP() << "Allocations are only counted in debug builds";
+  }
+  const std::uint64_t before = ThreadAllocationCount();
+  auto value = std::make_unique<int>(1);
+  EXPECT_EQ(ThreadAllocationCount(), before + 1);
+}
+
+} // namespace
+} // namespace terminal_animation
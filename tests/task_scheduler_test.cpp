@@ -0,0 +1,159 @@
+#include "task_scheduler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace terminal_animation {
+namespace {
+
+using namespace std::chrono_literals;
+
+TEST(TaskSchedulerTest, RunsSubmittedTasks) {
+  TaskScheduler scheduler({.worker_count = 4});
+  std::atomic<int> runs{0};
+  std::vector<TaskHandle> handles;
+  for (int i = 0; i < 100; ++i) {
+    handles.push_back(
+        scheduler.Submit(TaskPriority::kLookAhead, [&runs] { ++runs; }));
+  }
+  for (const auto &handle : handles) {
+    handle.Wait();
+  }
+  EXPECT_EQ(runs.load(), 100);
+}
+
+TEST(TaskSchedulerTest, RunsMoreUrgentTasksFirst) {
+  TaskScheduler scheduler({.worker_count = 1});
+  std::mutex mutex;
+  std::vector<TaskPriority> order;
+
+  // Keep the only worker busy while the other tasks are queued.
+  std::atomic<bool> release{false};
+  auto blocker = scheduler.Submit(TaskPriority::kVisibleFrame, [&release] {
+    while (!release.load()) {
+      std::this_thread::sleep_for(1ms);
+    }
+  });
+
+  std::vector<TaskHandle> handles;
+  for (const auto priority :
+       {TaskPriority::kThumbnail, TaskPriority::kPrefetch,
+        TaskPriority::kLookAhead, TaskPriority::kVisibleFrame}) {
+    handles.push_back(scheduler.Submit(priority, [&, priority] {
+      std::lock_guard<std::mutex> lock(mutex);
+      order.push_back(priority);
+    }));
+  }
+  release.store(true);
+  for (const auto &handle : handles) {
+    handle.Wait();
+  }
+
+  EXPECT_EQ(order, (std::vector<TaskPriority>{
+                       TaskPriority::kVisibleFrame, TaskPriority::kLookAhead,
+                       TaskPriority::kPrefetch, TaskPriority::kThumbnail}));
+}
+
+TEST(TaskSchedulerTest, IdleWorkersStealNestedTasks) {
+  TaskScheduler scheduler({.worker_count = 4});
+  std::atomic<int> concurrent{0};
+  std::atomic<int> max_concurrent{0};
+  std::vector<TaskHandle> children;
+  std::mutex mutex;
+
+  // Tasks submitted from a worker land on that worker's own deque; the
+  // others must steal them to run them in parallel.
+  scheduler
+      .Submit(TaskPriority::kLookAhead,
+              [&] {
+                for (int i = 0; i < 8; ++i) {
+                  auto child = scheduler.Submit(TaskPriority::kLookAhead, [&] {
+                    const int now = ++concurrent;
+                    int seen = max_concurrent.load();
+                    while (now > seen &&
+                           !max_concurrent.compare_exchange_weak(seen, now)) {
+                    }
+                    std::this_thread::sleep_for(20ms);
+                    --concurrent;
+                  });
+                  std::lock_guard<std::mutex> lock(mutex);
+                  children.push_back(std::move(child));
+                }
+              })
+      .Wait();
+
+  std::lock_guard<std::mutex> lock(mutex);
+  for (const auto &child : children) {
+    child.Wait();
+  }
+  EXPECT_GT(max_concurrent.load(), 1);
+}
+
+TEST(TaskSchedulerTest, CancelledTaskDoesNotRun) {
+  TaskScheduler scheduler({.worker_count = 1});
+  std::atomic<bool> release{false};
+  scheduler.Submit(TaskPriority::kVisibleFrame, [&release] {
+    while (!release.load()) {
+      std::this_thread::sleep_for(1ms);
+    }
+  });
+
+  std::atomic<bool> ran{false};
+  auto handle =
+      scheduler.Submit(TaskPriority::kLookAhead, [&ran] { ran.store(true); });
+  EXPECT_TRUE(handle.Cancel());
+  EXPECT_TRUE(handle.IsDone());
+  release.store(true);
+
+  // A task queued after the cancelled one has run once this one finishes.
+  scheduler.Submit(TaskPriority::kThumbnail, [] {}).Wait();
+  EXPECT_FALSE(ran.load());
+}
+
+TEST(TaskSchedulerTest, DelayedTaskWaitsForItsTime) {
+  TaskScheduler scheduler({.worker_count = 2});
+  const auto start = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::time_point ran_at;
+  scheduler
+      .SubmitAt(start + 50ms, TaskPriority::kVisibleFrame,
+                [&ran_at] { ran_at = std::chrono::steady_clock::now(); })
+      .Wait();
+  EXPECT_GE(ran_at - start, 50ms);
+}
+
+TEST(TaskSchedulerTest, DestructorCancelsPendingDelayedTasks) {
+  TaskHandle handle;
+  std::atomic<bool> ran{false};
+  {
+    TaskScheduler scheduler({.worker_count = 1});
+    handle = scheduler.SubmitAt(std::chrono::steady_clock::now() + 1h,
+                                TaskPriority::kThumbnail,
+                                [&ran] { ran.store(true); });
+  }
+  handle.Wait();
+  EXPECT_TRUE(handle.IsDone());
+  EXPECT_FALSE(ran.load());
+}
+
+TEST(TaskSchedulerTest, PinnedWorkersRunTasks) {
+  TaskScheduler scheduler({.worker_count = 2, .pin_workers = true});
+  std::atomic<bool> ran{false};
+  scheduler.Submit(TaskPriority::kVisibleFrame, [&ran] { ran.store(true); })
+      .Wait();
+  EXPECT_TRUE(ran.load());
+}
+
+TEST(TaskHandleTest, EmptyHandleIsDone) {
+  TaskHandle handle;
+  EXPECT_TRUE(handle.IsDone());
+  EXPECT_TRUE(handle.Cancel());
+  handle.Wait();
+}
+
+} // namespace
+} // namespace terminal_animation
@@ -0,0 +1,114 @@
+#include "temporal_filter.hpp"
+
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+namespace terminal_animation {
+namespace {
+
+// "abc": 'a' is drawn for 0-127, 'b' for 128-254 and 'c' for 255.
+const GlyphTable kAbc = MakeGlyphTable("abc");
+
+CharsAndColors MakeFrame(std::uint32_t columns, std::uint32_t rows,
+                         char glyph) {
+  return {.columns = columns,
+          .rows = rows,
+          .colors = {},
+          .chars = std::vector<char>(columns * rows, glyph)};
+}
+
+TEST(TemporalFilterTest, HoldsGlyphNearItsBand) {
+  const CharsAndColors previous = MakeFrame(1, 1, 'a');
+  const TemporalFilter filter(kAbc, previous, 8);
+  EXPECT_EQ(filter.FilterGlyph(0, 0), 'a');
+  EXPECT_EQ(filter.FilterGlyph(0, 127), 'a');
+  // Inside 'b''s band, but within the threshold of 'a''s.
+  EXPECT_EQ(filter.FilterGlyph(0, 135), 'a');
+  EXPECT_EQ(filter.FilterGlyph(0, 136), 'b');
+  EXPECT_EQ(filter.FilterGlyph(0, 255), 'c');
+}
+
+TEST(TemporalFilterTest, HysteresisWorksInBothDirections) {
+  const CharsAndColors previous = MakeFrame(1, 1, 'b');
+  const TemporalFilter filter(kAbc, previous, 8);
+  EXPECT_EQ(filter.FilterGlyph(0, 120), 'b');
+  EXPECT_EQ(filter.FilterGlyph(0, 119), 'a');
+  EXPECT_EQ(filter.FilterGlyph(0, 255), 'b');
+}
+
+TEST(TemporalFilterTest, ZeroThresholdMatchesTheTable) {
+  const CharsAndColors previous = MakeFrame(1, 1, 'b');
+  const TemporalFilter filter(kDensityGlyphs, previous, 0);
+  for (std::uint32_t value = 0; value < 256; ++value) {
+    EXPECT_EQ(filter.FilterGlyph(0, static_cast<std::uint8_t>(value)),
+              kDensityGlyphs[value])
+        << value;
+  }
+}
+
+TEST(TemporalFilterTest, GlyphOutsideTheTableIsReplaced) {
+  const CharsAndColors previous = MakeFrame(1, 1, 'z');
+  const TemporalFilter filter(kAbc, previous, 255);
+  EXPECT_EQ(filter.FilterGlyph(0, 0), 'a');
+  EXPECT_EQ(filter.FilterGlyph(0, 255), 'c');
+}
+
+TEST(TemporalFilterTest, HoldsColorWithinThresholdOnEveryChannel) {
+  CharsAndColors previous = MakeFrame(2, 1, 'a');
+  previous.colors = {{100, 100, 100}, {0, 255, 10}};
+  const TemporalFilter filter(kAbc, previous, 4);
+  EXPECT_TRUE(filter.HoldsColor(0, 104, 96, 100));
+  EXPECT_FALSE(filter.HoldsColor(0, 105, 100, 100));
+  EXPECT_FALSE(filter.HoldsColor(0, 100, 100, 95));
+  EXPECT_TRUE(filter.HoldsColor(1, 4, 251, 14));
+  EXPECT_FALSE(filter.HoldsColor(1, 0, 250, 10));
+}
+
+TEST(CountChangedCellsTest, ComparesGlyphsAndColors) {
+  CharsAndColors previous = MakeFrame(3, 1, 'a');
+  previous.colors.assign(3, {1, 2, 3});
+  CharsAndColors current = previous;
+  EXPECT_EQ(CountChangedCells(previous, current), 0U);
+  current.chars[0] = 'b';
+  current.colors[2] = {1, 2, 4};
+  EXPECT_EQ(CountChangedCells(previous, current), 2U);
+
+  // A resize redraws everything.
+  EXPECT_EQ(CountChangedCells(MakeFrame(2, 1, 'a'), current), 3U);
+}
+
+TEST(EstimateDeltaBytesTest, CountsCursorMovesColorsAndGlyphs) {
+  const CharsAndColors previous = MakeFrame(12, 2, 'a');
+  EXPECT_EQ(EstimateDeltaBytes(previous, previous), 0U);
+
+  CharsAndColors current = previous;
+  // One run of two cells: "\x1b[1;2H" and two glyphs.
+  current.chars[1] = 'b';
+  current.chars[2] = 'b';
+  EXPECT_EQ(EstimateDeltaBytes(previous, current), 6U + 2U);
+  // A second run in row 2, column 12: "\x1b[2;12H" and a glyph.
+  current.chars[23] = 'c';
+  EXPECT_EQ(EstimateDeltaBytes(previous, current), 8U + 7U + 1U);
+}
+
+TEST(EstimateDeltaBytesTest, SendsColorsOnlyWhenTheyChange) {
+  CharsAndColors previous = MakeFrame(3, 1, 'a');
+  previous.colors.assign(3, {0, 0, 0});
+  CharsAndColors current = previous;
+  current.colors = {{255, 0, 0}, {255, 0, 0}, {7, 0, 0}};
+  // "\x1b[1;1H", "\x1b[38;2;255;0;0m", two glyphs, "\x1b[38;2;7;0;0m" and
+  // a glyph.
+  EXPECT_EQ(EstimateDeltaBytes(previous, current),
+            6U + 15U + 2U + 13U + 1U);
+}
+
+TEST(StabilizeThresholdTest, DefaultsToOff) {
+  EXPECT_EQ(GetStabilizeThreshold(), 0);
+  SetStabilizeThreshold(16);
+  EXPECT_EQ(GetStabilizeThreshold(), 16);
+  SetStabilizeThreshold(0);
+}
+
+} // namespace
+} // namespace terminal_animation
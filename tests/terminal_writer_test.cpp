@@ -0,0 +1,177 @@
+#include "terminal_writer.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace terminal_animation {
+namespace {
+
+// Records what is written. While held, writes block, like a terminal that
+// stopped reading.
+class SlowTerminal {
+public:
+  TerminalWriter::Sink Sink() {
+    return [this](std::string_view data) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      is_blocked_ = is_held_;
+      cv_.notify_all();
+      cv_.wait(lock, [this] { return !is_held_; });
+      is_blocked_ = false;
+      writes_.emplace_back(data);
+    };
+  }
+
+  void Hold() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_held_ = true;
+  }
+
+  // Waits until a write blocks on the hold.
+  void WaitUntilBlocked() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return is_blocked_; });
+  }
+
+  void Release() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      is_held_ = false;
+    }
+    cv_.notify_all();
+  }
+
+  std::string GetOutput() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string output;
+    for (const std::string &write : writes_) {
+      output += write;
+    }
+    return output;
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool is_held_ = false;
+  bool is_blocked_ = false;
+  std::vector<std::string> writes_;
+};
+
+void WriteFrame(TerminalWriter &writer, std::ostream &out,
+                std::string_view frame, std::uint32_t columns = 80) {
+  writer.BeginFrame(columns, 24);
+  out << frame << std::flush;
+}
+
+TEST(TerminalWriterTest, WritesFlushedOutputInOrder) {
+  SlowTerminal terminal;
+  TerminalWriter writer(terminal.Sink());
+  std::ostream out(&writer);
+
+  out << "ab" << 'c' << std::flush;
+  out << "d";
+  writer.Drain();
+  EXPECT_EQ(terminal.GetOutput(), "abc");
+
+  out << std::flush;
+  writer.Drain();
+  EXPECT_EQ(terminal.GetOutput(), "abcd");
+}
+
+TEST(TerminalWriterTest, WritesRemainingOutputWhenDestroyed) {
+  SlowTerminal terminal;
+  {
+    TerminalWriter writer(terminal.Sink());
+    std::ostream out(&writer);
+    out << "restore terminal";
+  }
+  EXPECT_EQ(terminal.GetOutput(), "restore terminal");
+}
+
+TEST(TerminalWriterTest, ReplacesWaitingFrameWithNewerOne) {
+  SlowTerminal terminal;
+  TerminalWriter writer(terminal.Sink());
+  std::ostream out(&writer);
+
+  terminal.Hold();
+  out << "[setup]" << std::flush;
+  terminal.WaitUntilBlocked();
+  // The first frame at a size is always kept.
+  WriteFrame(writer, out, "[1]");
+  WriteFrame(writer, out, "[2]");
+  WriteFrame(writer, out, "[3]");
+  WriteFrame(writer, out, "[4]");
+  terminal.Release();
+  writer.Drain();
+
+  EXPECT_EQ(terminal.GetOutput(), "[setup][1][4]");
+  EXPECT_EQ(writer.GetStats().frames_replaced, 2U);
+}
+
+TEST(TerminalWriterTest, KeepsFramesBehindOtherOutput) {
+  SlowTerminal terminal;
+  TerminalWriter writer(terminal.Sink());
+  std::ostream out(&writer);
+
+  terminal.Hold();
+  WriteFrame(writer, out, "[1]");
+  WriteFrame(writer, out, "[2]");
+  out << "[mode]" << std::flush;
+  WriteFrame(writer, out, "[3]");
+  // Output before the frame in the same flush keeps the waiting frame.
+  out << "[dsr]";
+  WriteFrame(writer, out, "[4]");
+  terminal.Release();
+  writer.Drain();
+
+  EXPECT_EQ(terminal.GetOutput(), "[1][2][mode][3][dsr][4]");
+  EXPECT_EQ(writer.GetStats().frames_replaced, 0U);
+}
+
+TEST(TerminalWriterTest, KeepsFramesAcrossResizes) {
+  SlowTerminal terminal;
+  TerminalWriter writer(terminal.Sink());
+  std::ostream out(&writer);
+
+  terminal.Hold();
+  out << "[setup]" << std::flush;
+  terminal.WaitUntilBlocked();
+  WriteFrame(writer, out, "[1]", 80);
+  WriteFrame(writer, out, "[2]", 80);
+  WriteFrame(writer, out, "[3]", 100);
+  WriteFrame(writer, out, "[4]", 100);
+  WriteFrame(writer, out, "[5]", 100);
+  terminal.Release();
+  writer.Drain();
+
+  EXPECT_EQ(terminal.GetOutput(), "[setup][1][2][3][5]");
+}
+
+TEST(TerminalWriterTest, MeasuresWrites) {
+  TerminalWriter writer([](std::string_view) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  });
+  std::ostream out(&writer);
+
+  out << "12345" << std::flush;
+  writer.Drain();
+  out << "678" << std::flush;
+  writer.Drain();
+
+  const TerminalWriter::Stats stats = writer.GetStats();
+  EXPECT_EQ(stats.bytes_written, 8U);
+  EXPECT_EQ(stats.writes, 2U);
+  EXPECT_GE(stats.longest_write, std::chrono::milliseconds(5));
+  EXPECT_GE(stats.write_time, std::chrono::milliseconds(10));
+}
+
+} // namespace
+} // namespace terminal_animation